@@ -0,0 +1,557 @@
+// ========================================
+// SCRIPTED APP CENTRAL (BABBLESIM)
+// ========================================
+// Plays the phone App against the Host in a BabbleSim run: finds the Host
+// by name, discovers TMT1, subscribes to RSSI data and presence, sends
+// START and checks what an App would see. One test per scenario:
+//
+//   connect_stream  connect, stream, check the sample rate
+//   walk_away       the tag leaves and returns (walk_away.txt attenuation)
+//   reconnect       drop and re-establish the App link several times
+//
+// Each test ends in PASS or FAIL (the process exit status) and prints
+// APP,<scenario>,<metric>=<value> lines for run_scenarios.sh.
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bstests.h"
+
+// TMT1 UUIDs, commands and pass limits come from the Host sources
+#include "ble_service.h"
+#include "host_metrics.h"
+
+#define HOST_NAME               "MIPE_HOST_A1B2"
+
+#define TEST_TIMEOUT_S          120     // Hard limit per scenario (simulated)
+#define CONNECT_TIMEOUT_MS      10000
+#define GATT_TIMEOUT_MS         5000
+#define FIRST_NOTIFY_LIMIT_MS   HOST_METRICS_MAX_DISCOVERY_MS
+#define STREAM_MS               30000
+
+// Must match scenarios/walk_away.txt: the tag fades out from 20 s and is
+// back in range at 50 s
+#define WALK_AWAY_START_MS      20000
+#define WALK_AWAY_RETURN_MS     50000
+#define WALK_AWAY_ABSENT_LIMIT_MS   15000
+
+#define RECONNECT_CYCLES        3
+#define RECONNECT_HOLD_MS       5000
+#define RECONNECT_LIMIT_MS      1000    // Fast re-advertising phase (app_reconnect.h)
+
+extern enum bst_result_t bst_result;
+
+#define FAIL(...)                                       \
+    do {                                                \
+        bst_result = Failed;                            \
+        bs_trace_error_time_line(__VA_ARGS__);          \
+    } while (0)
+
+#define PASS(...)                                       \
+    do {                                                \
+        bst_result = Passed;                            \
+        bs_trace_info_time(1, __VA_ARGS__);             \
+    } while (0)
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct bt_conn *host_conn;
+static bt_addr_le_t host_addr;
+
+static K_SEM_DEFINE(found_sem, 0, 1);
+static K_SEM_DEFINE(connected_sem, 0, 1);
+static K_SEM_DEFINE(disconnected_sem, 0, 1);
+static K_SEM_DEFINE(gatt_sem, 0, 1);
+static K_SEM_DEFINE(presence_sem, 0, 1);
+
+static uint16_t rssi_handle;
+static uint16_t control_handle;
+static uint16_t presence_handle;
+static uint8_t gatt_err;
+
+static struct bt_gatt_discover_params discover_params;
+static struct bt_gatt_subscribe_params rssi_sub;
+static struct bt_gatt_subscribe_params presence_sub;
+static struct bt_gatt_write_params write_params;
+
+static atomic_t notifications;
+static uint32_t first_notify_at;
+static uint32_t absent_at;              // Last presence event per state
+static uint32_t present_at;
+
+// ========================================
+// SCANNING AND CONNECTION
+// ========================================
+
+static bool match_name(struct bt_data *data, void *user_data)
+{
+    bool *found = user_data;
+
+    if (data->type == BT_DATA_NAME_COMPLETE && data->data_len == strlen(HOST_NAME) &&
+        memcmp(data->data, HOST_NAME, data->data_len) == 0) {
+        *found = true;
+        return false;
+    }
+    return true;
+}
+
+static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
+                         struct net_buf_simple *ad)
+{
+    bool found = false;
+
+    if (type != BT_GAP_ADV_TYPE_ADV_IND && type != BT_GAP_ADV_TYPE_EXT_ADV) {
+        return;
+    }
+
+    bt_data_parse(ad, match_name, &found);
+    if (found && bt_le_scan_stop() == 0) {
+        bt_addr_le_copy(&host_addr, addr);
+        k_sem_give(&found_sem);
+    }
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    if (err) {
+        bt_conn_unref(host_conn);
+        host_conn = NULL;
+        printk("Connection failed (err 0x%02x)\n", err);
+        return;
+    }
+    k_sem_give(&connected_sem);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    if (conn != host_conn) {
+        return;
+    }
+    bt_conn_unref(host_conn);
+    host_conn = NULL;
+    printk("Disconnected (reason 0x%02x)\n", reason);
+    k_sem_give(&disconnected_sem);
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+};
+
+/**
+ * Scan for the Host and connect
+ * @param latency_ms Call to connection (may be NULL)
+ * @return 0 on success, negative error code otherwise
+ */
+static int connect_host(uint32_t *latency_ms)
+{
+    uint32_t start = k_uptime_get_32();
+    int err;
+
+    k_sem_reset(&found_sem);
+    k_sem_reset(&connected_sem);
+
+    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, device_found);
+    if (err) {
+        return err;
+    }
+    if (k_sem_take(&found_sem, K_MSEC(CONNECT_TIMEOUT_MS))) {
+        bt_le_scan_stop();
+        return -ETIMEDOUT;
+    }
+
+    err = bt_conn_le_create(&host_addr, BT_CONN_LE_CREATE_CONN, BT_LE_CONN_PARAM_DEFAULT,
+                            &host_conn);
+    if (err) {
+        return err;
+    }
+    if (k_sem_take(&connected_sem, K_MSEC(CONNECT_TIMEOUT_MS)) || host_conn == NULL) {
+        return -ETIMEDOUT;
+    }
+
+    if (latency_ms) {
+        *latency_ms = k_uptime_get_32() - start;
+    }
+    return 0;
+}
+
+static int disconnect_host(void)
+{
+    k_sem_reset(&disconnected_sem);
+
+    int err = bt_conn_disconnect(host_conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+    if (err) {
+        return err;
+    }
+    return k_sem_take(&disconnected_sem, K_MSEC(CONNECT_TIMEOUT_MS)) ? -ETIMEDOUT : 0;
+}
+
+// ========================================
+// GATT CLIENT
+// ========================================
+
+static uint8_t discover_func(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                             struct bt_gatt_discover_params *params)
+{
+    if (attr == NULL) {
+        k_sem_give(&gatt_sem);
+        return BT_GATT_ITER_STOP;
+    }
+
+    const struct bt_gatt_chrc *chrc = attr->user_data;
+
+    if (bt_uuid_cmp(chrc->uuid, &rssi_data_uuid.uuid) == 0) {
+        rssi_handle = chrc->value_handle;
+    } else if (bt_uuid_cmp(chrc->uuid, &control_uuid.uuid) == 0) {
+        control_handle = chrc->value_handle;
+    } else if (bt_uuid_cmp(chrc->uuid, &presence_uuid.uuid) == 0) {
+        presence_handle = chrc->value_handle;
+    }
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static uint8_t rssi_notify(struct bt_conn *conn, struct bt_gatt_subscribe_params *params,
+                           const void *data, uint16_t length)
+{
+    if (data == NULL) {
+        // Unsubscribed (link dropped)
+        params->value_handle = 0;
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (atomic_inc(&notifications) == 0) {
+        first_notify_at = k_uptime_get_32();
+    }
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static uint8_t presence_notify(struct bt_conn *conn, struct bt_gatt_subscribe_params *params,
+                               const void *data, uint16_t length)
+{
+    if (data == NULL) {
+        params->value_handle = 0;
+        return BT_GATT_ITER_STOP;
+    }
+
+    // [tag_id][present][timeout u16][addr 6]
+    const uint8_t *event = data;
+
+    if (length >= 2) {
+        if (event[1]) {
+            present_at = k_uptime_get_32();
+        } else {
+            absent_at = k_uptime_get_32();
+        }
+        printk("Tag %u %s\n", event[0], event[1] ? "present" : "absent");
+        k_sem_give(&presence_sem);
+    }
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static void write_func(struct bt_conn *conn, uint8_t err, struct bt_gatt_write_params *params)
+{
+    gatt_err = err;
+    k_sem_give(&gatt_sem);
+}
+
+/**
+ * Subscribe to a TMT1 characteristic (its CCC directly follows the value)
+ */
+static int subscribe(struct bt_gatt_subscribe_params *params, uint16_t value_handle,
+                     bt_gatt_notify_func_t notify)
+{
+    params->notify = notify;
+    params->value = BT_GATT_CCC_NOTIFY;
+    params->value_handle = value_handle;
+    params->ccc_handle = value_handle + 1;
+
+    int err = bt_gatt_subscribe(host_conn, params);
+    return err == -EALREADY ? 0 : err;
+}
+
+/**
+ * Discover TMT1, subscribe to RSSI data and presence, send START
+ * @return 0 on success, negative error code otherwise
+ */
+static int start_stream(void)
+{
+    static const uint8_t cmd = CMD_START_STREAM;
+    int err;
+
+    rssi_handle = control_handle = presence_handle = 0;
+    k_sem_reset(&gatt_sem);
+
+    discover_params.uuid = NULL;
+    discover_params.func = discover_func;
+    discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+    discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+    discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+
+    err = bt_gatt_discover(host_conn, &discover_params);
+    if (err) {
+        return err;
+    }
+    if (k_sem_take(&gatt_sem, K_MSEC(GATT_TIMEOUT_MS))) {
+        return -ETIMEDOUT;
+    }
+    if (!rssi_handle || !control_handle || !presence_handle) {
+        return -ENOENT;
+    }
+
+    err = subscribe(&rssi_sub, rssi_handle, rssi_notify);
+    if (!err) {
+        err = subscribe(&presence_sub, presence_handle, presence_notify);
+    }
+    if (err) {
+        return err;
+    }
+
+    write_params.func = write_func;
+    write_params.handle = control_handle;
+    write_params.offset = 0;
+    write_params.data = &cmd;
+    write_params.length = sizeof(cmd);
+
+    err = bt_gatt_write(host_conn, &write_params);
+    if (err) {
+        return err;
+    }
+    if (k_sem_take(&gatt_sem, K_MSEC(GATT_TIMEOUT_MS))) {
+        return -ETIMEDOUT;
+    }
+    return gatt_err ? -EIO : 0;
+}
+
+/**
+ * Connect and start streaming, failing the test on any error
+ * @return Connection latency in ms
+ */
+static uint32_t connect_and_stream(void)
+{
+    uint32_t latency_ms = 0;
+    int err;
+
+    err = connect_host(&latency_ms);
+    if (err) {
+        FAIL("Host not connected (err %d)\n", err);
+        return 0;
+    }
+
+    atomic_clear(&notifications);
+    first_notify_at = 0;
+
+    err = start_stream();
+    if (err) {
+        FAIL("TMT1 setup failed (err %d)\n", err);
+    }
+    return latency_ms;
+}
+
+/**
+ * Wait for the first RSSI notification after a START
+ * @return Delay from start in ms, UINT32_MAX on timeout
+ */
+static uint32_t wait_first_notify(uint32_t start)
+{
+    while (k_uptime_get_32() - start < FIRST_NOTIFY_LIMIT_MS) {
+        if (atomic_get(&notifications) > 0) {
+            return first_notify_at - start;
+        }
+        k_sleep(K_MSEC(10));
+    }
+    return UINT32_MAX;
+}
+
+// ========================================
+// SCENARIOS
+// ========================================
+
+static void test_init(void)
+{
+    bst_ticker_set_next_tick_absolute(TEST_TIMEOUT_S * 1000000ULL);
+    bst_result = In_progress;
+}
+
+static void test_tick(bs_time_t HW_device_time)
+{
+    if (bst_result != Passed) {
+        FAIL("Test did not finish within %u s\n", TEST_TIMEOUT_S);
+    }
+}
+
+static int bt_start(void)
+{
+    int err = bt_enable(NULL);
+    if (err) {
+        FAIL("Bluetooth init failed (err %d)\n", err);
+    }
+    return err;
+}
+
+static void test_connect_stream(void)
+{
+    if (bt_start()) {
+        return;
+    }
+
+    uint32_t connect_ms = connect_and_stream();
+    uint32_t start = k_uptime_get_32();
+    if (bst_result == Failed) {
+        return;
+    }
+
+    uint32_t first_ms = wait_first_notify(start);
+    printk("APP,connect_stream,connect_ms=%u\n", connect_ms);
+    printk("APP,connect_stream,first_notify_ms=%u\n", first_ms);
+    if (first_ms == UINT32_MAX) {
+        FAIL("No RSSI notification within %u ms\n", FIRST_NOTIFY_LIMIT_MS);
+        return;
+    }
+
+    atomic_clear(&notifications);
+    k_sleep(K_MSEC(STREAM_MS));
+
+    uint32_t per_s_x10 = (uint32_t)atomic_get(&notifications) * 10000U / STREAM_MS;
+    printk("APP,connect_stream,samples_per_s_x10=%u\n", per_s_x10);
+    if (per_s_x10 < HOST_METRICS_MIN_SAMPLES_PER_S_X10) {
+        FAIL("RSSI rate %u < %u (x10 /s)\n", per_s_x10, HOST_METRICS_MIN_SAMPLES_PER_S_X10);
+        return;
+    }
+
+    PASS("connect_stream passed\n");
+}
+
+static void test_walk_away(void)
+{
+    if (bt_start()) {
+        return;
+    }
+
+    connect_and_stream();
+    if (bst_result == Failed) {
+        return;
+    }
+
+    // Tag out of range: presence must drop
+    while (absent_at < WALK_AWAY_START_MS) {
+        if (k_uptime_get_32() > WALK_AWAY_START_MS + WALK_AWAY_ABSENT_LIMIT_MS) {
+            FAIL("Tag not reported absent after the walk away\n");
+            return;
+        }
+        k_sem_take(&presence_sem, K_MSEC(100));
+    }
+    printk("APP,walk_away,absent_ms=%u\n", absent_at - WALK_AWAY_START_MS);
+
+    // Back in range: presence and the stream must recover
+    while (present_at < absent_at) {
+        if (k_uptime_get_32() > WALK_AWAY_RETURN_MS + HOST_METRICS_MAX_DISCOVERY_MS) {
+            FAIL("Tag not rediscovered within %u ms\n", HOST_METRICS_MAX_DISCOVERY_MS);
+            return;
+        }
+        k_sem_take(&presence_sem, K_MSEC(100));
+    }
+    printk("APP,walk_away,rediscovery_ms=%u\n",
+           present_at > WALK_AWAY_RETURN_MS ? present_at - WALK_AWAY_RETURN_MS : 0);
+
+    atomic_clear(&notifications);
+    uint32_t resume_ms = wait_first_notify(k_uptime_get_32());
+    printk("APP,walk_away,resume_ms=%u\n", resume_ms);
+    if (resume_ms == UINT32_MAX) {
+        FAIL("RSSI stream did not resume\n");
+        return;
+    }
+
+    PASS("walk_away passed\n");
+}
+
+static void test_reconnect(void)
+{
+    if (bt_start()) {
+        return;
+    }
+
+    connect_and_stream();
+    if (bst_result == Failed) {
+        return;
+    }
+
+    for (int cycle = 1; cycle <= RECONNECT_CYCLES; cycle++) {
+        k_sleep(K_MSEC(RECONNECT_HOLD_MS));
+
+        int err = disconnect_host();
+        if (err) {
+            FAIL("Disconnect failed (err %d)\n", err);
+            return;
+        }
+
+        uint32_t connect_ms = connect_and_stream();
+        uint32_t start = k_uptime_get_32();
+        if (bst_result == Failed) {
+            return;
+        }
+
+        uint32_t first_ms = wait_first_notify(start);
+        printk("APP,reconnect,cycle=%d,connect_ms=%u,first_notify_ms=%u\n",
+               cycle, connect_ms, first_ms);
+        if (connect_ms > RECONNECT_LIMIT_MS) {
+            FAIL("Reconnect took %u ms (limit %u)\n", connect_ms, RECONNECT_LIMIT_MS);
+            return;
+        }
+        if (first_ms == UINT32_MAX) {
+            FAIL("No RSSI notification after reconnect\n");
+            return;
+        }
+    }
+
+    PASS("reconnect passed\n");
+}
+
+static const struct bst_test_instance app_central_tests[] = {
+    {
+        .test_id = "connect_stream",
+        .test_descr = "Connect, stream and check the RSSI sample rate",
+        .test_post_init_f = test_init,
+        .test_tick_f = test_tick,
+        .test_main_f = test_connect_stream,
+    },
+    {
+        .test_id = "walk_away",
+        .test_descr = "Tag leaves and returns: presence and stream recover",
+        .test_post_init_f = test_init,
+        .test_tick_f = test_tick,
+        .test_main_f = test_walk_away,
+    },
+    {
+        .test_id = "reconnect",
+        .test_descr = "Drop and re-establish the App link",
+        .test_post_init_f = test_init,
+        .test_tick_f = test_tick,
+        .test_main_f = test_reconnect,
+    },
+    BSTEST_END_MARKER
+};
+
+static struct bst_test_list *app_central_install(struct bst_test_list *tests)
+{
+    return bst_add_tests(tests, app_central_tests);
+}
+
+bst_test_install_t test_installers[] = {
+    app_central_install,
+    NULL
+};
+
+int main(void)
+{
+    bst_main();
+    return 0;
+}
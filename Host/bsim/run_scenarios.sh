@@ -0,0 +1,124 @@
+#!/usr/bin/env bash
+# ========================================
+# BABBLESIM SYSTEM TEST: HOST + MIPE + SCRIPTED APP
+# ========================================
+#   Host/bsim/run_scenarios.sh [scenario...]     (default: all)
+#
+# Builds the Host, the Mipe tag and the scripted App central
+# (app_central/) for nrf54l15bsim and runs each scenario on a simulated
+# 2.4 GHz channel:
+#
+#   connect_stream  all devices 50 dB apart
+#   walk_away       Host-Mipe attenuation from scenarios/walk_away.txt
+#   reconnect       all devices 50 dB apart, the App drops its link
+#
+# A scenario fails if the App central fails (its exit status) or the Host
+# logs a METRICS FAIL line (limits in host_metrics.h). The script exits
+# non-zero if any scenario failed.
+#
+# Needs Linux, west, ZEPHYR_BASE and a BabbleSim install (BSIM_OUT_PATH,
+# BSIM_COMPONENTS_PATH), as set up by Zephyr's BabbleSim instructions.
+
+set -u
+
+BOARD=nrf54l15bsim/nrf54l15/cpuapp
+HERE=$(cd "$(dirname "$0")" && pwd)
+REPO=$(cd "${HERE}/../.." && pwd)
+OUT=${OUT:-${HERE}/_out}
+SIM_ID=mipe_$$
+SIM_LENGTH_S=${SIM_LENGTH_S:-100}
+
+: "${ZEPHYR_BASE:?ZEPHYR_BASE is not set}"
+: "${BSIM_OUT_PATH:?BSIM_OUT_PATH is not set}"
+: "${BSIM_COMPONENTS_PATH:?BSIM_COMPONENTS_PATH is not set}"
+
+SCENARIOS=("$@")
+if [ ${#SCENARIOS[@]} -eq 0 ]; then
+    SCENARIOS=(connect_stream walk_away reconnect)
+fi
+
+# ========================================
+# BUILD
+# ========================================
+
+build() {
+    local name=$1 src=$2
+    echo "Building ${name}"
+    west build -b "${BOARD}" -d "${OUT}/build_${name}" "${src}" -p auto > "${OUT}/build_${name}.log" 2>&1 ||
+        { echo "Build of ${name} failed, see ${OUT}/build_${name}.log"; exit 1; }
+}
+
+mkdir -p "${OUT}"
+build host "${REPO}/Host/host_device"
+build mipe "${REPO}/Mipe"
+build app "${HERE}/app_central"
+
+HOST_EXE=${OUT}/build_host/zephyr/zephyr.exe
+MIPE_EXE=${OUT}/build_mipe/zephyr/zephyr.exe
+APP_EXE=${OUT}/build_app/zephyr/zephyr.exe
+
+# ========================================
+# RUN
+# ========================================
+
+# Device numbers: Host 0, Mipe 1, App 2
+channel_args() {
+    local scenario=$1 dir=$2
+    case ${scenario} in
+    walk_away)
+        printf '0 1 : "%s"\n1 0 : "%s"\n' \
+            "${HERE}/scenarios/walk_away.txt" "${HERE}/scenarios/walk_away.txt" > "${dir}/att.txt"
+        echo "-channel=multiatt -argschannel -at=50 -file=${dir}/att.txt -argsmain"
+        ;;
+    *)
+        echo "-channel=multiatt -argschannel -at=50 -argsmain"
+        ;;
+    esac
+}
+
+run_scenario() {
+    local scenario=$1
+    local dir=${OUT}/${scenario}
+    local id=${SIM_ID}_${scenario}
+    local app_status
+
+    mkdir -p "${dir}"
+    echo "Running ${scenario}"
+
+    # The phy looks up its channel and modem libraries relative to its bin directory
+    (cd "${BSIM_OUT_PATH}/bin" &&
+        ./bs_2G4_phy_v1 -s="${id}" -D=3 -sim_length=$((SIM_LENGTH_S * 1000000)) \
+            $(channel_args "${scenario}" "${dir}") > "${dir}/phy.log" 2>&1) &
+    local phy_pid=$!
+
+    "${HOST_EXE}" -s="${id}" -d=0 -rs=1 > "${dir}/host.log" 2>&1 &
+    local host_pid=$!
+    "${MIPE_EXE}" -s="${id}" -d=1 -rs=2 > "${dir}/mipe.log" 2>&1 &
+    local mipe_pid=$!
+    "${APP_EXE}" -s="${id}" -d=2 -rs=3 -testid="${scenario}" > "${dir}/app.log" 2>&1
+    app_status=$?
+
+    wait "${host_pid}" "${mipe_pid}" "${phy_pid}"
+
+    grep "APP," "${dir}/app.log" | sed 's/^.*APP,/  APP,/'
+    grep "METRICS discovery_ms=.*rediscovery_ms=" "${dir}/host.log" | tail -n 1 | sed 's/^.*METRICS/  METRICS/'
+
+    if [ ${app_status} -ne 0 ]; then
+        echo "  FAIL: App central (see ${dir}/app.log)"
+        return 1
+    fi
+    if grep -q "METRICS FAIL" "${dir}/host.log"; then
+        grep "METRICS FAIL" "${dir}/host.log" | sort -u | sed 's/^.*METRICS FAIL/  FAIL: Host/'
+        return 1
+    fi
+    echo "  PASS"
+    return 0
+}
+
+failed=0
+for scenario in "${SCENARIOS[@]}"; do
+    run_scenario "${scenario}" || failed=$((failed + 1))
+done
+
+echo "${#SCENARIOS[@]} scenario(s), ${failed} failed"
+[ ${failed} -eq 0 ]
@@ -0,0 +1,271 @@
+#include "app_reconnect.h"
+#include "host_energy.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/bluetooth/gap.h>
+#include <errno.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(app_reconnect, LOG_LEVEL_INF);
+
+// Directed high duty cycle events are at most 3.75 ms apart
+#define DIRECTED_EVENT_US       3750
+
+// The old connection object is freed shortly after the disconnected callback;
+// until then advertising cannot start and the start is retried
+#define RECYCLE_WAIT_MS         500
+
+enum policy_state {
+    POLICY_IDLE,
+    POLICY_PENDING,             // Armed, advertising starts from the main loop
+    POLICY_DIRECTED,
+    POLICY_FAST,
+};
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct k_spinlock lock;
+static struct app_reconnect_stats stats;
+static const uint32_t bucket_edges[] = APP_RECONNECT_BUCKETS;
+
+static const struct bt_data *fast_ad;
+static size_t fast_ad_len;
+
+static enum policy_state state = POLICY_IDLE;
+static bt_addr_le_t peer_addr;
+static bool peer_bonded = false;
+static bool directed_timed_out = false;
+static uint32_t phase_start = 0;
+static uint32_t disconnected_at = 0;    // 0 = no reconnection pending
+
+BUILD_ASSERT(ARRAY_SIZE(bucket_edges) == APP_RECONNECT_BUCKET_COUNT - 1);
+
+// ========================================
+// ADVERTISING PHASES
+// ========================================
+
+static int start_directed(void)
+{
+    // High duty cycle: no advertising data, the controller stops after 1.28 s
+    struct bt_le_adv_param param = BT_LE_ADV_PARAM_INIT(
+        BT_LE_ADV_OPT_CONN | BT_LE_ADV_OPT_USE_IDENTITY, 0, 0,
+        &peer_addr);
+    int err = bt_le_adv_start(&param, NULL, 0, NULL, 0);
+
+    if (err == 0) {
+        host_energy_set(HOST_ENERGY_ADVERTISING, true, DIRECTED_EVENT_US);
+    }
+    return err;
+}
+
+static int start_fast(void)
+{
+    struct bt_le_adv_param param = BT_LE_ADV_PARAM_INIT(
+        BT_LE_ADV_OPT_CONN | BT_LE_ADV_OPT_USE_IDENTITY,
+        APP_RECONNECT_FAST_INT_MIN, APP_RECONNECT_FAST_INT_MAX, NULL);
+    int err = bt_le_adv_start(&param, fast_ad, fast_ad_len, NULL, 0);
+
+    if (err == 0) {
+        host_energy_set(HOST_ENERGY_ADVERTISING, true,
+                        BT_GAP_ADV_INTERVAL_TO_US(APP_RECONNECT_FAST_INT_MIN));
+    }
+    return err;
+}
+
+static void stop_advertising(void)
+{
+    bt_le_adv_stop();
+    host_energy_set(HOST_ENERGY_ADVERTISING, false, 0);
+}
+
+/**
+ * Move from one state to the next unless a connection ended the policy meanwhile
+ * @return true if the transition happened
+ */
+static bool commit(enum policy_state from, enum policy_state to, uint32_t now)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    bool ok = state == from;
+
+    if (ok) {
+        state = to;
+        phase_start = now;
+    }
+    k_spin_unlock(&lock, key);
+    return ok;
+}
+
+/**
+ * Check whether a failed start should be retried on the next pass
+ */
+static bool retry_start(int err, enum policy_state from, uint32_t now)
+{
+    return err == -ENOMEM && from == POLICY_PENDING &&
+           now - disconnected_at < RECYCLE_WAIT_MS;
+}
+
+/**
+ * Enter the fast phase; on failure hand back to normal advertising
+ * @return true if the caller must start normal advertising
+ */
+static bool enter_fast(enum policy_state from, uint32_t now)
+{
+    int err = start_fast();
+
+    if (retry_start(err, from, now)) {
+        return false;
+    }
+    if (err) {
+        LOG_ERR("Fast advertising failed to start: %d", err);
+        stats.start_errors++;
+        return commit(from, POLICY_IDLE, now);
+    }
+
+    if (!commit(from, POLICY_FAST, now)) {
+        stop_advertising();
+        return false;
+    }
+    LOG_INF("Reconnect: fast advertising for %u ms", APP_RECONNECT_FAST_MS);
+    return false;
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+void app_reconnect_init(const struct bt_data *ad, size_t ad_len)
+{
+    fast_ad = ad;
+    fast_ad_len = ad_len;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void app_reconnect_on_disconnected(const bt_addr_le_t *peer, bool bonded, uint32_t now)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    bt_addr_le_copy(&peer_addr, peer);
+    peer_bonded = bonded;
+    directed_timed_out = false;
+    disconnected_at = MAX(now, 1U);
+    state = POLICY_PENDING;
+    k_spin_unlock(&lock, key);
+}
+
+void app_reconnect_on_connected(uint32_t now)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (disconnected_at == 0) {
+        // First connection since boot
+        state = POLICY_IDLE;
+        k_spin_unlock(&lock, key);
+        return;
+    }
+
+    enum app_reconnect_phase phase = state == POLICY_DIRECTED ? APP_RECONNECT_DIRECTED :
+                                     state == POLICY_FAST ? APP_RECONNECT_FAST :
+                                     APP_RECONNECT_SLOW;
+    uint32_t latency = now - disconnected_at;
+    int bucket = 0;
+
+    while (bucket < ARRAY_SIZE(bucket_edges) && latency >= bucket_edges[bucket]) {
+        bucket++;
+    }
+
+    stats.reconnects[phase]++;
+    stats.histogram[phase][bucket]++;
+    stats.total_ms += latency;
+    stats.max_ms = MAX(stats.max_ms, latency);
+    disconnected_at = 0;
+    state = POLICY_IDLE;
+    k_spin_unlock(&lock, key);
+
+    LOG_INF("RECONNECT,%s,%u", app_reconnect_phase_name(phase), latency);
+}
+
+void app_reconnect_on_directed_timeout(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    directed_timed_out = true;
+    k_spin_unlock(&lock, key);
+}
+
+bool app_reconnect_process(uint32_t now)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    enum policy_state current = state;
+    bool timed_out = directed_timed_out;
+    k_spin_unlock(&lock, key);
+
+    // A connection callback may end the policy at any point: commit() checks
+    switch (current) {
+    case POLICY_PENDING:
+        if (peer_bonded) {
+            int err = start_directed();
+            if (err == 0) {
+                if (!commit(POLICY_PENDING, POLICY_DIRECTED, now)) {
+                    stop_advertising();
+                } else {
+                    LOG_INF("Reconnect: directed advertising to the bonded App");
+                }
+                return false;
+            }
+            if (retry_start(err, POLICY_PENDING, now)) {
+                return false;
+            }
+            LOG_WRN("Directed advertising failed to start: %d", err);
+            stats.start_errors++;
+        }
+        return enter_fast(POLICY_PENDING, now);
+
+    case POLICY_DIRECTED:
+        if (!timed_out &&
+            now - phase_start < APP_RECONNECT_DIRECTED_MS + APP_RECONNECT_DIRECTED_MARGIN) {
+            return false;
+        }
+        stats.directed_timeouts++;
+        // Normally already stopped by the controller
+        stop_advertising();
+        return enter_fast(POLICY_DIRECTED, now);
+
+    case POLICY_FAST:
+        if (now - phase_start < APP_RECONNECT_FAST_MS ||
+            !commit(POLICY_FAST, POLICY_IDLE, now)) {
+            return false;
+        }
+        stop_advertising();
+        LOG_INF("Reconnect: App not back after %u ms, normal advertising",
+                now - disconnected_at);
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool app_reconnect_is_active(void)
+{
+    return state != POLICY_IDLE;
+}
+
+void app_reconnect_get_stats(struct app_reconnect_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = stats;
+    k_spin_unlock(&lock, key);
+}
+
+const char *app_reconnect_phase_name(enum app_reconnect_phase phase)
+{
+    switch (phase) {
+    case APP_RECONNECT_DIRECTED:
+        return "directed";
+    case APP_RECONNECT_FAST:
+        return "fast";
+    default:
+        return "slow";
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef APP_RECONNECT_H
+#define APP_RECONNECT_H
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// FAST RECONNECT CONFIGURATION
+// ========================================
+// After an App disconnection the Host advertises in three phases:
+//   1. Directed: a bonded App gets high duty cycle directed advertising
+//      (3.75 ms events), which the controller ends after 1.28 s. A phone
+//      on a private address is matched through its IRK (CONFIG_BT_PRIVACY)
+//   2. Fast: undirected 20-30 ms advertising for APP_RECONNECT_FAST_MS
+//   3. Slow: the normal 100 ms advertising, time-multiplexed with scanning
+// An App that is not bonded starts at the fast phase. The main loop leaves
+// advertising and scanning alone until the policy hands back to phase 3.
+// Every reconnection is logged as RECONNECT,<phase>,<latency_ms> and added
+// to a latency histogram per phase.
+
+// Fast undirected phase
+#define APP_RECONNECT_FAST_MS           30000
+#define APP_RECONNECT_FAST_INT_MIN      0x0020  // 20 ms
+#define APP_RECONNECT_FAST_INT_MAX      0x0030  // 30 ms
+
+// Directed phase length set by the controller, plus margin for its timeout event
+#define APP_RECONNECT_DIRECTED_MS       1280
+#define APP_RECONNECT_DIRECTED_MARGIN   200
+
+// Latency histogram: upper bucket edges in ms (last bucket is everything above)
+#define APP_RECONNECT_BUCKETS           { 100, 200, 500, 1000, 2000, 5000, 10000, 30000 }
+#define APP_RECONNECT_BUCKET_COUNT      9
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Advertising phase that got the App back
+ */
+enum app_reconnect_phase {
+    APP_RECONNECT_DIRECTED,
+    APP_RECONNECT_FAST,
+    APP_RECONNECT_SLOW,
+    APP_RECONNECT_PHASE_COUNT,
+};
+
+/**
+ * Reconnection latency statistics (disconnection to connection)
+ */
+struct app_reconnect_stats {
+    uint32_t reconnects[APP_RECONNECT_PHASE_COUNT];
+    uint32_t histogram[APP_RECONNECT_PHASE_COUNT][APP_RECONNECT_BUCKET_COUNT];
+    uint32_t total_ms;
+    uint32_t max_ms;
+    uint32_t directed_timeouts;     // Directed phases that ended without the App
+    uint32_t start_errors;          // Advertising that failed to start
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Set the advertising data of the fast phase
+ * @param ad Advertising data (must stay valid)
+ * @param ad_len Number of elements in ad
+ */
+void app_reconnect_init(const struct bt_data *ad, size_t ad_len);
+
+/**
+ * Arm the policy after an App disconnection (runs from the next process call)
+ * @param peer App address (identity address when bonded)
+ * @param bonded The App is bonded: start with directed advertising
+ * @param now Current uptime in milliseconds
+ */
+void app_reconnect_on_disconnected(const bt_addr_le_t *peer, bool bonded, uint32_t now);
+
+/**
+ * Record an App connection: ends the policy and logs the latency
+ * @param now Current uptime in milliseconds
+ */
+void app_reconnect_on_connected(uint32_t now);
+
+/**
+ * Record the end of directed advertising without a connection
+ * (connected callback with BT_HCI_ERR_ADV_TIMEOUT)
+ */
+void app_reconnect_on_directed_timeout(void);
+
+/**
+ * Advance the policy (main loop)
+ * @param now Current uptime in milliseconds
+ * @return true once, when the fast phase ended and normal advertising
+ *         should be started by the caller
+ */
+bool app_reconnect_process(uint32_t now);
+
+/**
+ * Check whether the policy owns advertising
+ * @return true during the directed and fast phases
+ */
+bool app_reconnect_is_active(void);
+
+/**
+ * Get reconnection statistics
+ * @param out Destination for the statistics
+ */
+void app_reconnect_get_stats(struct app_reconnect_stats *out);
+
+/**
+ * Name of a phase for logs
+ */
+const char *app_reconnect_phase_name(enum app_reconnect_phase phase);
+
+#endif // APP_RECONNECT_H
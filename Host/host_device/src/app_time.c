@@ -0,0 +1,221 @@
+#include "app_time.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(app_time, LOG_LEVEL_INF);
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Exchange waiting for the App receive time
+ */
+struct pending_exchange {
+    bool valid;
+    uint8_t seq;
+    int64_t t1_us;
+    int64_t t2_us;
+    int64_t t3_us;              // 0 until the response was sent
+};
+
+/**
+ * Completed exchange
+ */
+struct filter_sample {
+    int64_t offset_us;
+    uint32_t delay_us;
+};
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct k_spinlock lock;
+static struct pending_exchange pending[APP_TIME_PENDING];
+static uint8_t pending_next = 0;
+static struct filter_sample samples[APP_TIME_FILTER_SIZE];
+static uint8_t sample_count = 0;
+static uint8_t sample_next = 0;
+static struct app_time_info info;
+
+// ========================================
+// CLOCK FILTER
+// ========================================
+
+/**
+ * Integer square root (for the RMS jitter)
+ */
+static uint32_t isqrt64(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * Select the lowest-delay sample (least affected by queuing) and its jitter
+ * Must be called with the lock held.
+ */
+static void select_offset(void)
+{
+    const struct filter_sample *best = &samples[0];
+    uint64_t sq_sum = 0;
+
+    for (int i = 1; i < sample_count; i++) {
+        if (samples[i].delay_us < best->delay_us) {
+            best = &samples[i];
+        }
+    }
+
+    for (int i = 0; i < sample_count; i++) {
+        int64_t diff = samples[i].offset_us - best->offset_us;
+        sq_sum += (uint64_t)(diff * diff);
+    }
+
+    info.aligned = true;
+    info.offset_us = best->offset_us;
+    info.delay_us = best->delay_us;
+    info.jitter_us = sample_count > 1 ? isqrt64(sq_sum / (sample_count - 1)) : 0;
+}
+
+/**
+ * Complete an exchange with the App receive time
+ * Must be called with the lock held.
+ */
+static void complete_exchange(uint8_t seq, int64_t t4_us)
+{
+    struct pending_exchange *ex = NULL;
+
+    for (int i = 0; i < APP_TIME_PENDING; i++) {
+        if (pending[i].valid && pending[i].seq == seq) {
+            ex = &pending[i];
+            break;
+        }
+    }
+
+    if (!ex || ex->t3_us == 0) {
+        info.rejected++;
+        return;
+    }
+    ex->valid = false;
+
+    // Round trip without the Host turnaround; offset assumes symmetric paths
+    int64_t delay = (t4_us - ex->t1_us) - (ex->t3_us - ex->t2_us);
+    int64_t offset = ((ex->t1_us - ex->t2_us) + (t4_us - ex->t3_us)) / 2;
+
+    if (delay < 0 || delay > APP_TIME_MAX_DELAY_US) {
+        info.rejected++;
+        return;
+    }
+
+    samples[sample_next].offset_us = offset;
+    samples[sample_next].delay_us = (uint32_t)delay;
+    sample_next = (sample_next + 1) % APP_TIME_FILTER_SIZE;
+    sample_count = MIN(sample_count + 1, APP_TIME_FILTER_SIZE);
+
+    info.exchanges++;
+    info.last_update_ms = k_uptime_get_32();
+    select_offset();
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+void app_time_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    memset(pending, 0, sizeof(pending));
+    memset(&info, 0, sizeof(info));
+    sample_count = 0;
+    sample_next = 0;
+    k_spin_unlock(&lock, key);
+}
+
+int64_t app_time_now_us(void)
+{
+    return (int64_t)k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+void app_time_on_request(const uint8_t *payload, int64_t rx_us)
+{
+    uint8_t seq = payload[0];
+    int64_t t1_us = (int64_t)sys_get_le64(&payload[1]);
+    uint8_t prev_seq = payload[9];
+    int64_t prev_t4_us = (int64_t)sys_get_le64(&payload[10]);
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (prev_t4_us != 0) {
+        complete_exchange(prev_seq, prev_t4_us);
+    }
+
+    struct pending_exchange *ex = &pending[pending_next];
+    pending_next = (pending_next + 1) % APP_TIME_PENDING;
+    ex->valid = true;
+    ex->seq = seq;
+    ex->t1_us = t1_us;
+    ex->t2_us = rx_us;
+    ex->t3_us = 0;
+
+    struct app_time_info snapshot = info;
+    k_spin_unlock(&lock, key);
+
+    if (snapshot.aligned && prev_t4_us != 0) {
+        LOG_INF("App time: offset %lld us, delay %u us, jitter %u us (%u exchanges)",
+                snapshot.offset_us, snapshot.delay_us, snapshot.jitter_us,
+                snapshot.exchanges);
+    }
+}
+
+void app_time_on_response_sent(uint8_t seq, int64_t tx_us)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    for (int i = 0; i < APP_TIME_PENDING; i++) {
+        if (pending[i].valid && pending[i].seq == seq) {
+            pending[i].t3_us = tx_us;
+            break;
+        }
+    }
+    k_spin_unlock(&lock, key);
+}
+
+int app_time_host_to_epoch_ms(uint32_t host_ms, int64_t *epoch_ms)
+{
+    int err = -ENODATA;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (info.aligned) {
+        *epoch_ms = ((int64_t)host_ms * 1000 + info.offset_us) / 1000;
+        err = 0;
+    }
+    k_spin_unlock(&lock, key);
+
+    return err;
+}
+
+void app_time_get(struct app_time_info *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = info;
+    k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,95 @@
+#ifndef APP_TIME_H
+#define APP_TIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// APP TIME ALIGNMENT CONFIGURATION
+// ========================================
+// NTP-style exchange over the control characteristic:
+//   App -> Host  CMD_TIME_SYNC: seq, T1 (App send time) and the App receive
+//                time T4 of the previous response
+//   Host -> App  time sync notification: seq, T2 (Host receive), T3 (Host send)
+// App times are phone epoch microseconds, Host times uptime microseconds.
+// The Host completes each exchange with the next request and keeps a
+// filtered epoch offset for timestamping samples.
+
+// Request payload after the command byte:
+// seq (1) + T1 (8, LE) + previous seq (1) + previous T4 (8, LE, 0 = none)
+#define APP_TIME_REQUEST_LEN        18
+
+// Response payload: seq (1) + T2 (8, LE) + T3 (8, LE)
+#define APP_TIME_RESPONSE_LEN       17
+
+// Exchanges awaiting their T4
+#define APP_TIME_PENDING            4
+
+// Clock filter: the offset of the lowest-delay exchange among the last samples
+#define APP_TIME_FILTER_SIZE        8
+
+// Exchanges with a longer round trip are not used
+#define APP_TIME_MAX_DELAY_US       500000
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Time alignment state
+ */
+struct app_time_info {
+    bool aligned;               // At least one usable exchange
+    int64_t offset_us;          // App epoch minus Host uptime
+    uint32_t delay_us;          // Round trip of the selected exchange
+    uint32_t jitter_us;         // RMS offset difference of the filter samples
+    uint32_t exchanges;         // Completed exchanges
+    uint32_t rejected;          // Exchanges dropped (delay out of range or unmatched)
+    uint32_t last_update_ms;    // Host uptime of the latest exchange
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Forget the alignment (App disconnected)
+ */
+void app_time_reset(void);
+
+/**
+ * Current Host uptime in microseconds (the Host side of all exchanges)
+ * @return Uptime in microseconds
+ */
+int64_t app_time_now_us(void);
+
+/**
+ * Handle a time sync request
+ * Completes the previous exchange if the request carries its T4.
+ * @param payload Request payload (APP_TIME_REQUEST_LEN bytes, after the command byte)
+ * @param rx_us Host time at which the request was received (T2)
+ */
+void app_time_on_request(const uint8_t *payload, int64_t rx_us);
+
+/**
+ * Record the transmit time of a response
+ * @param seq Exchange sequence number
+ * @param tx_us Host time just before the response was queued (T3)
+ */
+void app_time_on_response_sent(uint8_t seq, int64_t tx_us);
+
+/**
+ * Convert a Host uptime to App epoch time
+ * @param host_ms Host uptime in milliseconds
+ * @param epoch_ms App epoch time in milliseconds
+ * @return 0 on success, -ENODATA if not aligned
+ */
+int app_time_host_to_epoch_ms(uint32_t host_ms, int64_t *epoch_ms);
+
+/**
+ * Get the alignment state
+ * @param out Destination for the state
+ */
+void app_time_get(struct app_time_info *out);
+
+#endif // APP_TIME_H
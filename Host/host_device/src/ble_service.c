@@ -1,6 +1,10 @@
 #include "ble_service.h"
+#include "app_time.h"
+#include "gatt_bench.h"
+#include "host_trace.h"
 #include <zephyr/logging/log.h>
 #include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
 #include <string.h>
 
 LOG_MODULE_REGISTER(ble_service, LOG_LEVEL_INF);
@@ -14,6 +18,7 @@ extern void handle_start_stream(void);
 extern void handle_stop_stream(void);
 extern void handle_get_status(void);
 extern void handle_mipe_sync(void);
+extern void handle_set_measure_mode(uint8_t mode);
 
 // ========================================
 // GLOBAL VARIABLES
@@ -22,6 +27,15 @@ extern void handle_mipe_sync(void);
 static struct bt_conn *app_conn = NULL;
 static bool app_connected = false;
 
+// RSSI data packet with the epoch timestamp
+#define RSSI_PACKET_MAX 14
+
+// Receive time of the control write being handled (T2 of a time sync)
+static int64_t control_rx_us = 0;
+
+// Append App epoch time to RSSI data (CMD_EPOCH_TIMESTAMPS)
+static bool epoch_timestamps = false;
+
 // ========================================
 // CONTROL COMMAND HANDLER
 // ========================================
@@ -33,6 +47,9 @@ static ssize_t control_write(struct bt_conn *conn,
                             uint16_t offset,
                             uint8_t flags)
 {
+    // Stamp first: logging below would add to the measured turnaround
+    control_rx_us = app_time_now_us();
+
     char addr[BT_ADDR_LE_STR_LEN];
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
     
@@ -53,7 +70,9 @@ static ssize_t control_write(struct bt_conn *conn,
         }
         
         // Handle control command
-        ble_service_handle_control_command(buf, len);
+        host_trace_event(HOST_TRACE_COMMAND, cmd, len);
+        int err = ble_service_handle_control_command(buf, len);
+        host_trace_event(HOST_TRACE_COMMAND_DONE, cmd, err);
         LOG_INF("Command handled successfully");
     } else {
         LOG_WRN("Empty command received");
@@ -122,6 +141,10 @@ static void rssi_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
     LOG_INF("Value: 0x%04x", value);
     LOG_INF("Notifications: %s", (value == BT_GATT_CCC_NOTIFY) ? "ENABLED" : "DISABLED");
     LOG_INF("========================");
+    
+    if (GATT_BENCH_AUTOSTART && value == BT_GATT_CCC_NOTIFY) {
+        gatt_bench_start();
+    }
 }
 
 
@@ -155,6 +178,18 @@ BT_GATT_SERVICE_DEFINE(tmt1_service,
                            BT_GATT_CHRC_NOTIFY,
                            BT_GATT_PERM_NONE,
                            NULL, NULL, NULL),
+    BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    
+    BT_GATT_CHARACTERISTIC(&time_sync_uuid.uuid,
+                           BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_NONE,
+                           NULL, NULL, NULL),
+    BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    
+    BT_GATT_CHARACTERISTIC(&presence_uuid.uuid,
+                           BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_NONE,
+                           NULL, NULL, NULL),
     BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE)
 );
 
@@ -176,28 +211,51 @@ bool ble_service_is_app_connected(void)
     return app_connected;
 }
 
-int ble_service_send_rssi_data(int8_t rssi, uint32_t timestamp)
+/**
+ * Build an RSSI data packet (1 byte RSSI + 3 bytes timestamp + 1 byte tag id + 1 byte PHY
+ * + optional 8 bytes App epoch time)
+ * @return Packet length
+ */
+static uint16_t pack_rssi_data(uint8_t *data, uint8_t tag_id, int8_t rssi, uint32_t timestamp,
+                               uint8_t phy, const int64_t *epoch_ms)
+{
+    data[0] = (uint8_t)rssi;
+    data[1] = (uint8_t)(timestamp & 0xFF);
+    data[2] = (uint8_t)((timestamp >> 8) & 0xFF);
+    data[3] = (uint8_t)((timestamp >> 16) & 0xFF);
+    data[4] = tag_id;
+    data[5] = phy;
+    if (!epoch_ms) {
+        return 6;
+    }
+    sys_put_le64((uint64_t)*epoch_ms, &data[6]);
+    return RSSI_PACKET_MAX;
+}
+
+int ble_service_send_rssi_data(uint8_t tag_id, int8_t rssi, uint32_t timestamp, uint8_t phy)
 {
     if (!app_connected || !app_conn) {
         LOG_ERR("Cannot send RSSI data: not connected");
         return -ENOTCONN;
     }
     
-    // Prepare RSSI data packet (1 byte RSSI + 3 bytes timestamp)
-    uint8_t data[4];
-    data[0] = (uint8_t)rssi;
-    data[1] = (uint8_t)(timestamp & 0xFF);
-    data[2] = (uint8_t)((timestamp >> 8) & 0xFF);
-    data[3] = (uint8_t)((timestamp >> 16) & 0xFF);
+    uint8_t data[RSSI_PACKET_MAX];
+    int64_t epoch_ms;
+    bool with_epoch = epoch_timestamps && app_time_host_to_epoch_ms(timestamp, &epoch_ms) == 0;
+    uint16_t data_len = pack_rssi_data(data, tag_id, rssi, timestamp, phy,
+                                       with_epoch ? &epoch_ms : NULL);
     
     LOG_INF("=== SENDING RSSI DATA ===");
+    LOG_INF("Tag: %u", tag_id);
     LOG_INF("RSSI: %d dBm", rssi);
     LOG_INF("Timestamp: %u ms", timestamp);
-    LOG_INF("Data bytes: [0x%02x, 0x%02x, 0x%02x, 0x%02x]", 
-            data[0], data[1], data[2], data[3]);
+    LOG_INF("PHY: %u", phy);
+    LOG_INF("Data bytes: [0x%02x, 0x%02x, 0x%02x, 0x%02x, 0x%02x, 0x%02x]", 
+            data[0], data[1], data[2], data[3], data[4], data[5]);
     
     // Send notification using the service attribute
-    int err = bt_gatt_notify(app_conn, &tmt1_service.attrs[1], data, sizeof(data));
+    int err = bt_gatt_notify(app_conn, &tmt1_service.attrs[1], data, data_len);
+    host_trace_event(HOST_TRACE_NOTIFY, tag_id, err);
     if (err) {
         LOG_ERR("Failed to send RSSI data: %d", err);
         LOG_ERR("Error details: %s", 
@@ -213,6 +271,73 @@ int ble_service_send_rssi_data(int8_t rssi, uint32_t timestamp)
     return 0;
 }
 
+int ble_service_flood_rssi_data(uint8_t tag_id, int8_t rssi, uint32_t timestamp, uint8_t phy,
+                                bool epoch)
+{
+    if (!app_connected || !app_conn) {
+        return -ENOTCONN;
+    }
+    
+    uint8_t data[RSSI_PACKET_MAX];
+    int64_t epoch_ms = 0;
+    if (epoch) {
+        app_time_host_to_epoch_ms(timestamp, &epoch_ms);
+    }
+    uint16_t data_len = pack_rssi_data(data, tag_id, rssi, timestamp, phy,
+                                       epoch ? &epoch_ms : NULL);
+    
+    int err = bt_gatt_notify(app_conn, &tmt1_service.attrs[1], data, data_len);
+    return err ? err : data_len;
+}
+
+int ble_service_send_time_sync(uint8_t seq, int64_t rx_us)
+{
+    if (!app_connected || !app_conn) {
+        return -ENOTCONN;
+    }
+    
+    uint8_t data[APP_TIME_RESPONSE_LEN];
+    data[0] = seq;
+    sys_put_le64((uint64_t)rx_us, &data[1]);
+    
+    int64_t tx_us = app_time_now_us();
+    sys_put_le64((uint64_t)tx_us, &data[9]);
+    
+    // Time sync characteristic declaration
+    int err = bt_gatt_notify(app_conn, &tmt1_service.attrs[14], data, sizeof(data));
+    if (err) {
+        LOG_ERR("Failed to send time sync response: %d", err);
+        return err;
+    }
+    
+    app_time_on_response_sent(seq, tx_us);
+    return 0;
+}
+
+int ble_service_send_presence(uint8_t tag_id, bool present, const bt_addr_le_t *addr,
+                              uint32_t timeout_ms)
+{
+    if (!app_connected || !app_conn) {
+        return -ENOTCONN;
+    }
+    
+    uint8_t data[10];
+    data[0] = tag_id;
+    data[1] = present ? 1 : 0;
+    sys_put_le16((uint16_t)MIN(timeout_ms, UINT16_MAX), &data[2]);
+    memcpy(&data[4], addr->a.val, 6);
+    
+    // Presence characteristic declaration
+    int err = bt_gatt_notify(app_conn, &tmt1_service.attrs[17], data, sizeof(data));
+    if (err) {
+        LOG_ERR("Failed to send presence event: %d", err);
+        return err;
+    }
+    
+    LOG_DBG("Presence sent: tag %u %s", tag_id, present ? "present" : "absent");
+    return 0;
+}
+
 int ble_service_send_mipe_status(uint8_t connection_state, int8_t rssi,
                                 const uint8_t *device_address, uint32_t connection_duration,
                                 float battery_voltage)
@@ -242,8 +367,8 @@ int ble_service_send_mipe_status(uint8_t connection_state, int8_t rssi,
     // Battery voltage (4 bytes, float, little-endian)
     memcpy(&data[12], &battery_voltage, 4);
     
-    // Send notification using the service attribute
-    int err = bt_gatt_notify(app_conn, &tmt1_service.attrs[7], data, sizeof(data));
+    // Mipe status characteristic declaration
+    int err = bt_gatt_notify(app_conn, &tmt1_service.attrs[8], data, sizeof(data));
     if (err) {
         LOG_ERR("Failed to send Mipe status: %d", err);
         return err;
@@ -264,8 +389,8 @@ int ble_service_send_log_data(const char *log_string)
         return -EINVAL;
     }
     
-    // Send notification using the service attribute
-    int err = bt_gatt_notify(app_conn, &tmt1_service.attrs[9], log_string, strlen(log_string));
+    // Log data characteristic declaration
+    int err = bt_gatt_notify(app_conn, &tmt1_service.attrs[11], log_string, strlen(log_string));
     if (err) {
         LOG_ERR("Failed to send log data: %d", err);
         return err;
@@ -304,6 +429,54 @@ int ble_service_handle_control_command(const uint8_t *data, uint16_t len)
             handle_mipe_sync();
             break;
             
+        case CMD_MEASURE_MODE:
+            if (len < 2) {
+                LOG_WRN("MEASURE MODE command missing mode byte");
+                return -EINVAL;
+            }
+            LOG_INF("Executing MEASURE MODE command");
+            handle_set_measure_mode(data[1]);
+            break;
+            
+        case CMD_TIME_SYNC:
+            if (len < 1 + APP_TIME_REQUEST_LEN) {
+                LOG_WRN("TIME SYNC command too short (%u bytes)", len);
+                return -EINVAL;
+            }
+            app_time_on_request(&data[1], control_rx_us);
+            return ble_service_send_time_sync(data[1], control_rx_us);
+            
+        case CMD_EPOCH_TIMESTAMPS:
+            if (len < 2) {
+                LOG_WRN("EPOCH TIMESTAMPS command missing enable byte");
+                return -EINVAL;
+            }
+            epoch_timestamps = data[1] != 0;
+            LOG_INF("Epoch timestamps %s", epoch_timestamps ? "enabled" : "disabled");
+            break;
+            
+        case CMD_GATT_BENCH:
+            if (len >= 2 && data[1] == 0) {
+                LOG_INF("Aborting GATT benchmark");
+                gatt_bench_stop();
+                break;
+            }
+            LOG_INF("Executing GATT BENCH command");
+            return gatt_bench_start();
+            
+        case CMD_TRACE:
+            if (len >= 2 && data[1] == 0) {
+                LOG_INF("Stopping event trace, dumping buffer");
+                return host_trace_dump();
+            }
+            LOG_INF("Executing TRACE command");
+            return host_trace_start();
+            
+        case CMD_FORGET_BONDS:
+            // Next connection pairs and discovers again (first-connection timing)
+            LOG_INF("Executing FORGET BONDS command");
+            return bt_unpair(BT_ID_DEFAULT, NULL);
+            
         default:
             LOG_WRN("Unknown command: 0x%02x", cmd);
             break;
@@ -316,11 +489,20 @@ int ble_service_handle_control_command(const uint8_t *data, uint16_t len)
 // CONNECTION MANAGEMENT
 // ========================================
 
+struct bt_conn *ble_service_get_app_conn(void)
+{
+    return app_conn;
+}
+
 void ble_service_set_app_conn(struct bt_conn *conn)
 {
     app_conn = conn;
     app_connected = (conn != NULL);
     
+    // A new App session brings a new time base
+    epoch_timestamps = false;
+    app_time_reset();
+    
     if (app_connected) {
         LOG_INF("App connected");
     } else {
@@ -34,6 +34,12 @@
 #define BT_UUID_LOG_DATA_VAL \
     BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef5)
 
+#define BT_UUID_TIME_SYNC_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef6)
+
+#define BT_UUID_PRESENCE_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef7)
+
 // UUID structs for GATT service definition
 static const struct bt_uuid_128 tmt1_service_uuid = BT_UUID_INIT_128(BT_UUID_TMT1_SERVICE_VAL);
 static const struct bt_uuid_128 rssi_data_uuid = BT_UUID_INIT_128(BT_UUID_RSSI_DATA_VAL);
@@ -41,12 +47,24 @@ static const struct bt_uuid_128 control_uuid = BT_UUID_INIT_128(BT_UUID_CONTROL_
 static const struct bt_uuid_128 status_uuid = BT_UUID_INIT_128(BT_UUID_STATUS_VAL);
 static const struct bt_uuid_128 mipe_status_uuid = BT_UUID_INIT_128(BT_UUID_MIPE_STATUS_VAL);
 static const struct bt_uuid_128 log_data_uuid = BT_UUID_INIT_128(BT_UUID_LOG_DATA_VAL);
+static const struct bt_uuid_128 time_sync_uuid = BT_UUID_INIT_128(BT_UUID_TIME_SYNC_VAL);
+static const struct bt_uuid_128 presence_uuid = BT_UUID_INIT_128(BT_UUID_PRESENCE_VAL);
 
 // Control Commands (matching App expectations)
 #define CMD_START_STREAM    0x01
 #define CMD_STOP_STREAM     0x02
 #define CMD_GET_STATUS      0x03
 #define CMD_MIPE_SYNC       0x04
+#define CMD_MEASURE_MODE    0x05    // Payload: 1 byte MEASURE_MODE_*
+#define CMD_TIME_SYNC       0x06    // Payload: APP_TIME_REQUEST_LEN bytes (see app_time.h)
+#define CMD_EPOCH_TIMESTAMPS 0x07   // Payload: 1 byte (1 = append App epoch time to RSSI data)
+#define CMD_GATT_BENCH      0x08    // Payload: 1 byte (1 = start throughput sweep, 0 = abort)
+#define CMD_TRACE           0x09    // Payload: 1 byte (1 = start event trace, 0 = stop and dump)
+#define CMD_FORGET_BONDS    0x0A    // Delete all bonds (the App link drops if bonded)
+
+// Measurement modes for CMD_MEASURE_MODE
+#define MEASURE_MODE_ADVERTISEMENT  0x00    // RSSI from Mipe advertisements
+#define MEASURE_MODE_CONNECTED      0x01    // RSSI sampled on a persistent Mipe link
 
 // ========================================
 // FUNCTION PROTOTYPES
@@ -66,11 +84,52 @@ bool ble_service_is_app_connected(void);
 
 /**
  * Send RSSI data to App
+ * Packet: RSSI (1 byte) + timestamp (3 bytes LE) + tag id (1 byte) + PHY (1 byte),
+ * followed by the App epoch time in ms (8 bytes LE) when epoch timestamps are
+ * enabled and the time base is aligned.
+ * Apps that only read the first 4 bytes keep working.
+ * @param tag_id Id of the Mipe tag the sample belongs to
  * @param rssi RSSI value (-30 to -80 dBm)
  * @param timestamp Timestamp in milliseconds
+ * @param phy PHY the sample was received on (BT_GAP_LE_PHY_*, 0 for link samples)
  * @return 0 on success, negative error code on failure
  */
-int ble_service_send_rssi_data(int8_t rssi, uint32_t timestamp);
+int ble_service_send_rssi_data(uint8_t tag_id, int8_t rssi, uint32_t timestamp, uint8_t phy);
+
+/**
+ * Send RSSI data without logging (throughput benchmark)
+ * Same packet format as ble_service_send_rssi_data().
+ * @param tag_id Tag id field
+ * @param rssi RSSI field
+ * @param timestamp Timestamp field (ms)
+ * @param phy PHY field
+ * @param epoch Append the epoch timestamp (zero if the time base is not aligned)
+ * @return Packet length on success, negative error code on failure (-ENOMEM: no TX buffer)
+ */
+int ble_service_flood_rssi_data(uint8_t tag_id, int8_t rssi, uint32_t timestamp, uint8_t phy,
+                                bool epoch);
+
+/**
+ * Answer a time sync request
+ * Packet: seq (1 byte) + T2 (8 bytes LE) + T3 (8 bytes LE), Host uptime in us.
+ * T3 is taken just before the notification is queued.
+ * @param seq Sequence number of the request
+ * @param rx_us Host time at which the request was received (T2)
+ * @return 0 on success, negative error code on failure
+ */
+int ble_service_send_time_sync(uint8_t seq, int64_t rx_us);
+
+/**
+ * Send a tag presence transition to App
+ * Packet: tag id (1 byte) + present (1 byte) + timeout ms (2 bytes LE) + address (6 bytes LE)
+ * @param tag_id Id of the Mipe tag
+ * @param present true when the tag appeared, false when it was declared absent
+ * @param addr Tag address
+ * @param timeout_ms Absence timeout in force for the tag
+ * @return 0 on success, negative error code on failure
+ */
+int ble_service_send_presence(uint8_t tag_id, bool present, const bt_addr_le_t *addr,
+                              uint32_t timeout_ms);
 
 /**
  * Send Mipe status to App
@@ -100,6 +159,12 @@ int ble_service_send_log_data(const char *log_string);
  */
 int ble_service_handle_control_command(const uint8_t *data, uint16_t len);
 
+/**
+ * Get App connection object
+ * @return Connection object or NULL if disconnected (not referenced)
+ */
+struct bt_conn *ble_service_get_app_conn(void);
+
 /**
  * Set App connection object
  * @param conn Connection object or NULL if disconnected
@@ -0,0 +1,255 @@
+#include "gatt_bench.h"
+#include "ble_service.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <errno.h>
+
+LOG_MODULE_REGISTER(gatt_bench, LOG_LEVEL_INF);
+
+#define BENCH_STACK_SIZE    1536
+
+// ========================================
+// SWEEP DEFINITION
+// ========================================
+
+// Connection intervals (1.25 ms units): 7.5, 15, 30 and 100 ms
+static const uint16_t intervals[] = { 6, 12, 24, 80 };
+
+static const uint8_t phys[] = { BT_GAP_LE_PHY_1M, BT_GAP_LE_PHY_2M, BT_GAP_LE_PHY_CODED };
+
+// LL data length: default and maximum
+static const uint16_t data_lens[] = { BT_GAP_DATA_LEN_DEFAULT, BT_GAP_DATA_LEN_MAX };
+
+// RSSI packet with and without the epoch timestamp
+static const bool epoch_payloads[] = { false, true };
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static volatile bool running = false;
+static volatile bool stop_requested = false;
+
+static void bench_thread(void *p1, void *p2, void *p3);
+K_SEM_DEFINE(bench_start_sem, 0, 1);
+K_THREAD_DEFINE(gatt_bench_tid, BENCH_STACK_SIZE, bench_thread, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+
+// ========================================
+// HELPERS
+// ========================================
+
+static const char *phy_name(uint8_t phy)
+{
+    switch (phy) {
+    case BT_GAP_LE_PHY_1M:
+        return "1M";
+    case BT_GAP_LE_PHY_2M:
+        return "2M";
+    case BT_GAP_LE_PHY_CODED:
+        return "Coded";
+    default:
+        return "?";
+    }
+}
+
+/**
+ * Request one configuration (the App may pick other values; the row reports what applies)
+ */
+static void request_config(struct bt_conn *conn, uint16_t interval, uint8_t phy, uint16_t data_len)
+{
+    struct bt_le_conn_param conn_param = {
+        .interval_min = interval,
+        .interval_max = interval,
+        .latency = 0,
+        .timeout = 400,
+    };
+    int err = bt_conn_le_param_update(conn, &conn_param);
+    if (err && err != -EALREADY) {
+        LOG_WRN("Connection interval request failed: %d", err);
+    }
+
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+    struct bt_conn_le_phy_param phy_param = {
+        .options = BT_CONN_LE_PHY_OPT_NONE,
+        .pref_tx_phy = phy,
+        .pref_rx_phy = phy,
+    };
+    err = bt_conn_le_phy_update(conn, &phy_param);
+    if (err) {
+        LOG_WRN("PHY request failed: %d", err);
+    }
+#endif
+
+#if defined(CONFIG_BT_USER_DATA_LEN_UPDATE)
+    struct bt_conn_le_data_len_param dl_param = {
+        .tx_max_len = data_len,
+        .tx_max_time = data_len == BT_GAP_DATA_LEN_MAX ? BT_GAP_DATA_TIME_MAX :
+                                                         BT_GAP_DATA_TIME_DEFAULT,
+    };
+    err = bt_conn_le_data_len_update(conn, &dl_param);
+    if (err) {
+        LOG_WRN("Data length request failed: %d", err);
+    }
+#endif
+}
+
+/**
+ * CPU busy cycles and total cycles since boot (0/0 without thread usage statistics)
+ */
+static void cpu_cycles(uint64_t *busy, uint64_t *total)
+{
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+    k_thread_runtime_stats_t stats;
+
+    k_thread_runtime_stats_all_get(&stats);
+    *busy = stats.total_cycles;
+    *total = stats.execution_cycles;
+#else
+    *busy = 0;
+    *total = 0;
+#endif
+}
+
+/**
+ * Flood for one step and log its row
+ * @return false if the sweep must end (App gone or stop requested)
+ */
+static bool run_step(struct bt_conn *conn, bool epoch)
+{
+    struct bt_conn_info info;
+    uint32_t sent = 0, enomem = 0, errors = 0;
+    uint64_t busy0, total0, busy1, total1;
+
+    k_msleep(GATT_BENCH_SETTLE_MS);
+    if (stop_requested || ble_service_get_app_conn() != conn || bt_conn_get_info(conn, &info)) {
+        return false;
+    }
+
+    uint16_t mtu = bt_gatt_get_mtu(conn);
+    uint8_t phy = BT_GAP_LE_PHY_1M;
+    uint16_t data_len = BT_GAP_DATA_LEN_DEFAULT;
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+    phy = info.le.phy->tx_phy;
+#endif
+#if defined(CONFIG_BT_USER_DATA_LEN_UPDATE)
+    data_len = info.le.data_len->tx_max_len;
+#endif
+
+    cpu_cycles(&busy0, &total0);
+    uint32_t start = k_uptime_get_32();
+    uint32_t now = start;
+    uint16_t payload = 0;
+
+    while (now - start < GATT_BENCH_STEP_MS) {
+        if (stop_requested || ble_service_get_app_conn() != conn) {
+            return false;
+        }
+
+        int len = ble_service_flood_rssi_data((uint8_t)sent, -60, now, BT_GAP_LE_PHY_1M, epoch);
+        if (len > 0) {
+            payload = (uint16_t)len;
+            sent++;
+        } else if (len == -ENOMEM) {
+            enomem++;
+            k_msleep(GATT_BENCH_BACKOFF_MS);
+        } else {
+            errors++;
+            k_msleep(GATT_BENCH_BACKOFF_MS);
+        }
+        now = k_uptime_get_32();
+    }
+    cpu_cycles(&busy1, &total1);
+
+    uint32_t elapsed = now - start;
+    uint32_t cpu_permille = total1 > total0 ?
+                            (uint32_t)((busy1 - busy0) * 1000U / (total1 - total0)) : 0;
+
+    LOG_INF("BENCH,%u,%s,%u,%u,%u,%u,%u,%u,%u,%u",
+            info.le.interval * 1250U, phy_name(phy), data_len, mtu, payload,
+            sent * 1000U / elapsed, sent * payload * 1000U / elapsed,
+            cpu_permille, enomem, errors);
+    return true;
+}
+
+static void bench_thread(void *p1, void *p2, void *p3)
+{
+    while (1) {
+        k_sem_take(&bench_start_sem, K_FOREVER);
+
+        struct bt_conn *conn = ble_service_get_app_conn();
+        struct bt_conn_info info;
+        if (!conn || bt_conn_get_info(conn, &info)) {
+            running = false;
+            continue;
+        }
+        // Keep the connection object valid if the App disconnects mid-sweep
+        conn = bt_conn_ref(conn);
+        uint16_t original_interval = info.le.interval;
+        uint32_t rows = 0;
+        bool go = true;
+
+        LOG_INF("GATT benchmark started (%u configurations)",
+                (unsigned int)(ARRAY_SIZE(intervals) * ARRAY_SIZE(phys) * ARRAY_SIZE(data_lens) *
+                ARRAY_SIZE(epoch_payloads)));
+        LOG_INF("BENCH,interval_us,phy,data_len,mtu,payload,notif_per_s,bytes_per_s,"
+                "cpu_permille,enomem,errors");
+
+        for (int i = 0; go && i < ARRAY_SIZE(intervals); i++) {
+            for (int p = 0; go && p < ARRAY_SIZE(phys); p++) {
+                for (int d = 0; go && d < ARRAY_SIZE(data_lens); d++) {
+                    request_config(conn, intervals[i], phys[p], data_lens[d]);
+                    for (int e = 0; go && e < ARRAY_SIZE(epoch_payloads); e++) {
+                        go = run_step(conn, epoch_payloads[e]);
+                        rows += go ? 1 : 0;
+                    }
+                }
+            }
+        }
+
+        // Back to the production link settings
+        if (ble_service_get_app_conn() == conn) {
+            request_config(conn, original_interval, BT_GAP_LE_PHY_1M, BT_GAP_DATA_LEN_MAX);
+        }
+
+        bt_conn_unref(conn);
+        LOG_INF("GATT benchmark %s after %u configurations",
+                go ? "finished" : "aborted", rows);
+        running = false;
+    }
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+int gatt_bench_start(void)
+{
+    if (!ble_service_is_app_connected()) {
+        return -ENOTCONN;
+    }
+    if (running) {
+        return -EALREADY;
+    }
+
+    running = true;
+    stop_requested = false;
+    k_sem_give(&bench_start_sem);
+    return 0;
+}
+
+void gatt_bench_stop(void)
+{
+    if (running) {
+        stop_requested = true;
+    }
+}
+
+bool gatt_bench_is_running(void)
+{
+    return running;
+}
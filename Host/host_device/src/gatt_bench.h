@@ -0,0 +1,52 @@
+#ifndef GATT_BENCH_H
+#define GATT_BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// GATT THROUGHPUT BENCHMARK CONFIGURATION
+// ========================================
+// Floods the RSSI characteristic with production-format packets on the App
+// connection while sweeping connection interval, PHY, data length and
+// payload size (plain and epoch-timestamped packet). One CSV row per
+// configuration is logged:
+//   BENCH,interval_us,phy,data_len,mtu,payload,notif_per_s,bytes_per_s,cpu_permille,enomem,errors
+// Build with bench.conf for PHY/data length control and CPU load figures.
+
+// Start the sweep as soon as the App enables RSSI notifications
+#ifndef GATT_BENCH_AUTOSTART
+#define GATT_BENCH_AUTOSTART        0
+#endif
+
+// Time for a parameter change to take effect before measuring
+#define GATT_BENCH_SETTLE_MS        1500
+
+// Flood duration per configuration
+#define GATT_BENCH_STEP_MS          3000
+
+// Back-off after a failed notification (TX buffers exhausted)
+#define GATT_BENCH_BACKOFF_MS       1
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Start the sweep on the App connection
+ * @return 0 on success, -ENOTCONN without App, -EALREADY if running
+ */
+int gatt_bench_start(void);
+
+/**
+ * Abort a running sweep (the connection parameters are restored)
+ */
+void gatt_bench_stop(void);
+
+/**
+ * Check whether a sweep is running
+ * @return true if running
+ */
+bool gatt_bench_is_running(void);
+
+#endif // GATT_BENCH_H
@@ -0,0 +1,263 @@
+#include "host_beacon.h"
+#include "host_energy.h"
+#include "mipe_tracker.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(host_beacon, LOG_LEVEL_INF);
+
+#define HEADER_LEN      4       // company, format, seq
+#define TAG_LEN         5       // id, RSSI, distance, flags
+#define SEQ_POS         3
+
+// AD element length and type bytes plus the manufacturer data
+BUILD_ASSERT(2 + HEADER_LEN + HOST_BEACON_MAX_TAGS * TAG_LEN <= BT_GAP_ADV_MAX_ADV_DATA_LEN,
+             "Status beacon payload must fit one legacy advertising PDU");
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct bt_le_ext_adv *beacon_set;
+static bool active = false;
+static bool on_air = false;
+static uint32_t last_update = 0;
+
+// Payload on air
+static uint8_t mfg_data[HEADER_LEN + HOST_BEACON_MAX_TAGS * TAG_LEN];
+static uint8_t mfg_len = HEADER_LEN;
+static uint8_t tag_count = 0;
+
+static uint32_t updates = 0;
+static uint32_t update_errors = 0;
+
+static const struct bt_le_adv_param beacon_param = BT_LE_ADV_PARAM_INIT(
+    BT_LE_ADV_OPT_USE_IDENTITY,     // Observers can tell which Host it is
+    HOST_BEACON_INT_MIN,
+    HOST_BEACON_INT_MAX,
+    NULL
+);
+
+// 10^(k/20) * 1000 for k = 0..20 (steps of 0.05 decade)
+static const uint16_t pow10_table[] = {
+    1000, 1122, 1259, 1413, 1585, 1778, 1995, 2239, 2512, 2818, 3162,
+    3548, 3981, 4467, 5012, 5623, 6310, 7079, 7943, 8913, 10000,
+};
+
+// ========================================
+// PAYLOAD
+// ========================================
+
+/**
+ * Strongest tags so far, strongest first (mipe_tracker_foreach context)
+ */
+struct beacon_fill {
+    struct {
+        int8_t normalized;
+        uint8_t data[TAG_LEN];
+    } tags[HOST_BEACON_MAX_TAGS];
+    uint8_t count;
+};
+
+static void add_tag(const struct mipe_tag *tag, void *user_data)
+{
+    struct beacon_fill *fill = user_data;
+    int8_t normalized = mipe_tag_normalized_rssi(tag);
+    int pos = fill->count;
+    uint8_t flags = 0;
+
+    // Insertion point by normalized RSSI; equal tags keep table order
+    while (pos > 0 && fill->tags[pos - 1].normalized < normalized) {
+        pos--;
+    }
+    if (pos >= HOST_BEACON_MAX_TAGS) {
+        return;
+    }
+
+    // Shift weaker tags down, dropping the weakest when full
+    int last = MIN(fill->count, HOST_BEACON_MAX_TAGS - 1);
+    memmove(&fill->tags[pos + 1], &fill->tags[pos], (last - pos) * sizeof(fill->tags[0]));
+    fill->count = MIN(fill->count + 1, HOST_BEACON_MAX_TAGS);
+
+    if (tag->presence.present) {
+        flags |= HOST_BEACON_FLAG_PRESENT;
+    }
+    if (tag->telemetry.valid) {
+        flags |= HOST_BEACON_FLAG_CALIBRATED;
+    }
+
+    uint8_t *data = fill->tags[pos].data;
+
+    fill->tags[pos].normalized = normalized;
+    data[0] = tag->id;
+    data[1] = (uint8_t)mipe_tag_filtered_rssi(tag);
+    sys_put_le16(host_beacon_distance_cm(normalized), &data[2]);
+    data[4] = flags;
+}
+
+static int set_data(const uint8_t *data, uint8_t len)
+{
+    struct bt_data ad[] = {
+        BT_DATA(BT_DATA_MANUFACTURER_DATA, data, len),
+    };
+
+    return bt_le_ext_adv_set_data(beacon_set, ad, ARRAY_SIZE(ad), NULL, 0);
+}
+
+static int start_set(void)
+{
+    int err = bt_le_ext_adv_start(beacon_set, BT_LE_EXT_ADV_START_DEFAULT);
+
+    if (err == 0) {
+        on_air = true;
+        host_energy_set(HOST_ENERGY_BEACON, true,
+                        BT_GAP_ADV_INTERVAL_TO_US((HOST_BEACON_INT_MIN + HOST_BEACON_INT_MAX) / 2));
+    }
+    return err;
+}
+
+static void stop_set(void)
+{
+    bt_le_ext_adv_stop(beacon_set);
+    on_air = false;
+    host_energy_set(HOST_ENERGY_BEACON, false, 0);
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+int host_beacon_start(void)
+{
+    int err;
+
+    sys_put_le16(HOST_BEACON_COMPANY_ID, &mfg_data[0]);
+    mfg_data[2] = HOST_BEACON_FORMAT_ID;
+    mfg_data[SEQ_POS] = 0;
+    mfg_len = HEADER_LEN;
+    tag_count = 0;
+
+    err = bt_le_ext_adv_create(&beacon_param, NULL, &beacon_set);
+    if (err) {
+        LOG_ERR("Failed to create beacon set (err %d)", err);
+        return err;
+    }
+
+    err = set_data(mfg_data, mfg_len);
+    if (err) {
+        LOG_ERR("Failed to set beacon data (err %d)", err);
+        return err;
+    }
+
+    err = start_set();
+    if (err) {
+        LOG_ERR("Failed to start beacon (err %d)", err);
+        return err;
+    }
+
+    active = true;
+    LOG_INF("Status beacon started (%u-%u ms, up to %u tags)",
+            HOST_BEACON_INT_MIN * 5 / 8, HOST_BEACON_INT_MAX * 5 / 8, HOST_BEACON_MAX_TAGS);
+    return 0;
+}
+
+void host_beacon_process(uint32_t now)
+{
+    uint8_t payload[sizeof(mfg_data)];
+    struct beacon_fill fill = { .count = 0 };
+
+    if (!active || now - last_update < HOST_BEACON_UPDATE_MIN_MS) {
+        return;
+    }
+
+    mipe_tracker_foreach(add_tag, &fill);
+
+    uint8_t len = HEADER_LEN + fill.count * TAG_LEN;
+
+    memcpy(payload, mfg_data, HEADER_LEN);
+    for (int i = 0; i < fill.count; i++) {
+        memcpy(&payload[HEADER_LEN + i * TAG_LEN], fill.tags[i].data, TAG_LEN);
+    }
+
+    if (on_air && len == mfg_len &&
+        memcmp(&payload[HEADER_LEN], &mfg_data[HEADER_LEN], len - HEADER_LEN) == 0) {
+        return;
+    }
+
+    payload[SEQ_POS] = mfg_data[SEQ_POS] + 1;
+    last_update = now;
+
+    int err = set_data(payload, len);
+    if (err) {
+        // The old payload no longer holds: take it off air until an update succeeds
+        update_errors++;
+        if (on_air) {
+            stop_set();
+        }
+        LOG_WRN("Failed to update beacon data (err %d), beacon off air", err);
+        return;
+    }
+
+    memcpy(mfg_data, payload, len);
+    mfg_len = len;
+    tag_count = fill.count;
+    updates++;
+
+    if (!on_air) {
+        err = start_set();
+        if (err) {
+            LOG_WRN("Failed to restart beacon (err %d)", err);
+        }
+    }
+}
+
+uint16_t host_beacon_distance_cm(int8_t rssi)
+{
+    // Exponent in hundredths of a decade, floored
+    int32_t loss_x100 = (MIPE_TRACKER_REFERENCE_TX_POWER - rssi) * 100;
+    int32_t p = loss_x100 / HOST_BEACON_PATH_LOSS_X10;
+
+    if (p * HOST_BEACON_PATH_LOSS_X10 > loss_x100) {
+        p--;
+    }
+
+    // Closer than 1 cm reads 1 cm
+    p = MAX(p, -200);
+
+    int32_t decades = (p >= 0 ? p : p - 99) / 100;
+    int32_t frac = p - decades * 100;
+
+    if (decades > 2) {
+        return UINT16_MAX;
+    }
+
+    // Mantissa x1000, interpolated between 0.05-decade steps
+    uint32_t i = frac / 5;
+    uint32_t mantissa = pow10_table[i] + (pow10_table[i + 1] - pow10_table[i]) * (frac % 5) / 5;
+
+    // 1 m * 10^p = mantissa / 10 cm, scaled by whole decades
+    uint32_t cm = mantissa / 10;
+    for (int32_t d = 0; d < decades; d++) {
+        cm *= 10;
+    }
+    for (int32_t d = 0; d > decades; d--) {
+        cm /= 10;
+    }
+
+    return (uint16_t)CLAMP(cm, 1, UINT16_MAX);
+}
+
+void host_beacon_get_stats(struct host_beacon_stats *out)
+{
+    out->active = active;
+    out->on_air = on_air;
+    out->seq = mfg_data[SEQ_POS];
+    out->tags = tag_count;
+    out->updates = updates;
+    out->update_errors = update_errors;
+}
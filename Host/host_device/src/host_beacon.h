@@ -0,0 +1,90 @@
+#ifndef HOST_BEACON_H
+#define HOST_BEACON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// STATUS BEACON CONFIGURATION
+// ========================================
+// A second advertising set, non-connectable and always on, broadcasts the
+// latest view of every tracked tag, so phones and displays can follow it
+// without taking a connection. It runs beside the connectable TMT1 set and
+// is unaffected by the advertising/scanning mode switches and App links.
+// Legacy PDUs keep it visible to observers without extended scanning.
+//
+// Manufacturer data (little endian):
+//   [company u16][format u8][seq u8] then per tag
+//   [id u8][filtered RSSI i8][distance cm u16][flags u8]
+// The tag count follows from the length. The strongest tags by normalized
+// RSSI are sent, strongest first. seq advances whenever the content
+// changes. The payload is refreshed when it changes, at most every
+// HOST_BEACON_UPDATE_MIN_MS. If an update fails the set stops advertising
+// until one succeeds, so observers never follow outdated content.
+
+#define HOST_BEACON_COMPANY_ID          0xFFFF  // Same test company ID as the tags
+#define HOST_BEACON_FORMAT_ID           0x49    // Tags use 0x4D (MIPE_MFG_FORMAT_ID)
+#define HOST_BEACON_MAX_TAGS            5       // 2 + 4 + 5 * 5 = 31-byte legacy payload
+
+// Tag flags
+#define HOST_BEACON_FLAG_PRESENT        0x01    // Presence detector says present
+#define HOST_BEACON_FLAG_CALIBRATED     0x02    // Distance uses the tag's advertised TX power
+
+// 100-150 ms events: each payload stays on air for at least two of them
+#define HOST_BEACON_INT_MIN             0x00A0  // 100 ms
+#define HOST_BEACON_INT_MAX             0x00F0  // 150 ms
+#define HOST_BEACON_UPDATE_MIN_MS       300
+
+// Log-distance path loss model: d = 10 ^ ((RSSI at 1 m - RSSI) / (10 * n))
+// with n = 2.0 in free space, 2.5-3.5 indoors
+#ifndef HOST_BEACON_PATH_LOSS_X10
+#define HOST_BEACON_PATH_LOSS_X10       20
+#endif
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Beacon counters
+ */
+struct host_beacon_stats {
+    bool active;                // Beacon started
+    bool on_air;                // Set advertising (off after a failed update)
+    uint8_t seq;                // Sequence number on air
+    uint8_t tags;               // Tags in the payload
+    uint32_t updates;           // Payload changes pushed to the controller
+    uint32_t update_errors;     // Failed payload updates
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Create the advertising set and start broadcasting (from the Bluetooth
+ * ready callback)
+ * @return 0 on success, negative error code otherwise
+ */
+int host_beacon_start(void);
+
+/**
+ * Refresh the payload if the tracked tags changed (main loop)
+ * @param now Current uptime in ms
+ */
+void host_beacon_process(uint32_t now);
+
+/**
+ * Distance estimate from a normalized RSSI (mipe_tag_normalized_rssi)
+ * @param rssi RSSI scaled to MIPE_TRACKER_REFERENCE_TX_POWER (dBm)
+ * @return Distance in cm, saturated to UINT16_MAX
+ */
+uint16_t host_beacon_distance_cm(int8_t rssi);
+
+/**
+ * Get the beacon counters
+ * @param out Destination for the counters
+ */
+void host_beacon_get_stats(struct host_beacon_stats *out);
+
+#endif // HOST_BEACON_H
@@ -0,0 +1,163 @@
+#include "host_energy.h"
+#include "scan_predictor.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
+
+LOG_MODULE_REGISTER(host_energy, LOG_LEVEL_INF);
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct k_spinlock lock;
+static int64_t last_update_ms = 0;
+static bool state_active[HOST_ENERGY_STATE_COUNT];
+static uint32_t state_value[HOST_ENERGY_STATE_COUNT];     // Event period (us) or duty (permille)
+
+// Totals
+static uint64_t time_ms[HOST_ENERGY_STATE_COUNT];
+static uint64_t residue_us[HOST_ENERGY_STATE_COUNT];
+static uint32_t events[HOST_ENERGY_STATE_COUNT];
+static uint64_t idle_ms = 0;
+static uint64_t scan_rx_us = 0;
+static atomic_t scan_reports = ATOMIC_INIT(0);
+
+// ========================================
+// HELPERS
+// ========================================
+
+/**
+ * Non-idle CPU cycles since boot (0 without thread usage statistics)
+ */
+static uint64_t cpu_active_cycles(void)
+{
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+    k_thread_runtime_stats_t stats;
+
+    if (k_thread_runtime_stats_all_get(&stats) == 0) {
+        return stats.total_cycles;
+    }
+#endif
+    return 0;
+}
+
+/**
+ * Add the time since the last update to the running activities (lock held)
+ */
+static void account(int64_t now_ms)
+{
+    uint64_t elapsed_ms = (uint64_t)(now_ms - last_update_ms);
+    bool any = false;
+
+    for (int i = 0; i < HOST_ENERGY_STATE_COUNT; i++) {
+        if (!state_active[i]) {
+            continue;
+        }
+        any = true;
+        time_ms[i] += elapsed_ms;
+
+        if (i == HOST_ENERGY_SCANNING) {
+            scan_rx_us += elapsed_ms * state_value[i];    // ms * permille = us
+        } else if (state_value[i] > 0) {
+            // Keep the remainder so short intervals don't lose events
+            uint64_t elapsed_us = elapsed_ms * 1000U + residue_us[i];
+
+            events[i] += (uint32_t)(elapsed_us / state_value[i]);
+            residue_us[i] = elapsed_us % state_value[i];
+        }
+    }
+
+    if (!any) {
+        idle_ms += elapsed_ms;
+    }
+    last_update_ms = now_ms;
+}
+
+static uint32_t event_charge_nc(enum host_energy_state state)
+{
+    switch (state) {
+    case HOST_ENERGY_ADVERTISING:
+        return HOST_ENERGY_ADV_EVENT_CHARGE_NC;
+    case HOST_ENERGY_BEACON:
+        return HOST_ENERGY_BEACON_EVENT_CHARGE_NC;
+    case HOST_ENERGY_APP_LINK:
+    case HOST_ENERGY_MIPE_LINK:
+        return HOST_ENERGY_CONN_EVENT_CHARGE_NC;
+    default:
+        return 0;
+    }
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+void host_energy_set(enum host_energy_state state, bool active, uint32_t value)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    account(k_uptime_get());
+    state_active[state] = active;
+    state_value[state] = active ? value : 0;
+
+    k_spin_unlock(&lock, key);
+}
+
+void host_energy_on_scan_report(void)
+{
+    atomic_inc(&scan_reports);
+}
+
+void host_energy_get(struct host_energy_report *out)
+{
+    struct scan_predictor_stats sp;
+    uint64_t cpu_cycles = cpu_active_cycles();
+    uint64_t charge_nc = 0;
+
+    scan_predictor_get_stats(&sp);
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    account(k_uptime_get());
+
+    out->idle_ms = idle_ms;
+    out->tx_packets = 0;
+    out->rx_windows = 0;
+    for (int i = 0; i < HOST_ENERGY_STATE_COUNT; i++) {
+        out->time_ms[i] = time_ms[i];
+        out->events[i] = events[i];
+        charge_nc += (uint64_t)events[i] * event_charge_nc(i);
+        if (i == HOST_ENERGY_ADVERTISING) {
+            out->tx_packets += events[i] * HOST_ENERGY_ADV_EVENT_TX;
+            out->rx_windows += events[i] * HOST_ENERGY_ADV_EVENT_RX;
+        } else if (i == HOST_ENERGY_BEACON) {
+            out->tx_packets += events[i] * HOST_ENERGY_BEACON_EVENT_TX;
+        } else if (i != HOST_ENERGY_SCANNING) {
+            out->tx_packets += events[i] * HOST_ENERGY_CONN_EVENT_TX;
+            out->rx_windows += events[i] * HOST_ENERGY_CONN_EVENT_RX;
+        }
+    }
+    // Activities overlap, so the total is the uptime rather than their sum
+    out->total_ms = (uint64_t)last_update_ms;
+    out->rx_ms = (scan_rx_us + sp.scan_time_us) / 1000U;
+
+    k_spin_unlock(&lock, key);
+
+    out->scan_reports = (uint32_t)atomic_get(&scan_reports);
+    out->cpu_active_ms = k_cyc_to_ms_floor64(cpu_cycles);
+
+    // Receive and CPU time at their currents (nA * ms / 1000 = nC)
+    charge_nc += out->rx_ms * HOST_ENERGY_RX_CURRENT_NA / 1000U;
+    charge_nc += out->cpu_active_ms * HOST_ENERGY_CPU_ACTIVE_CURRENT_NA / 1000U;
+
+    // nC / ms = uA, so scale by 1000 for nA
+    out->average_current_na = HOST_ENERGY_SLEEP_CURRENT_NA;
+    if (out->total_ms > 0) {
+        out->average_current_na += (uint32_t)(charge_nc * 1000U / out->total_ms);
+    }
+
+    // nA * 24 h = nAh per day; divide by 1000 for uAh
+    out->uah_per_day = (uint32_t)((uint64_t)out->average_current_na * 24U / 1000U);
+}
@@ -0,0 +1,102 @@
+#ifndef HOST_ENERGY_H
+#define HOST_ENERGY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// ENERGY ACCOUNTING CONFIGURATION
+// ========================================
+// Time spent advertising, scanning, on each link and broadcasting the
+// status beacon, and idle (none of them), with the radio events each implies: advertising and connection
+// events from the active interval, receive time from the scan duty cycle
+// plus the predicted scan windows. A current per state turns the totals
+// into an average current and a projected consumption per day, printed by
+// host_metrics_report as "METRICS energy ...". CPU active time needs
+// CONFIG_SCHED_THREAD_USAGE_ALL (bench.conf) and reads 0 otherwise.
+
+// Current model - nRF54L15 estimates at 0 dBm (override with measured values)
+#ifndef HOST_ENERGY_SLEEP_CURRENT_NA
+#define HOST_ENERGY_SLEEP_CURRENT_NA        3000    // System ON, GRTC running
+#endif
+#ifndef HOST_ENERGY_RX_CURRENT_NA
+#define HOST_ENERGY_RX_CURRENT_NA           3200000 // Radio receiving (scanning)
+#endif
+#ifndef HOST_ENERGY_ADV_EVENT_CHARGE_NC
+#define HOST_ENERGY_ADV_EVENT_CHARGE_NC     12000   // Connectable legacy event, 3 channels
+#endif
+#ifndef HOST_ENERGY_BEACON_EVENT_CHARGE_NC
+#define HOST_ENERGY_BEACON_EVENT_CHARGE_NC  7000    // Non-connectable legacy event, 3 channels
+#endif
+#ifndef HOST_ENERGY_CONN_EVENT_CHARGE_NC
+#define HOST_ENERGY_CONN_EVENT_CHARGE_NC    4000    // Empty connection event
+#endif
+#ifndef HOST_ENERGY_CPU_ACTIVE_CURRENT_NA
+#define HOST_ENERGY_CPU_ACTIVE_CURRENT_NA   2400000 // CPU running from RRAM at 128 MHz
+#endif
+
+// Radio packets per event
+#define HOST_ENERGY_ADV_EVENT_TX            3       // One per advertising channel
+#define HOST_ENERGY_ADV_EVENT_RX            3       // Connect request windows
+#define HOST_ENERGY_BEACON_EVENT_TX         3       // Transmit only
+#define HOST_ENERGY_CONN_EVENT_TX           1
+#define HOST_ENERGY_CONN_EVENT_RX           1
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Accounted activities (several can run at once)
+ */
+enum host_energy_state {
+    HOST_ENERGY_ADVERTISING,
+    HOST_ENERGY_SCANNING,
+    HOST_ENERGY_APP_LINK,
+    HOST_ENERGY_MIPE_LINK,
+    HOST_ENERGY_BEACON,
+    HOST_ENERGY_STATE_COUNT,
+};
+
+/**
+ * Accumulated figures since boot
+ */
+struct host_energy_report {
+    uint64_t time_ms[HOST_ENERGY_STATE_COUNT];
+    uint64_t idle_ms;               // No activity
+    uint64_t total_ms;
+    uint32_t events[HOST_ENERGY_STATE_COUNT];   // Advertising / connection events
+    uint64_t rx_ms;                 // Scan receive time, continuous and predicted windows
+    uint64_t cpu_active_ms;         // CPU out of idle
+    uint32_t tx_packets;            // Estimated radio transmissions
+    uint32_t rx_windows;            // Estimated receive windows of adv and connection events
+    uint32_t scan_reports;          // Advertising reports received
+    uint32_t average_current_na;
+    uint32_t uah_per_day;           // Projected consumption per day
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Start or stop an activity
+ * @param state Activity
+ * @param active true when it starts, false when it stops
+ * @param value Event period in us (advertising, links) or receive duty
+ *              in permille (scanning); ignored when stopping
+ */
+void host_energy_set(enum host_energy_state state, bool active, uint32_t value);
+
+/**
+ * Count an advertising report (from the scan receive callback)
+ */
+void host_energy_on_scan_report(void);
+
+/**
+ * Get the accumulated figures up to now
+ * @param out Destination for the report
+ */
+void host_energy_get(struct host_energy_report *out);
+
+#endif // HOST_ENERGY_H
@@ -0,0 +1,210 @@
+#include "host_metrics.h"
+#include "host_energy.h"
+#include "host_telemetry.h"
+#include "mipe_tracker.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(host_metrics, LOG_LEVEL_INF);
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct k_spinlock lock;
+static struct host_metrics metrics;
+
+// Event bookkeeping
+static uint32_t absent_since = 0;
+static uint32_t app_lost_since = 0;
+static bool app_was_connected = false;
+static uint32_t app_connected_at = 0;       // 0 = first notification already seen
+static bool app_bonded = false;
+
+// Current report period
+static uint32_t period_start = 0;
+static uint32_t period_samples = 0;
+static uint32_t period_latency_sum = 0;
+static uint32_t period_latency_max = 0;
+
+// ========================================
+// HELPERS
+// ========================================
+
+struct seq_totals {
+    uint32_t received;
+    uint32_t expected;
+};
+
+/**
+ * Sum telemetry sequence counts (mipe_tracker_foreach callback)
+ */
+static void sum_seq(const struct mipe_tag *tag, void *user_data)
+{
+    struct seq_totals *totals = user_data;
+
+    totals->received += tag->stats.seq_received;
+    totals->expected += tag->stats.seq_expected;
+}
+
+static void check_limit(const char *name, bool ok, uint32_t value, uint32_t limit)
+{
+    if (!ok) {
+        metrics.failures++;
+        LOG_WRN("METRICS FAIL %s=%u limit=%u", name, value, limit);
+    }
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+void host_metrics_init(void)
+{
+    memset(&metrics, 0, sizeof(metrics));
+    period_start = k_uptime_get_32();
+    period_samples = 0;
+    period_latency_sum = 0;
+    period_latency_max = 0;
+}
+
+void host_metrics_on_presence(bool present, uint32_t now)
+{
+    if (!present) {
+        absent_since = now;
+        return;
+    }
+
+    if (metrics.discovery_ms == 0) {
+        metrics.discovery_ms = MAX(now, 1U);
+        LOG_INF("METRICS discovery_ms=%u", metrics.discovery_ms);
+    } else if (absent_since != 0) {
+        metrics.rediscovery_ms = now - absent_since;
+        LOG_INF("METRICS rediscovery_ms=%u", metrics.rediscovery_ms);
+    }
+    absent_since = 0;
+}
+
+void host_metrics_on_app_connection(bool connected, bool bonded, uint32_t now)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    app_connected_at = connected ? MAX(now, 1U) : 0;
+    app_bonded = bonded;
+    k_spin_unlock(&lock, key);
+
+    if (!connected) {
+        if (app_was_connected) {
+            app_lost_since = now;
+        }
+        return;
+    }
+
+    if (metrics.app_connect_ms == 0) {
+        metrics.app_connect_ms = MAX(now, 1U);
+    } else if (app_lost_since != 0) {
+        metrics.app_reconnect_ms = now - app_lost_since;
+        LOG_INF("METRICS app_reconnect_ms=%u", metrics.app_reconnect_ms);
+    }
+    app_was_connected = true;
+    app_lost_since = 0;
+}
+
+void host_metrics_on_sample_sent(uint32_t latency_ms)
+{
+    uint32_t first_notify_ms = 0;
+    bool bonded = false;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    // Includes pairing or discovery, subscription and the start command
+    if (app_connected_at != 0) {
+        first_notify_ms = MAX(k_uptime_get_32() - app_connected_at, 1U);
+        bonded = app_bonded;
+        if (bonded) {
+            metrics.first_notify_bonded_ms = first_notify_ms;
+        } else {
+            metrics.first_notify_ms = first_notify_ms;
+        }
+        app_connected_at = 0;
+    }
+
+    metrics.samples_sent++;
+    period_samples++;
+    period_latency_sum += latency_ms;
+    period_latency_max = MAX(period_latency_max, latency_ms);
+    k_spin_unlock(&lock, key);
+
+    if (first_notify_ms) {
+        LOG_INF("METRICS first_notify_ms=%u bonded=%u", first_notify_ms, bonded);
+    }
+}
+
+void host_metrics_report(uint32_t now, bool streaming)
+{
+    uint32_t elapsed = now - period_start;
+    struct seq_totals totals = { 0 };
+
+    if (elapsed < HOST_METRICS_INTERVAL_MS) {
+        return;
+    }
+
+    mipe_tracker_foreach(sum_seq, &totals);
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    metrics.samples_per_s_x10 = period_samples * 10000U / elapsed;
+    metrics.latency_avg_ms = period_samples ? period_latency_sum / period_samples : 0;
+    metrics.latency_max_ms = period_latency_max;
+    period_start = now;
+    period_samples = 0;
+    period_latency_sum = 0;
+    period_latency_max = 0;
+    k_spin_unlock(&lock, key);
+
+    metrics.loss_permille = totals.expected ?
+                            (totals.expected - totals.received) * 1000U / totals.expected : 0;
+
+    LOG_INF("METRICS discovery_ms=%u rediscovery_ms=%u app_connect_ms=%u app_reconnect_ms=%u "
+            "first_notify_ms=%u first_notify_bonded_ms=%u "
+            "samples=%u sps=%u.%u loss=%u.%u%% latency_avg_ms=%u latency_max_ms=%u failures=%u",
+            metrics.discovery_ms, metrics.rediscovery_ms, metrics.app_connect_ms,
+            metrics.app_reconnect_ms, metrics.first_notify_ms, metrics.first_notify_bonded_ms,
+            metrics.samples_sent,
+            metrics.samples_per_s_x10 / 10, metrics.samples_per_s_x10 % 10,
+            metrics.loss_permille / 10, metrics.loss_permille % 10,
+            metrics.latency_avg_ms, metrics.latency_max_ms, metrics.failures);
+
+    struct host_energy_report energy;
+    host_energy_get(&energy);
+    LOG_INF("METRICS energy adv_ms=%llu scan_ms=%llu app_ms=%llu mipe_ms=%llu beacon_ms=%llu "
+            "idle_ms=%llu rx_ms=%llu cpu_ms=%llu tx=%u rx=%u reports=%u avg_ua=%u.%03u mah_day=%u.%03u",
+            energy.time_ms[HOST_ENERGY_ADVERTISING], energy.time_ms[HOST_ENERGY_SCANNING],
+            energy.time_ms[HOST_ENERGY_APP_LINK], energy.time_ms[HOST_ENERGY_MIPE_LINK],
+            energy.time_ms[HOST_ENERGY_BEACON], energy.idle_ms, energy.rx_ms, energy.cpu_active_ms, energy.tx_packets,
+            energy.rx_windows, energy.scan_reports,
+            energy.average_current_na / 1000U, energy.average_current_na % 1000U,
+            energy.uah_per_day / 1000U, energy.uah_per_day % 1000U);
+    host_telemetry_metrics(&metrics, energy.average_current_na);
+
+    // Discovery counts as failed once the limit passed without a tag
+    uint32_t discovery = metrics.discovery_ms ? metrics.discovery_ms : now;
+    check_limit("discovery_ms", discovery <= HOST_METRICS_MAX_DISCOVERY_MS, discovery,
+                HOST_METRICS_MAX_DISCOVERY_MS);
+    check_limit("rediscovery_ms", metrics.rediscovery_ms <= HOST_METRICS_MAX_DISCOVERY_MS,
+                metrics.rediscovery_ms, HOST_METRICS_MAX_DISCOVERY_MS);
+    if (streaming && absent_since == 0 && metrics.discovery_ms != 0) {
+        check_limit("sps_x10", metrics.samples_per_s_x10 >= HOST_METRICS_MIN_SAMPLES_PER_S_X10,
+                    metrics.samples_per_s_x10, HOST_METRICS_MIN_SAMPLES_PER_S_X10);
+    }
+    check_limit("loss_permille", metrics.loss_permille <= HOST_METRICS_MAX_LOSS_PERMILLE,
+                metrics.loss_permille, HOST_METRICS_MAX_LOSS_PERMILLE);
+    check_limit("latency_max_ms", metrics.latency_max_ms <= HOST_METRICS_MAX_LATENCY_MS,
+                metrics.latency_max_ms, HOST_METRICS_MAX_LATENCY_MS);
+}
+
+void host_metrics_get(struct host_metrics *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = metrics;
+    k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,97 @@
+#ifndef HOST_METRICS_H
+#define HOST_METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// SYSTEM METRICS CONFIGURATION
+// ========================================
+// End-to-end figures of the Host/Mipe/App chain, printed as one
+// "METRICS key=value ..." line so a scripted run (hardware or simulation)
+// can parse them, and checked against the limits below. A violated limit
+// is logged as "METRICS FAIL <metric>".
+
+// Report period
+#define HOST_METRICS_INTERVAL_MS            10000
+
+// Regression limits (override with compiler definitions for other setups)
+#ifndef HOST_METRICS_MAX_DISCOVERY_MS
+#define HOST_METRICS_MAX_DISCOVERY_MS       10000   // Boot (or absence) to tag present
+#endif
+#ifndef HOST_METRICS_MIN_SAMPLES_PER_S_X10
+#define HOST_METRICS_MIN_SAMPLES_PER_S_X10  80      // While streaming to the App
+#endif
+#ifndef HOST_METRICS_MAX_LOSS_PERMILLE
+#define HOST_METRICS_MAX_LOSS_PERMILLE      100     // Telemetry versions missed while scanning
+#endif
+#ifndef HOST_METRICS_MAX_LATENCY_MS
+#define HOST_METRICS_MAX_LATENCY_MS         200     // Report to App notification
+#endif
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Collected metrics
+ */
+struct host_metrics {
+    uint32_t discovery_ms;          // Boot to first tag present (0 = not yet)
+    uint32_t rediscovery_ms;        // Latest absence to present again
+    uint32_t app_connect_ms;        // Boot to first App connection (0 = not yet)
+    uint32_t app_reconnect_ms;      // Latest App disconnection to reconnection
+    uint32_t first_notify_ms;       // Connection to first RSSI notification, new App
+    uint32_t first_notify_bonded_ms; // Same for a bonded App (cached GATT, stored CCC)
+    uint32_t samples_sent;          // RSSI samples delivered to the App
+    uint32_t samples_per_s_x10;     // Delivery rate over the last report period
+    uint32_t loss_permille;         // Telemetry versions missed while scanning, all tags
+    uint32_t latency_avg_ms;        // Report to notification, last report period
+    uint32_t latency_max_ms;
+    uint32_t failures;              // Limit violations since boot
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Reset all metrics
+ */
+void host_metrics_init(void);
+
+/**
+ * Record a tag presence transition
+ * @param present true when the tag appeared
+ * @param now Current uptime in milliseconds
+ */
+void host_metrics_on_presence(bool present, uint32_t now);
+
+/**
+ * Record an App connection change
+ * @param connected true on connection
+ * @param bonded The App was bonded before this connection
+ * @param now Current uptime in milliseconds
+ */
+void host_metrics_on_app_connection(bool connected, bool bonded, uint32_t now);
+
+/**
+ * Record an RSSI sample delivered to the App
+ * @param latency_ms Time from the tag report to the notification
+ */
+void host_metrics_on_sample_sent(uint32_t latency_ms);
+
+/**
+ * Print the metrics line and check the limits once per HOST_METRICS_INTERVAL_MS
+ * @param now Current uptime in milliseconds
+ * @param streaming Streaming to the App is active (rate limit applies)
+ */
+void host_metrics_report(uint32_t now, bool streaming);
+
+/**
+ * Get the metrics of the latest report
+ * @param out Destination for the metrics
+ */
+void host_metrics_get(struct host_metrics *out);
+
+#endif // HOST_METRICS_H
@@ -0,0 +1,217 @@
+#include "host_telemetry.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <errno.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(host_telemetry, LOG_LEVEL_INF);
+
+#define TELEMETRY_STACK_SIZE    1024
+#define CRC_INIT                0xFFFF
+
+// Type, sequence, timestamp
+#define HEADER_LEN              7
+#define CRC_LEN                 2
+#define MAX_BODY_LEN            48
+#define MAX_RECORD_LEN          (HEADER_LEN + MAX_BODY_LEN + CRC_LEN)
+
+// COBS adds one byte per 254 and the delimiters
+#define MAX_FRAME_LEN           (MAX_RECORD_LEN + MAX_RECORD_LEN / 254 + 1 + 2)
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct k_spinlock lock;
+static struct host_telemetry_stats stats;
+static uint16_t next_seq = 0;
+
+#if HOST_TELEMETRY
+#if DT_HAS_CHOSEN(mipe_telemetry_uart)
+static const struct device *const uart_dev = DEVICE_DT_GET(DT_CHOSEN(mipe_telemetry_uart));
+#else
+static const struct device *const uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+#endif
+
+RING_BUF_DECLARE(telemetry_ring, HOST_TELEMETRY_BUF_SIZE);
+K_SEM_DEFINE(telemetry_sem, 0, 1);
+
+static void telemetry_thread(void *p1, void *p2, void *p3);
+K_THREAD_DEFINE(host_telemetry_tid, TELEMETRY_STACK_SIZE, telemetry_thread, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+#endif
+
+// ========================================
+// FRAMING
+// ========================================
+
+#if HOST_TELEMETRY
+/**
+ * COBS encode a record between two delimiters
+ * @return Frame length
+ */
+static size_t cobs_frame(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t code_pos = 1;
+    size_t pos = 2;
+    uint8_t code = 1;
+
+    out[0] = 0x00;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] != 0x00) {
+            out[pos++] = in[i];
+            code++;
+        }
+        if (in[i] == 0x00 || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    out[pos++] = 0x00;
+
+    return pos;
+}
+
+static void telemetry_thread(void *p1, void *p2, void *p3)
+{
+    while (1) {
+        k_sem_take(&telemetry_sem, K_FOREVER);
+
+        uint8_t *data;
+        uint32_t len;
+        while ((len = ring_buf_get_claim(&telemetry_ring, &data,
+                                         HOST_TELEMETRY_BUF_SIZE)) > 0) {
+            for (uint32_t i = 0; i < len; i++) {
+                uart_poll_out(uart_dev, data[i]);
+            }
+            ring_buf_get_finish(&telemetry_ring, len);
+        }
+    }
+}
+#endif
+
+/**
+ * Add header and CRC to a record body and queue it
+ */
+static void send_record(uint8_t type, const uint8_t *body, size_t body_len)
+{
+#if HOST_TELEMETRY
+    uint8_t record[MAX_RECORD_LEN];
+    uint8_t frame[MAX_FRAME_LEN];
+    size_t len = HEADER_LEN + body_len;
+
+    record[0] = type;
+    sys_put_le32(k_uptime_get_32(), &record[3]);
+    memcpy(&record[HEADER_LEN], body, body_len);
+
+    // Samples come from the RX thread, work queues and the main loop:
+    // number and queue each frame whole
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    sys_put_le16(next_seq++, &record[1]);
+    sys_put_le16(crc16_itu_t(CRC_INIT, record, len), &record[len]);
+    size_t frame_len = cobs_frame(record, len + CRC_LEN, frame);
+
+    if (ring_buf_space_get(&telemetry_ring) >= frame_len) {
+        ring_buf_put(&telemetry_ring, frame, frame_len);
+        stats.records++;
+        stats.bytes += frame_len;
+    } else {
+        stats.dropped++;
+    }
+    k_spin_unlock(&lock, key);
+
+    k_sem_give(&telemetry_sem);
+#endif
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+int host_telemetry_init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+
+#if HOST_TELEMETRY
+    if (!device_is_ready(uart_dev)) {
+        LOG_ERR("Telemetry UART not ready");
+        return -ENODEV;
+    }
+    LOG_INF("Binary telemetry on %s", uart_dev->name);
+#endif
+    return 0;
+}
+
+void host_telemetry_sample(uint8_t source, const bt_addr_le_t *addr, int8_t rssi, uint8_t phy,
+                           bool connectable, const struct mipe_telemetry *telemetry)
+{
+    if (!HOST_TELEMETRY) {
+        return;
+    }
+
+    uint8_t body[12];
+
+    body[0] = source;
+    body[1] = addr->type;
+    memcpy(&body[2], addr->a.val, sizeof(addr->a.val));
+    body[8] = (uint8_t)rssi;
+    body[9] = phy;
+    body[10] = telemetry ? telemetry->seq : 0;
+    body[11] = (connectable ? HOST_TELEMETRY_FLAG_CONNECTABLE : 0) |
+               (telemetry ? HOST_TELEMETRY_FLAG_SEQ : 0);
+
+    send_record(HOST_TELEMETRY_SAMPLE, body, sizeof(body));
+}
+
+void host_telemetry_event(uint8_t id, uint32_t arg0, uint32_t arg1)
+{
+    if (!HOST_TELEMETRY) {
+        return;
+    }
+
+    uint8_t body[9];
+
+    body[0] = id;
+    sys_put_le32(arg0, &body[1]);
+    sys_put_le32(arg1, &body[5]);
+
+    send_record(HOST_TELEMETRY_EVENT, body, sizeof(body));
+}
+
+void host_telemetry_metrics(const struct host_metrics *metrics, uint32_t average_current_na)
+{
+    if (!HOST_TELEMETRY) {
+        return;
+    }
+
+    const uint32_t values[] = {
+        metrics->discovery_ms, metrics->rediscovery_ms, metrics->app_connect_ms,
+        metrics->app_reconnect_ms, metrics->samples_sent, metrics->samples_per_s_x10,
+        metrics->loss_permille, metrics->latency_avg_ms, metrics->latency_max_ms,
+        metrics->failures, average_current_na, stats.dropped,
+    };
+    uint8_t body[sizeof(values)];
+
+    BUILD_ASSERT(sizeof(values) <= MAX_BODY_LEN);
+    for (int i = 0; i < ARRAY_SIZE(values); i++) {
+        sys_put_le32(values[i], &body[i * 4]);
+    }
+
+    send_record(HOST_TELEMETRY_METRICS, body, sizeof(body));
+}
+
+void host_telemetry_get_stats(struct host_telemetry_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = stats;
+    k_spin_unlock(&lock, key);
+}
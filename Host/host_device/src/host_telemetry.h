@@ -0,0 +1,109 @@
+#ifndef HOST_TELEMETRY_H
+#define HOST_TELEMETRY_H
+
+#include <zephyr/bluetooth/addr.h>
+#include "host_metrics.h"
+#include "mipe_adv.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// BINARY TELEMETRY CONFIGURATION
+// ========================================
+// Every RSSI sample, Host event and metrics report is written as a binary
+// record to a UART of its own, bypassing the log subsystem. Records are
+// COBS encoded and delimited by 0x00 on both sides, so a receiver joining
+// mid-stream loses at most one record:
+//   0x00 COBS([type][seq u16][timestamp_ms u32][body][crc16]) 0x00
+// seq counts every record (gaps show records dropped on a full buffer),
+// crc16 is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over type to body,
+// little endian like all fields.
+// Build with -DHOST_TELEMETRY=1 and telemetry.overlay, which routes the
+// records to uart30 (the DK's second virtual COM port, USB CDC on the PC).
+// Without the overlay they share the console UART with the log text.
+// telemetry.py decodes the stream into CSV or Parquet files.
+
+#ifndef HOST_TELEMETRY
+#define HOST_TELEMETRY                  0
+#endif
+
+// Output buffer: absorbs bursts while the UART drains
+#define HOST_TELEMETRY_BUF_SIZE         4096
+
+// Record types
+#define HOST_TELEMETRY_SAMPLE           0x01    // RSSI sample
+#define HOST_TELEMETRY_EVENT            0x02    // Host event
+#define HOST_TELEMETRY_METRICS          0x03    // System metrics report
+
+// Sample sources
+#define HOST_TELEMETRY_SRC_SCAN         0       // Advertising report
+#define HOST_TELEMETRY_SRC_PERIODIC     1       // Periodic advertising report
+#define HOST_TELEMETRY_SRC_CONN         2       // Connection-event RSSI
+
+// Sample flags
+#define HOST_TELEMETRY_FLAG_CONNECTABLE 0x01
+#define HOST_TELEMETRY_FLAG_SEQ         0x02    // Tag telemetry sequence valid
+
+// Event ids (arguments in brackets)
+#define HOST_TELEMETRY_EV_MODE          1       // [0 advertising / 1 scanning]
+#define HOST_TELEMETRY_EV_APP_LINK      2       // [1 connected / 0 lost, reason]
+#define HOST_TELEMETRY_EV_MIPE_LINK     3       // [1 connected / 0 lost, reason]
+#define HOST_TELEMETRY_EV_PRESENCE      4       // [1 present / 0 absent, tag id]
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Output statistics
+ */
+struct host_telemetry_stats {
+    uint32_t records;       // Records written to the UART
+    uint32_t dropped;       // Records lost to a full output buffer
+    uint32_t bytes;         // Encoded bytes queued
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Check the telemetry UART (no-op unless built with HOST_TELEMETRY)
+ * @return 0 on success, -ENODEV if the UART is not ready
+ */
+int host_telemetry_init(void);
+
+/**
+ * Record one RSSI sample
+ * @param source HOST_TELEMETRY_SRC_*
+ * @param addr Tag address
+ * @param rssi RSSI in dBm
+ * @param phy Primary PHY (BT_GAP_LE_PHY_*, NONE for connection samples)
+ * @param connectable Report was connectable
+ * @param telemetry Tag telemetry of the report (may be NULL)
+ */
+void host_telemetry_sample(uint8_t source, const bt_addr_le_t *addr, int8_t rssi, uint8_t phy,
+                           bool connectable, const struct mipe_telemetry *telemetry);
+
+/**
+ * Record a Host event
+ * @param id HOST_TELEMETRY_EV_*
+ * @param arg0 First argument
+ * @param arg1 Second argument
+ */
+void host_telemetry_event(uint8_t id, uint32_t arg0, uint32_t arg1);
+
+/**
+ * Record a metrics report
+ * @param metrics Latest metrics
+ * @param average_current_na Projected average current
+ */
+void host_telemetry_metrics(const struct host_metrics *metrics, uint32_t average_current_na);
+
+/**
+ * Get output statistics
+ * @param out Destination for the statistics
+ */
+void host_telemetry_get_stats(struct host_telemetry_stats *out);
+
+#endif // HOST_TELEMETRY_H
@@ -0,0 +1,107 @@
+#include "host_trace.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+
+LOG_MODULE_REGISTER(host_trace, LOG_LEVEL_INF);
+
+#define DUMP_STACK_SIZE     1024
+
+#if defined(CONFIG_TRACING)
+// Tracing core control (CONFIG_TRACING_HANDLE_HOST_CMD): "enable" / "disable".
+// With host commands enabled the core starts disabled, so the buffer is not
+// filled by the boot sequence.
+extern void tracing_cmd_handle(uint8_t *buf, uint32_t length);
+#endif
+
+#if defined(CONFIG_TRACING_BACKEND_RAM)
+// Buffer of the RAM tracing backend
+extern uint8_t ram_tracing[CONFIG_RAM_TRACING_BUFFER_SIZE];
+
+static volatile bool dumping = false;
+
+static void dump_thread(void *p1, void *p2, void *p3);
+K_SEM_DEFINE(dump_sem, 0, 1);
+K_THREAD_DEFINE(host_trace_tid, DUMP_STACK_SIZE, dump_thread, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+#endif
+
+// ========================================
+// DUMP
+// ========================================
+
+#if defined(CONFIG_TRACING_BACKEND_RAM)
+/**
+ * Recorded length: the backend fills the buffer from the start and leaves
+ * the rest zeroed. Zero bytes at the end of the last event are cut too;
+ * the converter drops that truncated event.
+ */
+static uint32_t recorded_len(void)
+{
+    uint32_t len = CONFIG_RAM_TRACING_BUFFER_SIZE;
+
+    while (len > 0 && ram_tracing[len - 1] == 0) {
+        len--;
+    }
+    return len;
+}
+
+static void dump_thread(void *p1, void *p2, void *p3)
+{
+    char hex[HOST_TRACE_DUMP_CHUNK * 2 + 1];
+
+    while (1) {
+        k_sem_take(&dump_sem, K_FOREVER);
+
+        uint32_t len = recorded_len();
+
+        LOG_INF("TRACE,BEGIN,%u", len);
+        for (uint32_t offset = 0; offset < len; offset += HOST_TRACE_DUMP_CHUNK) {
+            size_t chunk = MIN(len - offset, HOST_TRACE_DUMP_CHUNK);
+
+            bin2hex(&ram_tracing[offset], chunk, hex, sizeof(hex));
+            LOG_INF("TRACE,%u,%s", offset, hex);
+        }
+        LOG_INF("TRACE,END,%u", len);
+
+        dumping = false;
+    }
+}
+#endif
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+int host_trace_start(void)
+{
+#if defined(CONFIG_TRACING)
+    uint8_t cmd[] = "enable";
+
+    tracing_cmd_handle(cmd, sizeof(cmd) - 1);
+    LOG_INF("Event tracing started");
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
+
+int host_trace_dump(void)
+{
+#if defined(CONFIG_TRACING_BACKEND_RAM)
+    uint8_t cmd[] = "disable";
+
+    if (dumping) {
+        return -EBUSY;
+    }
+
+    // Stop first so the dump does not trace itself
+    tracing_cmd_handle(cmd, sizeof(cmd) - 1);
+    dumping = true;
+    k_sem_give(&dump_sem);
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
@@ -0,0 +1,66 @@
+#ifndef HOST_TRACE_H
+#define HOST_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(CONFIG_TRACING)
+#include <zephyr/tracing/tracing.h>
+#endif
+
+// ========================================
+// EVENT TRACING CONFIGURATION
+// ========================================
+// Built with tracing.conf, Zephyr CTF tracing records thread switches,
+// interrupts and the named Host events below into a RAM buffer. Recording
+// starts with control command CMD_TRACE (1) and runs until the buffer is
+// full; CMD_TRACE (0) stops it and dumps the buffer on the console as
+//   TRACE,BEGIN,<bytes>
+//   TRACE,<offset>,<hex>
+//   TRACE,END,<bytes>
+// host_trace.py turns a log holding the dump into a timeline.
+// Without CONFIG_TRACING every call compiles to nothing.
+
+// Named events (CTF named_event, name and two arguments)
+#define HOST_TRACE_MODE             "mode"          // arg0: HOST_TRACE_MODE_*
+#define HOST_TRACE_SCAN_REPORT      "scan_report"   // arg0: tag RSSI (int8), arg1: PHY
+#define HOST_TRACE_NOTIFY           "notify"        // arg0: tag id, arg1: error (0 = sent)
+#define HOST_TRACE_COMMAND          "command"       // arg0: command byte, arg1: length
+#define HOST_TRACE_COMMAND_DONE     "command_done"  // arg0: command byte, arg1: result
+
+#define HOST_TRACE_MODE_ADVERTISING 0
+#define HOST_TRACE_MODE_SCANNING    1
+
+// Bytes per dump line
+#define HOST_TRACE_DUMP_CHUNK       32
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Record a named Host event
+ * @param name HOST_TRACE_* event name
+ * @param arg0 First argument
+ * @param arg1 Second argument
+ */
+static inline void host_trace_event(const char *name, uint32_t arg0, uint32_t arg1)
+{
+#if defined(CONFIG_TRACING)
+    sys_trace_named_event(name, arg0, arg1);
+#endif
+}
+
+/**
+ * Start recording into the RAM buffer
+ * @return 0 on success, -ENOTSUP without tracing
+ */
+int host_trace_start(void);
+
+/**
+ * Stop recording and dump the buffer on the console (in the background)
+ * @return 0 on success, -ENOTSUP without RAM tracing, -EBUSY while dumping
+ */
+int host_trace_dump(void);
+
+#endif // HOST_TRACE_H
@@ -5,9 +5,29 @@
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/hci.h>
 #include <zephyr/bluetooth/gap.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/atomic.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include "app_reconnect.h"
+#include "app_time.h"
 #include "ble_service.h"
+#include "host_beacon.h"
+#include "host_energy.h"
+#include "host_metrics.h"
+#include "host_telemetry.h"
+#include "host_trace.h"
+#include "mipe_tracker.h"
+#include "mipe_adv.h"
+#include "mipe_clock.h"
+#include "mipe_pa_sync.h"
+#include "mipe_presence.h"
+#include "mipe_scanner.h"
+#include "mipe_sync.h"
+#include "rssi_trace.h"
+#include "scan_load.h"
+#include "scan_predictor.h"
 
 LOG_MODULE_REGISTER(host_main, LOG_LEVEL_INF);
 
@@ -32,28 +52,56 @@ static const uint32_t RSSI_SEND_INTERVAL = 100; // Send RSSI every 100ms
 // MIPE DETECTION AND SCANNING
 // ========================================
 
-// Mipe scanning state
+// Mipe scanning state (per-tag state lives in mipe_tracker)
 static bool mipe_scanning_active = false;
-static bool mipe_device_found = false;
-static char mipe_device_addr[BT_ADDR_LE_STR_LEN] = {0};
-static int8_t mipe_rssi_value = -100; // Default RSSI value
-static bt_addr_le_t mipe_addr_le;
-static uint32_t last_mipe_detection = 0; // Track when Mipe was last seen
+static const uint32_t MIPE_EXPIRE_TIMEOUT = 10000; // Forget absent tags not seen for 10 seconds
+
+// Maximum RSSI notifications per send interval, shared round-robin across tags
+static const int STREAM_BURST_MAX = 4;
+
+// Connected measurement: retry period for (re)creating the Mipe link
+static const uint32_t MIPE_LINK_RETRY_INTERVAL = 2000;
+static uint32_t last_link_attempt = 0;
+
+// Sync with a beacon-mode tag waits for its connectable window
+static const uint32_t MIPE_SYNC_WINDOW_WAIT = 35000;   // Longer than the Mipe window period
+static const uint32_t MIPE_CONNECTABLE_FRESH = 300;    // Connectable report still usable
+static bool sync_pending = false;
+static bt_addr_le_t pending_sync_addr;
+static uint32_t sync_pending_since = 0;
+
+// Clock model refresh: periodic sync with the strongest tag
+static uint32_t last_clock_refresh = 0;
+
+// App commands that touch the scanner or the Mipe link. The control write
+// callback (Bluetooth RX context) only posts them; the main loop runs them.
+enum control_request {
+    CONTROL_REQ_MIPE_SYNC,
+    CONTROL_REQ_MEASURE_MODE,
+    CONTROL_REQ_COUNT,
+};
+static ATOMIC_DEFINE(control_requests, CONTROL_REQ_COUNT);
+static atomic_t requested_measure_mode = ATOMIC_INIT(MEASURE_MODE_ADVERTISEMENT);
 
 // Mipe device information
-static const char *MIPE_EXPECTED_NAME = "MIPE";
-static const size_t MIPE_NAME_LENGTH = 4;
+static const char *MIPE_EXPECTED_NAME = MIPE_ADV_NAME;
 
 // Time-multiplexed scanning/advertising state
 static bool scanning_mode = false;
 static uint32_t last_mode_switch = 0;
 static const uint32_t SCAN_INTERVAL = 5000;   // 5 seconds scanning (reduced for faster Mipe detection)
 static const uint32_t ADVERTISE_INTERVAL = 3000; // 3 seconds advertising (reduced for faster switching)
+static const uint32_t SCAN_DISCOVERY_INTERVAL = 1000; // Shorter scan while predicted windows follow the tag
 
 // BLE scanning parameters
+// Long-range tags advertise on the Coded PHY: scan it alongside 1M
+#ifndef MIPE_SCAN_CODED
+#define MIPE_SCAN_CODED 1
+#endif
+
 static struct bt_le_scan_param scan_param = {
     .type = BT_LE_SCAN_TYPE_PASSIVE,
-    .options = BT_LE_SCAN_OPT_NONE,
+    .options = MIPE_SCAN_CODED ? BT_LE_SCAN_OPT_CODED : BT_LE_SCAN_OPT_NONE,
     .interval = BT_GAP_SCAN_FAST_INTERVAL,
     .window = BT_GAP_SCAN_FAST_WINDOW,
 };
@@ -70,93 +118,108 @@ static const struct bt_data ad[] = {
 
 /* Advertising parameters - standard intervals (100ms) */
 static struct bt_le_adv_param adv_param = BT_LE_ADV_PARAM_INIT(
-    BT_LE_ADV_OPT_CONN,
+    BT_LE_ADV_OPT_CONN | BT_LE_ADV_OPT_USE_IDENTITY,
     BT_GAP_ADV_FAST_INT_MIN_2,  /* 100ms min */
     BT_GAP_ADV_FAST_INT_MAX_2,  /* 100ms max - consistent interval */
     NULL
 );
 
+// Energy accounting: advertising event period and continuous scan receive duty
+#define ADV_EVENT_PERIOD_US     BT_GAP_ADV_INTERVAL_TO_US(BT_GAP_ADV_FAST_INT_MIN_2)
+#define SCAN_DUTY_PERMILLE      (BT_GAP_SCAN_FAST_WINDOW * 1000U / BT_GAP_SCAN_FAST_INTERVAL)
+
 // ========================================
 // MIPE SCANNING AND DETECTION
 // ========================================
 
 /**
- * BLE scanning callback - detects Mipe devices and gets real RSSI
+ * Scan report handling - detects Mipe devices and gets real RSSI
+ * Accepts connectable, scannable and non-connectable (beacon) legacy
+ * advertising as well as extended advertising. Trace replay feeds
+ * rebuilt reports here on its virtual clock.
  */
-static void scan_cb(const bt_addr_le_t *addr, int8_t rssi, uint8_t adv_type,
-                   struct net_buf_simple *buf)
+static void handle_scan_report(const struct bt_le_scan_recv_info *recv_info,
+                               struct net_buf_simple *buf, uint32_t now)
 {
+    struct mipe_adv_info info;
+    
+    host_energy_on_scan_report();
+    
+    switch (recv_info->adv_type) {
+    case BT_GAP_ADV_TYPE_ADV_IND:
+    case BT_GAP_ADV_TYPE_ADV_SCAN_IND:
+    case BT_GAP_ADV_TYPE_ADV_NONCONN_IND:
+    case BT_GAP_ADV_TYPE_EXT_ADV:
+        break;
+    default:
+        return;
+    }
+    
+    // Identify by telemetry (or name for older firmware) - ONLY Mipe, no fallbacks!
+    if (!mipe_adv_parse(buf, &info)) {
+        return;
+    }
+    
+    const bt_addr_le_t *addr = recv_info->addr;
+    bool connectable = (recv_info->adv_props & BT_GAP_ADV_PROP_CONNECTABLE) != 0;
     char addr_str[BT_ADDR_LE_STR_LEN];
+    
+    host_trace_event(HOST_TRACE_SCAN_REPORT, (uint8_t)recv_info->rssi, recv_info->primary_phy);
+    
     bt_addr_le_to_str(addr, addr_str, sizeof(addr_str));
+    LOG_DBG("MIPE report: %s RSSI %d dBm%s", addr_str, recv_info->rssi,
+            connectable ? "" : " (beacon)");
     
-    // Check if this is a Mipe device by looking for the expected name
-    if (adv_type == BT_GAP_ADV_TYPE_ADV_IND ||
-        adv_type == BT_GAP_ADV_TYPE_ADV_SCAN_IND) {
+    // Load test reports (scan_load.h) only go as far as the tag table
+    if (!mipe_tracker_is_synthetic(addr)) {
+        // Raw matched report for offline filter tuning (capture builds only)
+        rssi_trace_capture(addr, recv_info->rssi, recv_info->adv_type, connectable,
+                           recv_info->primary_phy, info.has_telemetry ? &info.telemetry : NULL,
+                           now);
+        host_telemetry_sample(HOST_TELEMETRY_SRC_SCAN, addr, recv_info->rssi,
+                              recv_info->primary_phy, connectable,
+                              info.has_telemetry ? &info.telemetry : NULL);
         
-        // Parse advertising data to find device name
-        bool name_found = false;
-        char device_name[32] = {0};
-        
-        // Create a copy of the buffer to parse
-        struct net_buf_simple temp_buf = *buf;
-        
-        while (temp_buf.len > 0) {
-            if (temp_buf.len < 2) break;
-            
-            uint8_t len = net_buf_simple_pull_u8(&temp_buf);
-            if (len == 0 || len > temp_buf.len) break;
-            
-            uint8_t type = net_buf_simple_pull_u8(&temp_buf);
-            
-            if (type == BT_DATA_NAME_COMPLETE || type == BT_DATA_NAME_SHORTENED) {
-                if (len > 1) {
-                    int name_len = MIN(len - 1, sizeof(device_name) - 1);
-                    memcpy(device_name, temp_buf.data, name_len);
-                    device_name[name_len] = '\0';
-                    name_found = true;
-                    break;
-                }
-            }
-            
-            // Skip the data
-            if (len > 1) {
-                net_buf_simple_pull(&temp_buf, len - 1);
-            }
-        }
-        
-        // Log all devices found during scanning for debugging
-        if (name_found) {
-            LOG_INF("SCAN: Found device '%s' at %s (RSSI: %d dBm)", 
-                   device_name, addr_str, rssi);
-        } else {
-            LOG_INF("SCAN: Found unnamed device at %s (RSSI: %d dBm)", 
-                   addr_str, rssi);
-        }
-        
-        // Check if this is a Mipe device - ONLY use MIPE, no fallbacks!
-        if (name_found && strncmp(device_name, MIPE_EXPECTED_NAME, MIPE_NAME_LENGTH) == 0) {
-            LOG_INF("=== MIPE DEVICE DETECTED ===");
-            LOG_INF("Address: %s", addr_str);
-            LOG_INF("Name: %s", device_name);
-            LOG_INF("RSSI: %d dBm", rssi);
-            LOG_INF("==========================");
-            
-            // Store Mipe device information
-            mipe_device_found = true;
-            strcpy(mipe_device_addr, addr_str);
-            mipe_rssi_value = rssi; // Real RSSI value!
-            memcpy(&mipe_addr_le, addr, sizeof(bt_addr_le_t));
-            last_mipe_detection = k_uptime_get(); // Update detection time
-            
-            // Don't stop scanning - let it continue to update RSSI
-        } else if (name_found) {
-            // Log other devices but don't store their RSSI
-            LOG_INF("Found other device: %s at %s (RSSI: %d dBm) - IGNORING", 
-                   device_name, addr_str, rssi);
-        }
+        // Learn the advertising timing for predicted scan windows
+        scan_predictor_report(addr, recv_info->primary_phy);
+    }
+    
+    // Store the report in the tag table (keyed by address)
+    int err = mipe_tracker_report(addr, recv_info->rssi, connectable, recv_info->primary_phy,
+                                  now);
+    if (err) {
+        LOG_WRN("Mipe tracker full - dropping report from %s", addr_str);
+        return;
     }
+    
+    if (info.has_telemetry) {
+        mipe_tracker_report_telemetry(addr, info.telemetry.seq, info.telemetry.tx_power,
+                                      info.telemetry.battery_percent,
+                                      info.telemetry.uptime_s,
+                                      info.telemetry.interval_ceiling_ms);
+    }
+    
+    // Tags running a periodic train: sync to it so samples arrive at known instants
+    if (recv_info->interval != 0) {
+        mipe_pa_sync_on_report(addr, recv_info->sid, recv_info->interval);
+    }
+    
+    // Don't stop scanning - let it continue to update RSSI
+}
+
+/**
+ * BLE scanning callback
+ */
+static void scan_recv(const struct bt_le_scan_recv_info *recv_info,
+                      struct net_buf_simple *buf)
+{
+    handle_scan_report(recv_info, buf, k_uptime_get_32());
 }
 
+static struct bt_le_scan_cb scan_callbacks = {
+    .recv = scan_recv,
+};
+
 /**
  * Switch between advertising and scanning modes
  */
@@ -164,18 +227,34 @@ static int switch_to_scanning_mode(void)
 {
     int err;
     
+    // Replay feeds recorded reports instead of live ones
+    if (RSSI_TRACE_REPLAY) {
+        return -EPERM;
+    }
+    
+    // A Mipe sync needs the scanner idle to create its connection
+    if (mipe_sync_is_busy()) {
+        LOG_INF("Mipe sync in progress - postponing scan");
+        return -EBUSY;
+    }
+    
     // Stop advertising first
     if (advertising_active) {
         bt_le_adv_stop();
         advertising_active = false;
+        host_energy_set(HOST_ENERGY_ADVERTISING, false, 0);
         LOG_INF("Advertising stopped for scanning mode");
     }
     
     // Wait a moment for advertising to fully stop
     k_msleep(100);
     
+    // Continuous scanning replaces the predicted windows
+    scan_predictor_enable(false);
+    
     // Start BLE scanning
-    err = bt_le_scan_start(&scan_param, scan_cb);
+    // Reports arrive through the registered scan_callbacks
+    err = bt_le_scan_start(&scan_param, NULL);
     if (err) {
         LOG_ERR("Failed to start scanning: %d", err);
         return err;
@@ -183,6 +262,10 @@ static int switch_to_scanning_mode(void)
     
     scanning_mode = true;
     mipe_scanning_active = true;
+    host_energy_set(HOST_ENERGY_SCANNING, true, SCAN_DUTY_PERMILLE);
+    mipe_presence_set_scanning(true);
+    host_trace_event(HOST_TRACE_MODE, HOST_TRACE_MODE_SCANNING, 0);
+    host_telemetry_event(HOST_TELEMETRY_EV_MODE, 1, 0);
     LOG_INF("=== SWITCHED TO SCANNING MODE ===");
     LOG_INF("Looking for device named '%s'", MIPE_EXPECTED_NAME);
     LOG_INF("================================");
@@ -197,6 +280,8 @@ static int switch_to_advertising_mode(void)
     if (mipe_scanning_active) {
         bt_le_scan_stop();
         mipe_scanning_active = false;
+        mipe_presence_set_scanning(false);
+        host_energy_set(HOST_ENERGY_SCANNING, false, 0);
         LOG_INF("Scanning stopped for advertising mode");
     }
     
@@ -212,6 +297,13 @@ static int switch_to_advertising_mode(void)
     
     scanning_mode = false;
     advertising_active = true;
+    host_energy_set(HOST_ENERGY_ADVERTISING, true, ADV_EVENT_PERIOD_US);
+    
+    // Keep receiving the tag in short windows around its predicted arrivals
+    scan_predictor_enable(true);
+    
+    host_trace_event(HOST_TRACE_MODE, HOST_TRACE_MODE_ADVERTISING, 0);
+    host_telemetry_event(HOST_TELEMETRY_EV_MODE, 0, 0);
     LOG_INF("=== SWITCHED TO ADVERTISING MODE ===");
     LOG_INF("Device name: MIPE_HOST_A1B2");
     LOG_INF("================================");
@@ -223,59 +315,407 @@ static int switch_to_advertising_mode(void)
 
 
 /**
- * Check if Mipe device is available and update RSSI
+ * Log one tracked tag
+ */
+static void log_tag(const struct mipe_tag *tag)
+{
+    char addr_str[BT_ADDR_LE_STR_LEN];
+    bt_addr_le_to_str(&tag->addr, addr_str, sizeof(addr_str));
+    
+    LOG_INF("  Tag %u: %s RSSI %d dBm (filtered %d dBm, %u reports, %u streamed)",
+            tag->id, addr_str, tag->last_rssi, mipe_tag_filtered_rssi(tag),
+            tag->stats.reports, tag->stats.streamed);
+    
+    if (tag->telemetry.valid) {
+        uint32_t loss = mipe_tag_loss_permille(tag);
+        
+        LOG_INF("    seq %u, versions missed while observable %u.%u%% (%u/%u), tx %d dBm, normalized %d dBm, "
+                "battery %u%%, uptime %u s",
+                tag->telemetry.seq, loss / 10, loss % 10, tag->stats.seq_received,
+                tag->stats.seq_expected, tag->telemetry.tx_power,
+                mipe_tag_normalized_rssi(tag), tag->telemetry.battery_percent,
+                tag->telemetry.uptime_s);
+    }
+    
+    // Range and stability per primary PHY (1M vs Coded long range)
+    static const char *const phy_names[MIPE_PHY_COUNT] = { "1M", "Coded" };
+    for (int phy = 0; phy < MIPE_PHY_COUNT; phy++) {
+        int32_t mean_x10;
+        uint32_t stddev_x10;
+        uint32_t reports = mipe_tag_phy_rssi(tag, phy, &mean_x10, &stddev_x10);
+        
+        if (reports > 0) {
+            LOG_INF("    %s: %u reports, mean %d.%u dBm, stddev %u.%u dB, min %d, max %d",
+                    phy_names[phy], reports, mean_x10 / 10, (unsigned int)(abs(mean_x10) % 10),
+                    stddev_x10 / 10, stddev_x10 % 10,
+                    tag->phy[phy].rssi_min, tag->phy[phy].rssi_max);
+        }
+    }
+    
+    const struct mipe_tag_presence *presence = &tag->presence;
+    if (presence->k > 0) {
+        LOG_INF("    presence: %s, interval %u ms, %u.%02u events/report, absent after %u missed "
+                "(%u ms)", presence->present ? "PRESENT" : "ABSENT",
+                presence->interval_q4 >> 4, presence->events_q8 >> 8,
+                (presence->events_q8 & 0xFF) * 100 / 256, presence->k, presence->timeout_ms);
+    } else {
+        LOG_INF("    presence: %s, learning (timeout %u ms)",
+                presence->present ? "PRESENT" : "ABSENT", presence->timeout_ms);
+    }
+    
+    struct mipe_clock_info clock;
+    if (mipe_clock_get(&tag->addr, &clock) == 0) {
+        LOG_INF("    clock: offset %lld us, drift %s%d.%03d ppm%s, error %u us, "
+                "%u samples over %u s",
+                clock.offset_us, clock.drift_ppb < 0 ? "-" : "",
+                abs(clock.drift_ppb) / 1000, abs(clock.drift_ppb) % 1000,
+                clock.drift_valid ? "" : " (not settled)", clock.error_us,
+                clock.samples, clock.span_ms / 1000);
+    }
+}
+
+/**
+ * Log every tracked tag from snapshots (logging never runs under the tracker lock)
+ */
+static void log_tags(void)
+{
+    struct mipe_tag tag;
+    uint32_t cursor = 0;
+    
+    while (mipe_tracker_next(&cursor, &tag)) {
+        log_tag(&tag);
+    }
+}
+
+/**
+ * Check which Mipe tags are still available and log their RSSI
  */
 static void check_mipe_status(void)
 {
     static uint32_t last_status_check = 0;
-    static uint32_t last_rssi_update = 0;
-    uint32_t current_time = k_uptime_get();
+    uint32_t current_time = k_uptime_get_32();
     
-    // Check if Mipe device has been lost (not detected for 10 seconds)
-    if (mipe_device_found && (current_time - last_mipe_detection >= 10000)) {
+    // Loss is reported by the presence detector; this only frees table entries
+    int lost = mipe_tracker_expire(current_time, MIPE_EXPIRE_TIMEOUT);
+    if (lost > 0) {
         LOG_INF("=== MIPE DEVICE LOST ===");
-        LOG_INF("No Mipe device detected for 10 seconds");
-        LOG_INF("Clearing Mipe device state");
+        LOG_INF("%d absent tag(s) not detected for %u ms", lost, MIPE_EXPIRE_TIMEOUT);
         LOG_INF("==========================");
-        
-        // Clear Mipe device state
-        mipe_device_found = false;
-        mipe_rssi_value = -100;
-        memset(mipe_device_addr, 0, sizeof(mipe_device_addr));
-        memset(&mipe_addr_le, 0, sizeof(bt_addr_le_t));
     }
     
     // Check every 10 seconds
     if (current_time - last_status_check >= 10000) {
-        if (mipe_device_found) {
-            LOG_INF("Mipe device available for RSSI reading - Current RSSI: %d dBm", mipe_rssi_value);
+        int count = mipe_tracker_count();
+        if (count > 0) {
+            struct mipe_tracker_perf perf;
+            mipe_tracker_get_perf(&perf);
+            
+            LOG_INF("Tracking %d Mipe tag(s):", count);
+            log_tags();
+            if (perf.lookups > 0 && perf.reports > 0) {
+                LOG_INF("Tracker lookups: %u, avg probes x100: %u, max probes: %u, avg cycles/report: %u",
+                        perf.lookups, perf.probes * 100 / perf.lookups, perf.max_probes,
+                        perf.cycles / perf.reports);
+            }
         } else {
             LOG_INF("Mipe device not found - will scan during next scan cycle");
         }
         last_status_check = current_time;
     }
+}
+
+/**
+ * Stream fresh RSSI samples to the App, round-robin across tracked tags
+ */
+static void stream_rssi_samples(uint32_t current_time)
+{
+    struct mipe_tag tag;
+    int sent = 0;
+    
+    while (sent < STREAM_BURST_MAX && mipe_tracker_next_for_stream(&tag)) {
+        int8_t rssi = mipe_tag_filtered_rssi(&tag);
+        
+        if (app_connected) {
+            // Send RSSI data via BLE service to App
+            int err = ble_service_send_rssi_data(tag.id, rssi, current_time, tag.last_phy);
+            if (err) {
+                // The tag keeps its turn and is sent first on the next pass
+                LOG_ERR("Failed to send RSSI data to App: %d", err);
+                break;
+            }
+            host_metrics_on_sample_sent(current_time - tag.last_seen);
+            LOG_INF("RSSI data sent to App: tag %u, %d dBm, stream count: %u",
+                    tag.id, rssi, stream_counter);
+        } else {
+            // App not connected - just log the RSSI reading
+            LOG_INF("RSSI reading (no App): tag %u, %d dBm, stream count: %u",
+                    tag.id, rssi, stream_counter);
+        }
+        mipe_tracker_mark_streamed(&tag.addr, current_time);
+        rssi_trace_on_notify(tag.id, rssi, current_time, tag.last_phy);
+        stream_counter++;
+        sent++;
+    }
     
-    // Update RSSI every 2 seconds if Mipe is found
-    if (mipe_device_found && (current_time - last_rssi_update >= 2000)) {
-        LOG_INF("RSSI update: %d dBm", mipe_rssi_value);
-        last_rssi_update = current_time;
+    if (sent > 0) {
+        last_rssi_send = current_time;
+    } else if (mipe_tracker_count() == 0) {
+        LOG_WRN("Skipping RSSI send - no valid Mipe RSSI available");
     }
 }
 
-// ========================================
-// RSSI DATA GENERATION
-// ========================================
+/**
+ * Check whether a tag snapshot accepts a connection now
+ * Tags that always advertise connectable do; beacon-mode tags only inside
+ * a connectable window that was seen just now.
+ */
+static bool tag_accepts_connection(const struct mipe_tag *tag, uint32_t current_time)
+{
+    if (!tag->connectable) {
+        return false;
+    }
+    
+    return !tag->beacon || (current_time - tag->last_connectable) < MIPE_CONNECTABLE_FRESH;
+}
 
-static int8_t generate_rssi_value(void)
+/**
+ * Pick the tag with the strongest filtered RSSI (mipe_tracker_foreach callback)
+ */
+struct best_tag {
+    bool connectable_only;  // In: skip tags that can't take a connection now
+    uint32_t now;           // In: uptime for the connectable check
+    bool found;
+    bt_addr_le_t addr;
+    int8_t rssi;
+    uint8_t phy;
+};
+
+// Compare on normalized RSSI so a tag with a louder radio doesn't always win
+static void find_best_tag(const struct mipe_tag *tag, void *user_data)
 {
-    if (mipe_device_found) {
-        // Use real RSSI from Mipe device
-        LOG_INF("Using real RSSI from Mipe device: %d dBm", mipe_rssi_value);
-        return mipe_rssi_value;
+    struct best_tag *best = user_data;
+    int8_t rssi = mipe_tag_normalized_rssi(tag);
+    
+    if (best->connectable_only && !tag_accepts_connection(tag, best->now)) {
+        return;
+    }
+    
+    if (!best->found || rssi > best->rssi) {
+        best->found = true;
+        bt_addr_le_copy(&best->addr, &tag->addr);
+        best->rssi = rssi;
+        best->phy = tag->last_phy;
+    }
+}
+
+/**
+ * Connected measurement mode: keep a persistent link to the strongest tag
+ */
+static void maintain_mipe_link(uint32_t current_time)
+{
+    // Beacon-mode tags (the Mipe default) refuse connections outside their windows
+    struct best_tag best = { .connectable_only = true, .now = current_time, .found = false };
+    
+    if (!mipe_scanner_is_connected_mode() || mipe_scanner_is_link_busy() ||
+        mipe_sync_is_busy()) {
+        return;
+    }
+    
+    if (current_time - last_link_attempt < MIPE_LINK_RETRY_INTERVAL) {
+        return;
+    }
+    
+    mipe_tracker_foreach(find_best_tag, &best);
+    if (!best.found) {
+        return;
+    }
+    
+    last_link_attempt = current_time;
+    
+    // Connection creation requires the scanner to be idle
+    if (mipe_scanning_active) {
+        bt_le_scan_stop();
+        mipe_scanning_active = false;
+        mipe_presence_set_scanning(false);
+        host_energy_set(HOST_ENERGY_SCANNING, false, 0);
+        LOG_INF("Scanning stopped to create Mipe link");
+    }
+    bool predicting = scan_predictor_is_enabled();
+    scan_predictor_enable(false);
+    
+    int err = mipe_scanner_connect_to_mipe(&best.addr, best.phy);
+    if (err) {
+        LOG_ERR("Failed to create Mipe link: %d", err);
+    }
+    
+    // Windows are skipped while the link is being created
+    scan_predictor_enable(predicting);
+}
+
+/**
+ * Start a Mipe sync, stopping the scanner first (connection creation needs it idle)
+ */
+static void start_mipe_sync(const bt_addr_le_t *addr)
+{
+    struct mipe_tag tag;
+    uint8_t phy = mipe_tracker_get(addr, &tag) ? tag.last_phy : BT_GAP_LE_PHY_1M;
+    
+    if (mipe_scanning_active) {
+        bt_le_scan_stop();
+        mipe_scanning_active = false;
+        mipe_presence_set_scanning(false);
+        host_energy_set(HOST_ENERGY_SCANNING, false, 0);
+        LOG_INF("Scanning stopped for Mipe sync");
+    }
+    bool predicting = scan_predictor_is_enabled();
+    scan_predictor_enable(false);
+    
+    int err = mipe_sync_start(addr, phy);
+    if (err) {
+        LOG_ERR("Failed to start Mipe sync: %d", err);
+    } else {
+        LOG_INF("Mipe sync transaction started");
+    }
+    
+    // Windows are skipped while the sync is busy
+    scan_predictor_enable(predicting);
+}
+
+/**
+ * Check whether a tracked tag accepts a connection now
+ */
+static bool tag_is_connectable(const bt_addr_le_t *addr, uint32_t current_time)
+{
+    struct mipe_tag tag;
+    
+    return mipe_tracker_get(addr, &tag) && tag_accepts_connection(&tag, current_time);
+}
+
+/**
+ * Sync with a tag now, or once its connectable window opens (beacon mode)
+ * @param addr Tag address
+ * @param notify_app Report the waiting state to the App
+ */
+static void request_mipe_sync(const bt_addr_le_t *addr, bool notify_app)
+{
+    if (mipe_sync_is_busy() || sync_pending) {
+        LOG_INF("Mipe sync already in progress");
+    } else if (!tag_is_connectable(addr, k_uptime_get_32())) {
+        // Beacon mode - the main loop starts the sync in the next connectable window
+        bt_addr_le_copy(&pending_sync_addr, addr);
+        sync_pending_since = k_uptime_get_32();
+        sync_pending = true;
+        LOG_INF("Mipe is in beacon mode - sync waits for its connectable window");
+        if (notify_app) {
+            ble_service_send_log_data("SYNC WAITING for connectable window");
+        }
     } else {
-        // No Mipe device found - return invalid RSSI
-        LOG_WRN("No Mipe device found - returning invalid RSSI (-100)");
-        return -100; // Invalid RSSI value
+        start_mipe_sync(addr);
+    }
+}
+
+/**
+ * Refresh the clock model of the strongest tag with a periodic sync
+ */
+static void refresh_mipe_clock(uint32_t current_time)
+{
+    struct best_tag best = { .found = false };
+    
+    if (MIPE_CLOCK_REFRESH_MS == 0 ||
+        current_time - last_clock_refresh < MIPE_CLOCK_REFRESH_MS ||
+        mipe_sync_is_busy() || sync_pending) {
+        return;
+    }
+    
+    mipe_tracker_foreach(find_best_tag, &best);
+    if (!best.found) {
+        return;
+    }
+    
+    last_clock_refresh = current_time;
+    LOG_INF("Refreshing Mipe clock model");
+    request_mipe_sync(&best.addr, false);
+}
+
+/**
+ * Sync requested by the App: report what is tracked, then sync with the strongest tag
+ */
+static void run_mipe_sync_request(void)
+{
+    LOG_INF("Mipe scanning status: %s", mipe_scanning_active ? "ACTIVE" : "INACTIVE");
+    LOG_INF("Mipe tags tracked: %d", mipe_tracker_count());
+    
+    if (mipe_tracker_count() > 0) {
+        LOG_INF("Mipe device details:");
+        log_tags();
+        LOG_INF("  - Expected name: %s", MIPE_EXPECTED_NAME);
+        LOG_INF("Mipe device is AVAILABLE for RSSI reading");
+    } else {
+        LOG_INF("Mipe device NOT FOUND");
+        LOG_INF("Expected Mipe name: %s", MIPE_EXPECTED_NAME);
+        LOG_INF("Expected telemetry: company 0x%04x, format 0x%02x", MIPE_MFG_COMPANY_ID, MIPE_MFG_FORMAT_ID);
+        LOG_INF("Mipe device is NOT AVAILABLE for RSSI reading");
+    }
+    
+    LOG_INF("Current streaming state: %s", streaming_active ? "ACTIVE" : "INACTIVE");
+    
+    // Sync with the strongest tag: connect, read battery + clock, disconnect
+    struct best_tag best = { .found = false };
+    mipe_tracker_foreach(find_best_tag, &best);
+    
+    if (!best.found) {
+        LOG_INF("Mipe sync skipped - no tag to sync with");
+        ble_service_send_log_data("SYNC FAILED no Mipe found");
+    } else {
+        request_mipe_sync(&best.addr, true);
+    }
+}
+
+/**
+ * Run the App commands posted by the control write callback
+ */
+static void service_control_requests(uint32_t current_time)
+{
+    if (atomic_test_and_clear_bit(control_requests, CONTROL_REQ_MEASURE_MODE)) {
+        bool connected = atomic_get(&requested_measure_mode) == MEASURE_MODE_CONNECTED;
+        
+        mipe_scanner_set_connected_mode(connected);
+        last_link_attempt = current_time - MIPE_LINK_RETRY_INTERVAL;
+    }
+    
+    if (atomic_test_and_clear_bit(control_requests, CONTROL_REQ_MIPE_SYNC)) {
+        run_mipe_sync_request();
+    }
+}
+
+/**
+ * Beacon-mode tags: keep scanning until the tag advertises connectable, then sync
+ */
+static void service_pending_sync(uint32_t current_time)
+{
+    if (!sync_pending) {
+        return;
+    }
+    
+    if (current_time - sync_pending_since >= MIPE_SYNC_WINDOW_WAIT) {
+        sync_pending = false;
+        LOG_WRN("Mipe sync abandoned - no connectable window within %u ms",
+                MIPE_SYNC_WINDOW_WAIT);
+        ble_service_send_log_data("SYNC FAILED no connectable window");
+        return;
+    }
+    
+    if (!scanning_mode) {
+        switch_to_scanning_mode();
+        last_mode_switch = current_time;
+        return;
+    }
+    
+    if (tag_is_connectable(&pending_sync_addr, current_time)) {
+        sync_pending = false;
+        LOG_INF("Connectable window after %u ms - starting deferred sync",
+                current_time - sync_pending_since);
+        start_mipe_sync(&pending_sync_addr);
     }
 }
 
@@ -292,6 +732,21 @@ static void bt_ready(int err)
 
     LOG_INF("Bluetooth initialized");
     LOG_INF("BLE Peripheral mode ready");
+    
+    // Restore bonds and their CCC state: a returning App keeps its subscriptions
+    // and, with the database hash unchanged, skips service discovery
+    if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
+        err = settings_load();
+        if (err) {
+            LOG_WRN("Failed to load bonds: %d", err);
+        }
+    }
+
+    // Status beacon for observers that don't connect (runs beside the TMT1 set)
+    err = host_beacon_start();
+    if (err) {
+        LOG_WRN("Status beacon not available: %d", err);
+    }
 
     // Start advertising
     err = bt_le_adv_start(&adv_param, ad, ARRAY_SIZE(ad), NULL, 0);
@@ -301,6 +756,8 @@ static void bt_ready(int err)
     }
 
     advertising_active = true;
+    host_energy_set(HOST_ENERGY_ADVERTISING, true, ADV_EVENT_PERIOD_US);
+    scan_predictor_enable(true);
     LOG_INF("Advertising started - Device name: MIPE_HOST_A1B2");
 }
 
@@ -308,9 +765,31 @@ static void bt_ready(int err)
 // CONNECTION CALLBACKS
 // ========================================
 
+/**
+ * Check if a connection is the Host's central link to a Mipe (handled by mipe_scanner)
+ */
+static bool is_mipe_link(struct bt_conn *conn)
+{
+    struct bt_conn_info info;
+    
+    return bt_conn_get_info(conn, &info) == 0 && info.role == BT_CONN_ROLE_CENTRAL;
+}
+
 static void connected(struct bt_conn *conn, uint8_t err)
 {
     char addr[BT_ADDR_LE_STR_LEN];
+    
+    if (is_mipe_link(conn)) {
+        return;
+    }
+    
+    // Directed advertising ended without the App: the policy moves on
+    if (err == BT_HCI_ERR_ADV_TIMEOUT) {
+        LOG_INF("Directed advertising timed out");
+        app_reconnect_on_directed_timeout();
+        return;
+    }
+    
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
     
     if (err) {
@@ -328,13 +807,32 @@ static void connected(struct bt_conn *conn, uint8_t err)
     LOG_INF("Previous connection state: %s", app_connected ? "CONNECTED" : "DISCONNECTED");
     LOG_INF("Previous advertising state: %s", advertising_active ? "ACTIVE" : "INACTIVE");
     
+    bool bonded = bt_addr_le_is_bonded(BT_ID_DEFAULT, bt_conn_get_dst(conn));
+    
     app_conn = bt_conn_ref(conn);
     app_connected = true;
     advertising_active = false;
+    host_metrics_on_app_connection(true, bonded, k_uptime_get_32());
+    app_reconnect_on_connected(k_uptime_get_32());
+    host_telemetry_event(HOST_TELEMETRY_EV_APP_LINK, 1, 0);
+    
+    // Connectable advertising ends with the connection
+    struct bt_conn_info info;
+    host_energy_set(HOST_ENERGY_ADVERTISING, false, 0);
+    if (bt_conn_get_info(conn, &info) == 0) {
+        host_energy_set(HOST_ENERGY_APP_LINK, true, BT_GAP_CONN_INTERVAL_TO_US(info.le.interval));
+    }
     
     LOG_INF("New connection state: %s", app_connected ? "CONNECTED" : "DISCONNECTED");
     LOG_INF("New advertising state: %s", advertising_active ? "ACTIVE" : "INACTIVE");
     LOG_INF("Connection object stored: %s", app_conn ? "Yes" : "No");
+    LOG_INF("Bonded App: %s", bonded ? "YES (cached GATT, stored CCC)" : "NO");
+    
+    // Ask for encryption: a new App bonds, a bonded one re-encrypts with its key
+    int sec_err = bt_conn_set_security(conn, BT_SECURITY_L2);
+    if (sec_err) {
+        LOG_WRN("Failed to request security: %d", sec_err);
+    }
     
     // Notify BLE service of connection
     LOG_INF("Notifying BLE service of new connection...");
@@ -349,6 +847,11 @@ static void connected(struct bt_conn *conn, uint8_t err)
 static void disconnected(struct bt_conn *conn, uint8_t reason)
 {
     char addr[BT_ADDR_LE_STR_LEN];
+    
+    if (is_mipe_link(conn)) {
+        return;
+    }
+    
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
     
     LOG_INF("=== APP DISCONNECTION DETECTED ===");
@@ -360,9 +863,17 @@ static void disconnected(struct bt_conn *conn, uint8_t reason)
     if (app_conn == conn) {
         LOG_INF("This is our active connection - processing disconnection...");
         
+        // Re-advertise to this App straight away (directed if bonded)
+        app_reconnect_on_disconnected(bt_conn_get_dst(conn),
+                                      bt_addr_le_is_bonded(BT_ID_DEFAULT, bt_conn_get_dst(conn)),
+                                      k_uptime_get_32());
+        
         bt_conn_unref(app_conn);
         app_conn = NULL;
         app_connected = false;
+        host_metrics_on_app_connection(false, false, k_uptime_get_32());
+        host_telemetry_event(HOST_TELEMETRY_EV_APP_LINK, 0, reason);
+        host_energy_set(HOST_ENERGY_APP_LINK, false, 0);
         
         LOG_INF("Connection object released and set to NULL");
         LOG_INF("App connection state set to: DISCONNECTED");
@@ -385,11 +896,104 @@ static void disconnected(struct bt_conn *conn, uint8_t reason)
     }
 }
 
+static void le_param_updated(struct bt_conn *conn, uint16_t interval,
+                             uint16_t latency, uint16_t timeout)
+{
+    if (conn != app_conn) {
+        return;
+    }
+    
+    host_energy_set(HOST_ENERGY_APP_LINK, true, BT_GAP_CONN_INTERVAL_TO_US(interval));
+}
+
+static void security_changed(struct bt_conn *conn, bt_security_t level,
+                             enum bt_security_err err)
+{
+    if (conn != app_conn) {
+        return;
+    }
+    
+    if (err) {
+        LOG_WRN("App security failed: level %u, err %d", level, err);
+    } else {
+        LOG_INF("App link encrypted: level %u", level);
+    }
+}
+
 static struct bt_conn_cb conn_callbacks = {
     .connected = connected,
     .disconnected = disconnected,
+    .le_param_updated = le_param_updated,
+    .security_changed = security_changed,
+};
+
+static void pairing_complete(struct bt_conn *conn, bool bonded)
+{
+    LOG_INF("App pairing complete (%s)", bonded ? "bonded" : "not bonded");
+}
+
+static void pairing_failed(struct bt_conn *conn, enum bt_security_err reason)
+{
+    LOG_WRN("App pairing failed: %d", reason);
+}
+
+static struct bt_conn_auth_info_cb auth_info_callbacks = {
+    .pairing_complete = pairing_complete,
+    .pairing_failed = pairing_failed,
 };
 
+// ========================================
+// MIPE SYNC
+// ========================================
+
+/**
+ * Mipe sync transaction finished - report result and per-phase timings to the App
+ */
+static void mipe_sync_done(const struct mipe_sync_result *result)
+{
+    char addr_str[BT_ADDR_LE_STR_LEN];
+    char log_msg[96];
+    
+    bt_addr_le_to_str(&result->addr, addr_str, sizeof(addr_str));
+    
+    LOG_INF("=== MIPE SYNC %s ===", result->err ? "FAILED" : "COMPLETE");
+    LOG_INF("Mipe: %s", addr_str);
+    LOG_INF("Result: %d", result->err);
+    LOG_INF("Battery: %u mV (%u%%)", result->battery_mv, result->battery_percent);
+    LOG_INF("Mipe clock: %u ms (Host %u ms, read round trip %u ms)",
+            result->mipe_clock_ms, result->host_clock_ms, result->clock_rtt_ms);
+    LOG_INF("Connect: %u ms, Read: %u ms, Disconnect: %u ms, Total: %u ms",
+            result->connect_ms, result->read_ms, result->disconnect_ms, result->total_ms);
+    LOG_INF("Cached handles: %s, Reused link: %s",
+            result->cached_handles ? "YES" : "NO", result->reused_link ? "YES" : "NO");
+    LOG_INF("================================");
+    
+    // The Mipe sampled its clock somewhere within the read round trip
+    if (result->err == 0) {
+        mipe_clock_add_sample(&result->addr, result->host_clock_ms - result->clock_rtt_ms / 2,
+                              result->mipe_clock_ms, result->clock_rtt_ms / 2);
+        last_clock_refresh = k_uptime_get_32();
+    }
+    
+    if (!app_connected) {
+        return;
+    }
+    
+    if (result->err == 0) {
+        ble_service_send_mipe_status(4, mipe_scanner_get_last_rssi(), result->addr.a.val,
+                                     result->total_ms, result->battery_mv / 1000.0f);
+        snprintf(log_msg, sizeof(log_msg),
+                 "SYNC OK conn=%ums read=%ums disc=%ums total=%ums bat=%umV%s",
+                 result->connect_ms, result->read_ms, result->disconnect_ms,
+                 result->total_ms, result->battery_mv,
+                 result->cached_handles ? " cached" : "");
+    } else {
+        snprintf(log_msg, sizeof(log_msg), "SYNC FAILED err=%d after %ums",
+                 result->err, result->total_ms);
+    }
+    ble_service_send_log_data(log_msg);
+}
+
 // ========================================
 // MAIN APPLICATION
 // ========================================
@@ -405,9 +1009,44 @@ int main(void)
 
     // Initialize BLE service FIRST (before Bluetooth stack)
     ble_service_init();
+    
+    // Initialize Mipe tag tracking table
+    mipe_tracker_init();
+    
+    // Initialize end-to-end metrics (discovery, delivery rate, loss, latency)
+    host_metrics_init();
+    
+    // Directed/fast advertising after an App disconnection
+    app_reconnect_init(ad, ARRAY_SIZE(ad));
+    
+    // Initialize RSSI trace capture/replay (build options, see rssi_trace.h)
+    rssi_trace_init(stream_rssi_samples, RSSI_SEND_INTERVAL, handle_scan_report);
+    
+    // Binary telemetry export (build option, see host_telemetry.h)
+    host_telemetry_init();
+    
+    // Initialize Mipe link handling (connected measurement mode)
+    mipe_scanner_init();
+    
+    // Initialize Mipe sync transaction handling
+    mipe_sync_init(mipe_sync_done);
+    
+    // Initialize per-tag clock models (filled by sync reads)
+    mipe_clock_init();
+    
+    // Initialize periodic advertising sync (callbacks must exist before bt_enable)
+    mipe_pa_sync_init();
+    
+    // Initialize predicted scan windows (same PHYs as continuous scanning)
+    scan_predictor_init(scan_param.options);
+    
+    // Start the presence detector (drives present/absent events to the App)
+    mipe_presence_init();
 
-    // Register connection callbacks
+    // Register connection and scan callbacks
     bt_conn_cb_register(&conn_callbacks);
+    bt_conn_auth_info_cb_register(&auth_info_callbacks);
+    bt_le_scan_cb_register(&scan_callbacks);
 
     // Initialize Bluetooth
     err = bt_enable(bt_ready);
@@ -415,7 +1054,13 @@ int main(void)
         LOG_ERR("Bluetooth init failed (err %d)", err);
         return -1;
     }
-
+    
+    // Scan path load test (build option, see scan_load.h)
+    if (SCAN_LOAD) {
+        scan_load_add("scan_recv", scan_recv);
+        scan_load_start();
+    }
+    
     LOG_INF("Host device initialization complete");
     
     // Initialize with advertising mode first
@@ -432,11 +1077,25 @@ int main(void)
         // Handle mode switching between advertising and scanning
         uint32_t current_time = k_uptime_get();
         
-        if (!app_connected) {
-            // Only switch modes when not connected to App
+        // Reconnect policy done without the App: normal advertising from now
+        if (app_reconnect_process(current_time)) {
+            switch_to_advertising_mode();
+            last_mode_switch = current_time;
+        }
+        
+        if (!app_connected && !app_reconnect_is_active()) {
+            // Only switch modes when not connected to App (or getting it back)
             if (scanning_mode) {
                 // In scanning mode - switch to advertising after scan interval
-                if (current_time - last_mode_switch >= SCAN_INTERVAL) {
+                // (keep scanning while a sync waits for a connectable window
+                // or a periodic sync is being established)
+                // Once the predictor follows the tag, scanning is only for discovery
+                struct scan_predictor_stats predictor;
+                scan_predictor_get_stats(&predictor);
+                uint32_t scan_time = predictor.state == SCAN_PREDICTOR_TRACK ?
+                                     SCAN_DISCOVERY_INTERVAL : SCAN_INTERVAL;
+                if (current_time - last_mode_switch >= scan_time && !sync_pending &&
+                    !mipe_pa_sync_is_pending()) {
                     switch_to_advertising_mode();
                     last_mode_switch = current_time;
                 }
@@ -448,8 +1107,8 @@ int main(void)
                 }
             }
         } else {
-            // App is connected - stay in advertising mode
-            if (scanning_mode) {
+            // App is connected - stay in advertising mode unless a sync needs the scanner
+            if (scanning_mode && !sync_pending) {
                 switch_to_advertising_mode();
                 last_mode_switch = current_time;
             }
@@ -463,9 +1122,102 @@ int main(void)
             LOG_INF("Advertising: %s", advertising_active ? "Active" : "Inactive");
             LOG_INF("Scanning: %s", mipe_scanning_active ? "Active" : "Inactive");
             LOG_INF("Streaming: %s (Count: %u)", streaming_active ? "Active" : "Inactive", stream_counter);
-            LOG_INF("Mipe device found: %s", mipe_device_found ? "YES" : "NO");
-            if (mipe_device_found) {
-                LOG_INF("Current Mipe RSSI: %d dBm", mipe_rssi_value);
+            LOG_INF("Mipe tags tracked: %d", mipe_tracker_count());
+            if (mipe_scanner_is_connected_mode()) {
+                uint32_t samples, errors;
+                mipe_scanner_get_link_stats(&samples, &errors);
+                LOG_INF("Mipe link: %s, RSSI samples: %u (errors: %u)",
+                        mipe_scanner_is_connected_to_mipe() ? "CONNECTED" : "NOT CONNECTED",
+                        samples, errors);
+            }
+            struct mipe_pa_sync_stats pa;
+            mipe_pa_sync_get_stats(&pa);
+            if (pa.attempts > 0) {
+                uint32_t prr = mipe_pa_sync_prr_permille();
+                LOG_INF("Periodic sync: %s, established %u/%u (avg %u ms, max %u ms), lost %u",
+                        mipe_pa_sync_is_synced() ? "SYNCED" : "NOT SYNCED",
+                        pa.established, pa.attempts,
+                        pa.established ? pa.total_establish_ms / pa.established : 0,
+                        pa.max_establish_ms, pa.losses);
+                LOG_INF("Periodic reports: %u/%u (PRR %u.%u%%)",
+                        pa.received, pa.expected, prr / 10, prr % 10);
+            }
+            struct scan_predictor_stats sp;
+            scan_predictor_get_stats(&sp);
+            if (sp.windows > 0 || sp.state == SCAN_PREDICTOR_TRACK) {
+                uint32_t capture = sp.windows ? sp.captures * 1000U / sp.windows : 0;
+                uint32_t duty = sp.track_time_us ?
+                                (uint32_t)(sp.scan_time_us * 1000U / sp.track_time_us) : 0;
+                LOG_INF("Scan predictor: %s, interval %u us, jitter %u us, window +/-%u us",
+                        sp.state == SCAN_PREDICTOR_TRACK ? "TRACKING" : "ACQUIRING",
+                        sp.interval_us, sp.jitter_us, sp.half_window_us);
+                LOG_INF("Scan windows: %u captured of %u (%u.%u%%, last block %u.%u%%), "
+                        "skipped %u, scan duty %u.%u%%, lost %u",
+                        sp.captures, sp.windows, capture / 10, capture % 10,
+                        sp.block_permille / 10, sp.block_permille % 10,
+                        sp.skipped, duty / 10, duty % 10, sp.losses);
+            }
+            
+            struct app_reconnect_stats reconnect;
+            app_reconnect_get_stats(&reconnect);
+            uint32_t reconnects = reconnect.reconnects[APP_RECONNECT_DIRECTED] +
+                                  reconnect.reconnects[APP_RECONNECT_FAST] +
+                                  reconnect.reconnects[APP_RECONNECT_SLOW];
+            if (reconnects > 0) {
+                LOG_INF("App reconnects: %u (directed %u, fast %u, slow %u), avg %u ms, "
+                        "max %u ms, directed timeouts %u", reconnects,
+                        reconnect.reconnects[APP_RECONNECT_DIRECTED],
+                        reconnect.reconnects[APP_RECONNECT_FAST],
+                        reconnect.reconnects[APP_RECONNECT_SLOW],
+                        reconnect.total_ms / reconnects, reconnect.max_ms,
+                        reconnect.directed_timeouts);
+                for (int p = 0; p < APP_RECONNECT_PHASE_COUNT; p++) {
+                    const uint32_t *h = reconnect.histogram[p];
+                    if (reconnect.reconnects[p] == 0) {
+                        continue;
+                    }
+                    LOG_INF("RECONNECT,HIST,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u",
+                            app_reconnect_phase_name(p),
+                            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7], h[8]);
+                }
+            }
+            
+            if (RSSI_TRACE_CAPTURE) {
+                static uint32_t last_dropped = 0;
+                struct rssi_trace_stats trace;
+                rssi_trace_get_stats(&trace);
+                if (trace.dropped != last_dropped) {
+                    LOG_WRN("RSSI trace: %u frames captured, %u dropped (UART too slow)",
+                            trace.captured, trace.dropped);
+                    last_dropped = trace.dropped;
+                }
+            }
+            
+            if (HOST_TELEMETRY) {
+                static uint32_t last_telemetry_dropped = 0;
+                struct host_telemetry_stats telemetry;
+                host_telemetry_get_stats(&telemetry);
+                if (telemetry.dropped != last_telemetry_dropped) {
+                    LOG_WRN("Telemetry: %u records (%u bytes), %u dropped (UART too slow)",
+                            telemetry.records, telemetry.bytes, telemetry.dropped);
+                    last_telemetry_dropped = telemetry.dropped;
+                }
+            }
+            
+            struct host_beacon_stats beacon;
+            host_beacon_get_stats(&beacon);
+            if (beacon.active) {
+                LOG_INF("Status beacon: %u tags, seq %u, %u updates (%u failed)%s",
+                        beacon.tags, beacon.seq, beacon.updates, beacon.update_errors,
+                        beacon.on_air ? "" : ", off air");
+            }
+            
+            struct mipe_presence_stats presence;
+            mipe_presence_get_stats(&presence);
+            if (presence.arrivals > 0) {
+                LOG_INF("Presence events: %u present, %u absent, %u sent to App (%u failed)",
+                        presence.arrivals, presence.departures, presence.sent,
+                        presence.send_errors);
             }
             
             // Additional detailed status when connected
@@ -477,6 +1229,16 @@ int main(void)
                 LOG_INF("Last RSSI send: %lld ms ago", 
                         k_uptime_get() - last_rssi_send);
                 LOG_INF("RSSI send interval: %u ms", RSSI_SEND_INTERVAL);
+                struct app_time_info at;
+                app_time_get(&at);
+                if (at.aligned) {
+                    LOG_INF("App time: offset %lld us, delay %u us, jitter %u us, "
+                            "%u exchanges (%u rejected), updated %u ms ago",
+                            at.offset_us, at.delay_us, at.jitter_us, at.exchanges,
+                            at.rejected, current_time - at.last_update_ms);
+                } else {
+                    LOG_INF("App time: not aligned");
+                }
                 LOG_INF("======================");
             }
         }
@@ -484,8 +1246,27 @@ int main(void)
         // Check Mipe status periodically
         check_mipe_status();
         
+        // App commands that need the scanner or the Mipe link
+        service_control_requests(current_time);
+        
+        // Connected measurement mode: (re)create the Mipe link when needed
+        maintain_mipe_link(current_time);
+        
+        // Start a deferred sync once the tag opens its connectable window
+        service_pending_sync(current_time);
+        
+        // Keep the Mipe clock model fresh
+        refresh_mipe_clock(current_time);
+        
+        // Broadcast the latest tag view to observers
+        host_beacon_process(current_time);
+        
+        // End-to-end metrics line and regression limits
+        host_metrics_report(current_time, streaming_active);
+        
         // Force Mipe scanning when not connected to ensure we find the device
-        if (!app_connected && !mipe_device_found && !scanning_mode) {
+        if (!app_connected && mipe_tracker_count() == 0 && !scanning_mode && !RSSI_TRACE_REPLAY &&
+            !app_reconnect_is_active()) {
             LOG_INF("No Mipe device found - forcing scan mode");
             switch_to_scanning_mode();
             last_mode_switch = current_time;
@@ -499,33 +1280,11 @@ int main(void)
         }
         
         // Send RSSI data if streaming is active (regardless of App connection)
-        if (streaming_active) {
-            uint32_t current_time = k_uptime_get();
+        // Replay runs the packetizer on its own virtual clock
+        if (streaming_active && !RSSI_TRACE_REPLAY) {
+            uint32_t current_time = k_uptime_get_32();
             if (current_time - last_rssi_send >= RSSI_SEND_INTERVAL) {
-                // Generate RSSI value
-                int8_t rssi = generate_rssi_value();
-                
-                // Only send if we have a valid RSSI (not -100)
-                if (rssi > -100) {
-                    if (app_connected) {
-                        // Send RSSI data via BLE service to App
-                        int err = ble_service_send_rssi_data(rssi, current_time);
-                        if (err == 0) {
-                            LOG_INF("RSSI data sent to App: %d dBm, stream count: %u", rssi, stream_counter);
-                            stream_counter++;
-                            last_rssi_send = current_time;
-                        } else {
-                            LOG_ERR("Failed to send RSSI data to App: %d", err);
-                        }
-                    } else {
-                        // App not connected - just log the RSSI reading
-                        LOG_INF("RSSI reading (no App): %d dBm, stream count: %u", rssi, stream_counter);
-                        stream_counter++;
-                        last_rssi_send = current_time;
-                    }
-                } else {
-                    LOG_WRN("Skipping RSSI send - no valid Mipe RSSI available");
-                }
+                stream_rssi_samples(current_time);
             }
         } else if (app_connected && !streaming_active) {
             // Log when connected but not streaming
@@ -597,30 +1356,26 @@ void handle_get_status(void)
     LOG_INF("================================");
 }
 
+void handle_set_measure_mode(uint8_t mode)
+{
+    LOG_INF("=== MEASURE MODE COMMAND RECEIVED ===");
+    LOG_INF("Requested mode: %s", mode == MEASURE_MODE_CONNECTED ? "CONNECTED" : "ADVERTISEMENT");
+    
+    // Applied by the main loop, which owns the scanner and the Mipe link
+    atomic_set(&requested_measure_mode, mode);
+    atomic_set_bit(control_requests, CONTROL_REQ_MEASURE_MODE);
+    
+    LOG_INF("=====================================");
+}
+
 void handle_mipe_sync(void)
 {
     LOG_INF("=== MIPE SYNC COMMAND RECEIVED ===");
     LOG_INF("Mipe synchronization command received from App");
-    LOG_INF("Current implementation status: PARTIALLY IMPLEMENTED");
-    LOG_INF("Mipe scanning status: %s", mipe_scanning_active ? "ACTIVE" : "INACTIVE");
-    LOG_INF("Mipe device found: %s", mipe_device_found ? "YES" : "NO");
     
-    if (mipe_device_found) {
-        LOG_INF("Mipe device details:");
-        LOG_INF("  - Address: %s", mipe_device_addr);
-        LOG_INF("  - RSSI: %d dBm", mipe_rssi_value);
-        LOG_INF("  - Expected name: %s", MIPE_EXPECTED_NAME);
-        LOG_INF("  - Name length: %zu", MIPE_NAME_LENGTH);
-        LOG_INF("Mipe device is AVAILABLE for RSSI reading");
-    } else {
-        LOG_INF("Mipe device NOT FOUND");
-        LOG_INF("Expected Mipe name: %s", MIPE_EXPECTED_NAME);
-        LOG_INF("Expected name length: %zu", MIPE_NAME_LENGTH);
-        LOG_INF("Mipe device is NOT AVAILABLE for RSSI reading");
-    }
+    // The main loop picks the tag and starts the sync (it owns the scanner)
+    atomic_set_bit(control_requests, CONTROL_REQ_MIPE_SYNC);
     
-    LOG_INF("Current streaming state: %s", streaming_active ? "ACTIVE" : "INACTIVE");
-    LOG_INF("Future functionality: Will read real battery data from Mipe device");
     LOG_INF("Mipe sync command acknowledged");
     LOG_INF("================================");
 }
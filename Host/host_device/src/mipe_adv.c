@@ -0,0 +1,91 @@
+#include "mipe_adv.h"
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+// ========================================
+// PARSER
+// ========================================
+
+static bool parse_element(struct bt_data *data, void *user_data)
+{
+    struct mipe_adv_info *info = user_data;
+
+    switch (data->type) {
+    case BT_DATA_NAME_COMPLETE:
+    case BT_DATA_NAME_SHORTENED:
+        if (data->data_len == strlen(MIPE_ADV_NAME) &&
+            memcmp(data->data, MIPE_ADV_NAME, data->data_len) == 0) {
+            info->is_mipe = true;
+        }
+        break;
+
+    case BT_DATA_MANUFACTURER_DATA:
+        if ((data->data_len != MIPE_MFG_DATA_LEN && data->data_len != MIPE_MFG_DATA_LEN_V1) ||
+            sys_get_le16(&data->data[0]) != MIPE_MFG_COMPANY_ID ||
+            data->data[2] != MIPE_MFG_FORMAT_ID) {
+            break;
+        }
+
+        info->is_mipe = true;
+        info->has_telemetry = true;
+        info->telemetry.seq = data->data[3];
+        info->telemetry.tx_power = (int8_t)data->data[4];
+        info->telemetry.battery_percent = data->data[5];
+        info->telemetry.uptime_s = sys_get_le32(&data->data[6]);
+        info->telemetry.interval_ceiling_ms = (data->data_len == MIPE_MFG_DATA_LEN) ?
+                                              data->data[10] * MIPE_MFG_INTERVAL_UNIT_MS : 0;
+        break;
+
+    default:
+        break;
+    }
+
+    // Keep going until both name and telemetry could have been seen
+    return !(info->is_mipe && info->has_telemetry);
+}
+
+bool mipe_adv_parse(const struct net_buf_simple *buf, struct mipe_adv_info *info)
+{
+    // Parse a shallow copy so the caller's buffer state is untouched
+    struct net_buf_simple temp_buf = *buf;
+
+    memset(info, 0, sizeof(*info));
+    bt_data_parse(&temp_buf, parse_element, info);
+
+    return info->is_mipe;
+}
+
+// ========================================
+// BUILDER
+// ========================================
+
+uint8_t mipe_adv_build(const struct mipe_telemetry *telemetry, uint8_t *data)
+{
+    uint8_t len = 0;
+
+    data[len++] = 2;
+    data[len++] = BT_DATA_FLAGS;
+    data[len++] = BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR;
+
+    if (telemetry) {
+        data[len++] = MIPE_MFG_DATA_LEN + 1;
+        data[len++] = BT_DATA_MANUFACTURER_DATA;
+        sys_put_le16(MIPE_MFG_COMPANY_ID, &data[len]);
+        data[len + 2] = MIPE_MFG_FORMAT_ID;
+        data[len + 3] = telemetry->seq;
+        data[len + 4] = (uint8_t)telemetry->tx_power;
+        data[len + 5] = telemetry->battery_percent;
+        sys_put_le32(telemetry->uptime_s, &data[len + 6]);
+        data[len + 10] = MIN(DIV_ROUND_UP(telemetry->interval_ceiling_ms,
+                                          MIPE_MFG_INTERVAL_UNIT_MS), UINT8_MAX);
+        len += MIPE_MFG_DATA_LEN;
+    } else {
+        data[len++] = strlen(MIPE_ADV_NAME) + 1;
+        data[len++] = BT_DATA_NAME_COMPLETE;
+        memcpy(&data[len], MIPE_ADV_NAME, strlen(MIPE_ADV_NAME));
+        len += strlen(MIPE_ADV_NAME);
+    }
+
+    return len;
+}
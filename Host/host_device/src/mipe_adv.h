@@ -0,0 +1,74 @@
+#ifndef MIPE_ADV_H
+#define MIPE_ADV_H
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// MIPE ADVERTISING PAYLOAD DEFINITIONS
+// ========================================
+// Must match Mipe/src/adv_payload.h
+
+#define MIPE_MFG_COMPANY_ID         0xFFFF
+#define MIPE_MFG_FORMAT_ID          0x4D
+#define MIPE_MFG_DATA_LEN           11
+#define MIPE_MFG_DATA_LEN_V1        10      // Firmware without the interval ceiling
+#define MIPE_MFG_BATTERY_UNKNOWN    0xFF
+#define MIPE_MFG_INTERVAL_UNIT_MS   10
+
+// Name used by Mipe tags without the telemetry element
+#define MIPE_ADV_NAME               "MIPE"
+
+// Longest payload mipe_adv_build() produces (flags + telemetry element)
+#define MIPE_ADV_DATA_MAX_LEN       (3 + 2 + MIPE_MFG_DATA_LEN)
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Telemetry carried in the Mipe manufacturer data
+ */
+struct mipe_telemetry {
+    uint8_t seq;             // Rolling sequence number
+    int8_t tx_power;         // Calibrated RSSI at 1 m (dBm)
+    uint8_t battery_percent; // 0-100, MIPE_MFG_BATTERY_UNKNOWN if not measured
+    uint32_t uptime_s;       // Mipe uptime in seconds
+    uint16_t interval_ceiling_ms; // Longest interval until the next update, 0 if not advertised
+};
+
+/**
+ * Result of parsing one advertisement
+ */
+struct mipe_adv_info {
+    bool is_mipe;            // Name or telemetry identifies a Mipe
+    bool has_telemetry;      // Telemetry element present and valid
+    struct mipe_telemetry telemetry;
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Parse advertising data for the Mipe name and telemetry
+ * Works on a copy of the buffer state; nothing is allocated or copied out
+ * besides the fixed-size result.
+ * @param buf Advertising data (left unchanged)
+ * @param info Parse result
+ * @return true if the advertisement comes from a Mipe
+ */
+bool mipe_adv_parse(const struct net_buf_simple *buf, struct mipe_adv_info *info);
+
+/**
+ * Build the advertising data of a Mipe tag (flags, then the telemetry
+ * element or the name for firmware without telemetry)
+ * Used to feed synthetic and replayed reports through the scan callback.
+ * @param telemetry Telemetry to encode (NULL: name only)
+ * @param data Destination, at least MIPE_ADV_DATA_MAX_LEN bytes
+ * @return Length of the advertising data
+ */
+uint8_t mipe_adv_build(const struct mipe_telemetry *telemetry, uint8_t *data);
+
+#endif // MIPE_ADV_H
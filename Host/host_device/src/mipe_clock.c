@@ -0,0 +1,298 @@
+#include "mipe_clock.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(mipe_clock, LOG_LEVEL_INF);
+
+// Host time in ms to the regression x axis in Q8 (64 ms units * 256 = ms * 4)
+#define X_Q8_PER_MS         (256 >> MIPE_CLOCK_X_SHIFT)
+
+// Microseconds per x unit
+#define US_PER_X_UNIT       (1000 << MIPE_CLOCK_X_SHIFT)
+
+// Products are formed in Q4 to keep the covariances inside 64 bits
+#define PRODUCT_SHIFT       4
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Per-tag regression state
+ * x: Host time since x0_ms (Q8, 64 ms units); y: Mipe minus Host time relative to y0_us (Q8, us)
+ */
+struct clock_model {
+    bt_addr_le_t addr;
+    bool in_use;
+    uint32_t x0_ms;          // Host uptime of the first sample
+    int64_t y0_us;           // Offset of the first sample
+    uint32_t n;              // Samples since (re)start
+    int64_t mean_x_q8;
+    int64_t mean_y_q8;
+    int64_t cov_xx;          // Covariances in Q8 (PRODUCT_SHIFT per factor)
+    int64_t cov_xy;
+    uint64_t err_sq;         // Exponential average of squared prediction errors (us^2)
+    int32_t drift_ppb;
+    uint32_t first_ms;
+    uint32_t last_ms;
+    uint32_t last_mipe_ms;
+    uint32_t resets;
+};
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct clock_model models[MIPE_CLOCK_MAX_TAGS];
+static struct k_spinlock lock;
+
+// ========================================
+// HELPERS
+// ========================================
+
+static struct clock_model *find_model(const bt_addr_le_t *addr)
+{
+    for (int i = 0; i < MIPE_CLOCK_MAX_TAGS; i++) {
+        if (models[i].in_use && bt_addr_le_eq(&models[i].addr, addr)) {
+            return &models[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Free slot, or the model with the oldest sample
+ */
+static struct clock_model *alloc_model(const bt_addr_le_t *addr)
+{
+    struct clock_model *oldest = &models[0];
+
+    for (int i = 0; i < MIPE_CLOCK_MAX_TAGS; i++) {
+        if (!models[i].in_use) {
+            oldest = &models[i];
+            break;
+        }
+        if ((int32_t)(models[i].last_ms - oldest->last_ms) < 0) {
+            oldest = &models[i];
+        }
+    }
+
+    memset(oldest, 0, sizeof(*oldest));
+    bt_addr_le_copy(&oldest->addr, addr);
+    oldest->in_use = true;
+    return oldest;
+}
+
+static bool drift_valid(const struct clock_model *m)
+{
+    return m->n >= MIPE_CLOCK_MIN_SAMPLES && m->last_ms - m->first_ms >= MIPE_CLOCK_MIN_SPAN_MS;
+}
+
+static int64_t x_q8(const struct clock_model *m, uint32_t host_ms)
+{
+    return (int64_t)(int32_t)(host_ms - m->x0_ms) * X_Q8_PER_MS;
+}
+
+/**
+ * Model offset (Mipe minus Host, us) at a Host time
+ */
+static int64_t predict_us(const struct clock_model *m, uint32_t host_ms)
+{
+    int32_t ppb = drift_valid(m) ? m->drift_ppb : 0;
+    int64_t dx_q8 = x_q8(m, host_ms) - m->mean_x_q8;
+    int64_t y_q8 = m->mean_y_q8 + dx_q8 * ppb / (1000000000LL / US_PER_X_UNIT);
+
+    return m->y0_us + y_q8 / 256;
+}
+
+/**
+ * Restart the model from one sample
+ */
+static void restart_model(struct clock_model *m, uint32_t host_ms, int64_t offset_us)
+{
+    m->x0_ms = host_ms;
+    m->y0_us = offset_us;
+    m->n = 0;
+    m->mean_x_q8 = 0;
+    m->mean_y_q8 = 0;
+    m->cov_xx = 0;
+    m->cov_xy = 0;
+    m->err_sq = 0;
+    m->drift_ppb = 0;
+    m->first_ms = host_ms;
+}
+
+/**
+ * Integer square root (for the RMS error)
+ */
+static uint32_t isqrt64(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static void fill_info(const struct clock_model *m, struct mipe_clock_info *out)
+{
+    uint32_t span = m->last_ms - m->first_ms;
+
+    out->samples = m->n;
+    out->span_ms = span;
+    out->offset_us = predict_us(m, m->last_ms);
+    out->drift_ppb = m->drift_ppb;
+    out->error_us = isqrt64(m->err_sq);
+    out->drift_error_ppb = span ? (uint32_t)MIN((uint64_t)out->error_us * 1000000U / span,
+                                                UINT32_MAX) : UINT32_MAX;
+    out->resets = m->resets;
+    out->last_sample_ms = m->last_ms;
+    out->drift_valid = drift_valid(m);
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+void mipe_clock_init(void)
+{
+    memset(models, 0, sizeof(models));
+}
+
+int mipe_clock_add_sample(const bt_addr_le_t *addr, uint32_t host_ms, uint32_t mipe_ms,
+                          uint32_t uncertainty_ms)
+{
+    int64_t offset_us = ((int64_t)mipe_ms - (int64_t)host_ms) * 1000;
+    struct mipe_clock_info info;
+    bool reset = false;
+
+    // A slow read says little about when the clock was sampled
+    if (uncertainty_ms > MIPE_CLOCK_MAX_UNCERTAINTY_MS) {
+        LOG_WRN("Clock sample dropped - read took %u ms", 2 * uncertainty_ms);
+        return -ERANGE;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    struct clock_model *m = find_model(addr);
+    if (!m) {
+        m = alloc_model(addr);
+        restart_model(m, host_ms, offset_us);
+    } else {
+        // Prediction error of the new sample against the current model
+        int64_t err_us = offset_us - predict_us(m, host_ms);
+
+        if (mipe_ms < m->last_mipe_ms || llabs(err_us) > MIPE_CLOCK_RESET_US) {
+            restart_model(m, host_ms, offset_us);
+            m->resets++;
+            reset = true;
+        } else if (drift_valid(m)) {
+            // Errors before the drift settles only measure the missing drift term
+            uint64_t sq = (uint64_t)(err_us * err_us);
+            m->err_sq = m->err_sq == 0 ? sq : m->err_sq + ((int64_t)(sq - m->err_sq)) / 8;
+        }
+    }
+
+    // Online covariance update with exponential forgetting after MIPE_CLOCK_WINDOW samples
+    int64_t x = x_q8(m, host_ms);
+    int64_t y = (offset_us - m->y0_us) * 256;
+    uint32_t w;
+
+    m->n++;
+    w = MIN(m->n, MIPE_CLOCK_WINDOW);
+
+    // Welford: deviation from the old mean times deviation from the new mean
+    int64_t dx_old = x - m->mean_x_q8;
+    m->mean_x_q8 += dx_old / w;
+    m->mean_y_q8 += (y - m->mean_y_q8) / w;
+    int64_t dx_new = (x - m->mean_x_q8) >> (8 - PRODUCT_SHIFT);
+    int64_t dy_new = (y - m->mean_y_q8) >> (8 - PRODUCT_SHIFT);
+
+    dx_old >>= 8 - PRODUCT_SHIFT;
+    m->cov_xx += (dx_old * dx_new - m->cov_xx) / w;
+    m->cov_xy += (dx_old * dy_new - m->cov_xy) / w;
+
+    // Slope in us per x unit, expressed in parts per billion
+    if (m->cov_xx > 0) {
+        m->drift_ppb = (int32_t)(m->cov_xy * (1000000000LL / US_PER_X_UNIT) / m->cov_xx);
+    }
+
+    m->last_ms = host_ms;
+    m->last_mipe_ms = mipe_ms;
+    fill_info(m, &info);
+
+    k_spin_unlock(&lock, key);
+
+    if (reset) {
+        LOG_WRN("Mipe clock jumped - restarting its clock model");
+    }
+    LOG_INF("Mipe clock: offset %lld us, drift %s%d.%03d ppm (+/- %u.%03u), error %u us, %u samples",
+            info.offset_us, info.drift_ppb < 0 ? "-" : "",
+            abs(info.drift_ppb) / 1000, abs(info.drift_ppb) % 1000,
+            info.drift_error_ppb / 1000, info.drift_error_ppb % 1000,
+            info.error_us, info.samples);
+    return 0;
+}
+
+int mipe_clock_host_to_mipe(const bt_addr_le_t *addr, uint32_t host_ms, uint32_t *mipe_ms)
+{
+    int err = -ENODATA;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    const struct clock_model *m = find_model(addr);
+    if (m) {
+        *mipe_ms = host_ms + (uint32_t)(int32_t)(predict_us(m, host_ms) / 1000);
+        err = 0;
+    }
+    k_spin_unlock(&lock, key);
+
+    return err;
+}
+
+int mipe_clock_mipe_to_host(const bt_addr_le_t *addr, uint32_t mipe_ms, uint32_t *host_ms)
+{
+    int err = -ENODATA;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    const struct clock_model *m = find_model(addr);
+    if (m) {
+        // Offset is evaluated at Host time: one fixed-point iteration is enough
+        uint32_t guess = mipe_ms - (uint32_t)(int32_t)(predict_us(m, mipe_ms) / 1000);
+        *host_ms = mipe_ms - (uint32_t)(int32_t)(predict_us(m, guess) / 1000);
+        err = 0;
+    }
+    k_spin_unlock(&lock, key);
+
+    return err;
+}
+
+int mipe_clock_get(const bt_addr_le_t *addr, struct mipe_clock_info *out)
+{
+    int err = -ENODATA;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    const struct clock_model *m = find_model(addr);
+    if (m) {
+        fill_info(m, out);
+        err = 0;
+    }
+    k_spin_unlock(&lock, key);
+
+    return err;
+}
@@ -0,0 +1,111 @@
+#ifndef MIPE_CLOCK_H
+#define MIPE_CLOCK_H
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/addr.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// MIPE CLOCK MODEL CONFIGURATION
+// ========================================
+// Each sync read gives one (Host uptime, Mipe uptime) pair. An online
+// fixed-point linear regression with exponential forgetting fits
+//   mipe_time = host_time + offset + drift * (host_time - reference)
+// per tag, so Host timestamps can be mapped into the Mipe clock domain.
+
+// Number of tags with a clock model
+#define MIPE_CLOCK_MAX_TAGS         8
+
+// Effective regression window (older samples are forgotten exponentially)
+#define MIPE_CLOCK_WINDOW           16
+
+// Regression x unit: Host time in 64 ms steps (keeps the sums inside 64 bits)
+#define MIPE_CLOCK_X_SHIFT          6
+
+// Samples and time span needed before the drift estimate is used
+#define MIPE_CLOCK_MIN_SAMPLES      3
+#define MIPE_CLOCK_MIN_SPAN_MS      60000
+
+// A sample this far from the prediction means the Mipe restarted
+#define MIPE_CLOCK_RESET_US         1000000
+
+// Samples whose read took longer than twice this are not used
+#define MIPE_CLOCK_MAX_UNCERTAINTY_MS 50
+
+// Periodic clock refresh through a sync (0 = only on App request). Off by
+// default: every sync link restarts the tag's advertising schedule at burst,
+// so a periodic refresh keeps it from ever reaching the slow, low-power
+// state. Enable with -DMIPE_CLOCK_REFRESH_MS=<ms> when drift tracking is
+// worth that energy.
+#ifndef MIPE_CLOCK_REFRESH_MS
+#define MIPE_CLOCK_REFRESH_MS       0
+#endif
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Clock model snapshot of one tag
+ */
+struct mipe_clock_info {
+    uint32_t samples;           // Samples since the model was (re)started
+    uint32_t span_ms;           // Host time covered by those samples
+    int64_t offset_us;          // Mipe minus Host time at the latest sample
+    int32_t drift_ppb;          // Mipe clock rate relative to the Host (parts per billion)
+    uint32_t error_us;          // RMS prediction error of new samples (confidence)
+    uint32_t drift_error_ppb;   // Drift uncertainty derived from error_us and span_ms
+    uint32_t resets;            // Model restarts (Mipe reboots)
+    uint32_t last_sample_ms;    // Host uptime of the latest sample
+    bool drift_valid;           // Enough samples and span for the drift estimate
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Clear all clock models
+ */
+void mipe_clock_init(void);
+
+/**
+ * Add a clock sample
+ * @param addr Tag address
+ * @param host_ms Host uptime at which the Mipe clock was sampled
+ * @param mipe_ms Mipe uptime read from the tag
+ * @param uncertainty_ms Bound on host_ms (half the read round trip)
+ * @return 0 on success, -ERANGE if the sample is too uncertain
+ * The model with the oldest sample is replaced when all slots are in use.
+ */
+int mipe_clock_add_sample(const bt_addr_le_t *addr, uint32_t host_ms, uint32_t mipe_ms,
+                          uint32_t uncertainty_ms);
+
+/**
+ * Map a Host uptime into the tag's clock domain
+ * @param addr Tag address
+ * @param host_ms Host uptime (ms)
+ * @param mipe_ms Corresponding Mipe uptime (ms)
+ * @return 0 on success, -ENODATA if the tag has no clock model
+ */
+int mipe_clock_host_to_mipe(const bt_addr_le_t *addr, uint32_t host_ms, uint32_t *mipe_ms);
+
+/**
+ * Map a Mipe uptime into the Host clock domain
+ * @param addr Tag address
+ * @param mipe_ms Mipe uptime (ms)
+ * @param host_ms Corresponding Host uptime (ms)
+ * @return 0 on success, -ENODATA if the tag has no clock model
+ */
+int mipe_clock_mipe_to_host(const bt_addr_le_t *addr, uint32_t mipe_ms, uint32_t *host_ms);
+
+/**
+ * Get the clock model of a tag
+ * @param addr Tag address
+ * @param out Destination for the snapshot
+ * @return 0 on success, -ENODATA if the tag has no clock model
+ */
+int mipe_clock_get(const bt_addr_le_t *addr, struct mipe_clock_info *out);
+
+#endif // MIPE_CLOCK_H
@@ -0,0 +1,272 @@
+#include "mipe_pa_sync.h"
+#include "host_telemetry.h"
+#include "mipe_adv.h"
+#include "mipe_tracker.h"
+#include "rssi_trace.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gap.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(mipe_pa_sync, LOG_LEVEL_INF);
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+// One sync at a time (CONFIG_BT_PER_ADV_SYNC_MAX)
+static struct bt_le_per_adv_sync *pa_sync = NULL;
+static bt_addr_le_t pa_addr;
+static bool pa_pending = false;
+static bool pa_synced = false;
+static uint8_t pa_phy = BT_GAP_LE_PHY_NONE;
+static uint32_t pa_interval_ms = 0;
+static uint32_t create_time = 0;
+static uint32_t synced_time = 0;
+
+static struct mipe_pa_sync_stats stats;
+static struct k_spinlock stats_lock;
+
+static void create_timeout_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(create_timeout_work, create_timeout_handler);
+
+// ========================================
+// HELPERS
+// ========================================
+
+/**
+ * Sync timeout covering MIPE_PA_SYNC_LOSS_EVENTS periodic events
+ */
+static uint16_t sync_timeout(uint16_t interval)
+{
+    // interval * 1.25ms * events / 10ms
+    uint32_t timeout = (uint32_t)interval * MIPE_PA_SYNC_LOSS_EVENTS / 8U;
+
+    return CLAMP(timeout, MIPE_PA_SYNC_TIMEOUT_MIN, MIPE_PA_SYNC_TIMEOUT_MAX);
+}
+
+/**
+ * Periodic events that occurred during the running sync
+ * Must be called with stats_lock held.
+ */
+static uint32_t running_expected(uint32_t now)
+{
+    if (!pa_synced || pa_interval_ms == 0) {
+        return 0;
+    }
+
+    return (now - synced_time) / pa_interval_ms;
+}
+
+// ========================================
+// SYNC CALLBACKS
+// ========================================
+
+static void create_timeout_handler(struct k_work *work)
+{
+    if (!pa_pending) {
+        return;
+    }
+
+    LOG_WRN("Periodic sync not established within %u ms - giving up",
+            MIPE_PA_SYNC_CREATE_TIMEOUT_MS);
+
+    // Deleting a pending sync cancels the create request
+    bt_le_per_adv_sync_delete(pa_sync);
+    pa_sync = NULL;
+    pa_pending = false;
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    stats.create_timeouts++;
+    k_spin_unlock(&stats_lock, key);
+}
+
+static void pa_synced_cb(struct bt_le_per_adv_sync *sync,
+                         struct bt_le_per_adv_sync_synced_info *info)
+{
+    uint32_t now = k_uptime_get_32();
+    uint32_t establish_ms = now - create_time;
+    char addr_str[BT_ADDR_LE_STR_LEN];
+
+    k_work_cancel_delayable(&create_timeout_work);
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    pa_pending = false;
+    pa_synced = true;
+    pa_phy = info->phy;
+    pa_interval_ms = info->interval * 5U / 4U;
+    synced_time = now;
+
+    stats.established++;
+    stats.last_establish_ms = establish_ms;
+    stats.max_establish_ms = MAX(stats.max_establish_ms, establish_ms);
+    stats.total_establish_ms += establish_ms;
+    k_spin_unlock(&stats_lock, key);
+
+    bt_addr_le_to_str(info->addr, addr_str, sizeof(addr_str));
+    LOG_INF("=== MIPE PERIODIC SYNC ESTABLISHED ===");
+    LOG_INF("Tag: %s (SID %u)", addr_str, info->sid);
+    LOG_INF("Interval: %u ms, establishment time: %u ms", pa_interval_ms, establish_ms);
+    LOG_INF("======================================");
+}
+
+static void pa_term_cb(struct bt_le_per_adv_sync *sync,
+                       const struct bt_le_per_adv_sync_term_info *info)
+{
+    uint32_t now = k_uptime_get_32();
+    bool was_synced;
+
+    k_work_cancel_delayable(&create_timeout_work);
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    was_synced = pa_synced;
+    if (was_synced) {
+        stats.expected += running_expected(now);
+        stats.losses++;
+    }
+    pa_sync = NULL;
+    pa_pending = false;
+    pa_synced = false;
+    k_spin_unlock(&stats_lock, key);
+
+    if (was_synced) {
+        LOG_WRN("Periodic sync lost (reason 0x%02x) after %u ms", info->reason,
+                now - synced_time);
+    } else {
+        LOG_WRN("Periodic sync create failed (reason 0x%02x)", info->reason);
+    }
+}
+
+static void pa_recv_cb(struct bt_le_per_adv_sync *sync,
+                       const struct bt_le_per_adv_sync_recv_info *info,
+                       struct net_buf_simple *buf)
+{
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    stats.received++;
+    k_spin_unlock(&stats_lock, key);
+
+    // Reports with no data or a failed CRC still count as received events
+    if (info->rssi == BT_GAP_RSSI_INVALID) {
+        return;
+    }
+
+    mipe_pa_sync_report(&pa_addr, info->rssi, pa_phy, buf, k_uptime_get_32());
+}
+
+static struct bt_le_per_adv_sync_cb pa_sync_callbacks = {
+    .synced = pa_synced_cb,
+    .term = pa_term_cb,
+    .recv = pa_recv_cb,
+};
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+void mipe_pa_sync_init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    bt_le_per_adv_sync_cb_register(&pa_sync_callbacks);
+}
+
+int mipe_pa_sync_on_report(const bt_addr_le_t *addr, uint8_t sid, uint16_t interval)
+{
+    struct bt_le_per_adv_sync_param param;
+    int err;
+
+    if (!MIPE_PA_SYNC_ENABLED || interval == 0 || pa_sync != NULL) {
+        return 0;
+    }
+
+    memset(&param, 0, sizeof(param));
+    bt_addr_le_copy(&param.addr, addr);
+    param.sid = sid;
+    param.options = BT_LE_PER_ADV_SYNC_OPT_NONE;
+    param.skip = 0;
+    param.timeout = sync_timeout(interval);
+
+    err = bt_le_per_adv_sync_create(&param, &pa_sync);
+    if (err) {
+        LOG_WRN("Periodic sync create failed (err %d)", err);
+        pa_sync = NULL;
+        return err;
+    }
+
+    bt_addr_le_copy(&pa_addr, addr);
+    create_time = k_uptime_get_32();
+    pa_pending = true;
+    stats.attempts++;
+    k_work_reschedule(&create_timeout_work, K_MSEC(MIPE_PA_SYNC_CREATE_TIMEOUT_MS));
+
+    LOG_INF("Creating periodic sync (SID %u, interval %u ms, timeout %u ms)",
+            sid, interval * 5U / 4U, param.timeout * 10U);
+    return 0;
+}
+
+void mipe_pa_sync_report(const bt_addr_le_t *addr, int8_t rssi, uint8_t phy,
+                         struct net_buf_simple *buf, uint32_t now)
+{
+    struct mipe_adv_info adv;
+
+    if (!mipe_adv_parse(buf, &adv)) {
+        return;
+    }
+
+    const struct mipe_telemetry *telemetry = adv.has_telemetry ? &adv.telemetry : NULL;
+
+    rssi_trace_capture(addr, rssi, RSSI_TRACE_ADV_TYPE_PERIODIC, false, phy, telemetry, now);
+    host_telemetry_sample(HOST_TELEMETRY_SRC_PERIODIC, addr, rssi, phy, false, telemetry);
+    if (mipe_tracker_report(addr, rssi, false, phy, now)) {
+        return;
+    }
+
+    if (telemetry) {
+        mipe_tracker_report_telemetry(addr, telemetry->seq, telemetry->tx_power,
+                                      telemetry->battery_percent, telemetry->uptime_s,
+                                      telemetry->interval_ceiling_ms);
+    }
+}
+
+bool mipe_pa_sync_is_pending(void)
+{
+    return pa_pending;
+}
+
+bool mipe_pa_sync_is_synced(void)
+{
+    return pa_synced;
+}
+
+bool mipe_pa_sync_get_addr(bt_addr_le_t *addr)
+{
+    if (!pa_synced) {
+        return false;
+    }
+    bt_addr_le_copy(addr, &pa_addr);
+    return true;
+}
+
+void mipe_pa_sync_get_stats(struct mipe_pa_sync_stats *out)
+{
+    uint32_t now = k_uptime_get_32();
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    *out = stats;
+    out->expected += running_expected(now);
+    k_spin_unlock(&stats_lock, key);
+}
+
+uint32_t mipe_pa_sync_prr_permille(void)
+{
+    struct mipe_pa_sync_stats s;
+
+    mipe_pa_sync_get_stats(&s);
+    if (s.expected == 0) {
+        return 0;
+    }
+
+    // Reports right at the boundary can make received exceed expected
+    return MIN(s.received * 1000U / s.expected, 1000U);
+}
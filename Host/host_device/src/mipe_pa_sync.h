@@ -0,0 +1,110 @@
+#ifndef MIPE_PA_SYNC_H
+#define MIPE_PA_SYNC_H
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// MIPE PERIODIC ADVERTISING SYNC CONFIGURATION
+// ========================================
+
+// Synchronise to Mipe periodic advertising trains when they are seen
+#ifndef MIPE_PA_SYNC_ENABLED
+#define MIPE_PA_SYNC_ENABLED        1
+#endif
+
+// Missed periodic events before the controller declares the sync lost
+#define MIPE_PA_SYNC_LOSS_EVENTS    5
+
+// Sync timeout limits (10ms units, as defined by the Core specification)
+#define MIPE_PA_SYNC_TIMEOUT_MIN    0x000A
+#define MIPE_PA_SYNC_TIMEOUT_MAX    0x4000
+
+// Give up on a sync attempt that has not been established after this long
+#define MIPE_PA_SYNC_CREATE_TIMEOUT_MS 5000
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Periodic advertising sync statistics
+ */
+struct mipe_pa_sync_stats {
+    uint32_t attempts;           // Sync create requests
+    uint32_t established;        // Syncs established
+    uint32_t create_timeouts;    // Attempts abandoned after MIPE_PA_SYNC_CREATE_TIMEOUT_MS
+    uint32_t losses;             // Established syncs terminated by the controller
+    uint32_t last_establish_ms;  // Time from create request to synced
+    uint32_t max_establish_ms;
+    uint32_t total_establish_ms; // Sum over all established syncs (for the mean)
+    uint32_t received;           // Periodic advertising reports received
+    uint32_t expected;           // Periodic events that occurred while synced
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Initialize periodic advertising sync handling
+ * Registers the sync callbacks, call before bt_enable().
+ */
+void mipe_pa_sync_init(void);
+
+/**
+ * Handle an extended advertising report from a Mipe tag
+ * Creates a sync to its periodic train if none exists yet.
+ * @param addr Advertiser address
+ * @param sid Advertising set identifier
+ * @param interval Periodic advertising interval (1.25ms units), 0 if none
+ * @return 0 on success or nothing to do, negative error code otherwise
+ */
+int mipe_pa_sync_on_report(const bt_addr_le_t *addr, uint8_t sid, uint16_t interval);
+
+/**
+ * Handle one periodic report: parse it and feed the tag table
+ * Called by the sync receive callback and by trace replay.
+ * @param addr Tag address
+ * @param rssi Report RSSI in dBm
+ * @param phy PHY of the train
+ * @param buf Periodic advertising data
+ * @param now Timestamp for the tracker in ms
+ */
+void mipe_pa_sync_report(const bt_addr_le_t *addr, int8_t rssi, uint8_t phy,
+                         struct net_buf_simple *buf, uint32_t now);
+
+/**
+ * Check whether a sync is being established (scanning must stay on)
+ * @return true if a create request is pending
+ */
+bool mipe_pa_sync_is_pending(void);
+
+/**
+ * Check whether a sync is established
+ * @return true if synced
+ */
+bool mipe_pa_sync_is_synced(void);
+
+/**
+ * Get the address of the synced tag
+ * @param addr Destination for the address
+ * @return true if synced, false otherwise (addr untouched)
+ */
+bool mipe_pa_sync_get_addr(bt_addr_le_t *addr);
+
+/**
+ * Get sync statistics
+ * The expected count includes the running sync.
+ * @param out Destination for the statistics
+ */
+void mipe_pa_sync_get_stats(struct mipe_pa_sync_stats *out);
+
+/**
+ * Packet reception ratio of the periodic train
+ * @return Received / expected in per mille, 0 if nothing was expected
+ */
+uint32_t mipe_pa_sync_prr_permille(void);
+
+#endif // MIPE_PA_SYNC_H
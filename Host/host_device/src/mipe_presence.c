@@ -0,0 +1,115 @@
+#include "mipe_presence.h"
+#include "ble_service.h"
+#include "host_metrics.h"
+#include "host_telemetry.h"
+#include "mipe_pa_sync.h"
+#include "mipe_scanner.h"
+#include "mipe_tracker.h"
+#include "scan_predictor.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(mipe_presence, LOG_LEVEL_INF);
+
+// Dedicated sources: predicted windows, periodic sync, connected link
+#define MAX_OBSERVED        3
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static bool scanning = false;
+static uint32_t last_tick = 0;
+static struct mipe_presence_stats stats;
+
+static void tick_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(tick_work, tick_handler);
+
+// ========================================
+// DETECTOR
+// ========================================
+
+/**
+ * Tags heard outside the continuous scan
+ */
+static int collect_observed(bt_addr_le_t *observed)
+{
+    int count = 0;
+
+    if (scan_predictor_get_target(&observed[count])) {
+        count++;
+    }
+    if (mipe_pa_sync_get_addr(&observed[count])) {
+        count++;
+    }
+    if (mipe_scanner_is_connected_to_mipe() &&
+        mipe_scanner_get_mipe_address(&observed[count]) == 0) {
+        count++;
+    }
+    return count;
+}
+
+static void tick_handler(struct k_work *work)
+{
+    struct mipe_presence_event events[MIPE_PRESENCE_MAX_EVENTS];
+    bt_addr_le_t observed[MAX_OBSERVED];
+    uint32_t now = k_uptime_get_32();
+    int observed_count = collect_observed(observed);
+
+    int count = mipe_tracker_presence_update(now - last_tick, scanning, observed,
+                                             observed_count, events, ARRAY_SIZE(events));
+    last_tick = now;
+
+    for (int i = 0; i < count; i++) {
+        char addr_str[BT_ADDR_LE_STR_LEN];
+        bt_addr_le_to_str(&events[i].addr, addr_str, sizeof(addr_str));
+
+        host_metrics_on_presence(events[i].present, now);
+        host_telemetry_event(HOST_TELEMETRY_EV_PRESENCE, events[i].present, events[i].id);
+        if (events[i].present) {
+            stats.arrivals++;
+            LOG_INF("Tag %u present: %s", events[i].id, addr_str);
+        } else {
+            stats.departures++;
+            LOG_INF("Tag %u absent: %s (timeout %u ms)", events[i].id, addr_str,
+                    events[i].timeout_ms);
+        }
+
+        if (ble_service_is_app_connected()) {
+            if (ble_service_send_presence(events[i].id, events[i].present,
+                                          &events[i].addr, events[i].timeout_ms) == 0) {
+                stats.sent++;
+            } else {
+                stats.send_errors++;
+            }
+        }
+    }
+
+    k_work_reschedule(&tick_work, K_MSEC(MIPE_PRESENCE_TICK_MS));
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+void mipe_presence_init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    last_tick = k_uptime_get_32();
+    k_work_reschedule(&tick_work, K_MSEC(MIPE_PRESENCE_TICK_MS));
+
+    LOG_INF("Presence detector started: false alarm %u ppm, timeout up to %u ms",
+            MIPE_TRACKER_PRESENCE_FALSE_ALARM_PPM, MIPE_TRACKER_PRESENCE_MAX_TIMEOUT_MS);
+}
+
+void mipe_presence_set_scanning(bool enable)
+{
+    scanning = enable;
+}
+
+void mipe_presence_get_stats(struct mipe_presence_stats *out)
+{
+    *out = stats;
+}
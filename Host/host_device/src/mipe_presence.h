@@ -0,0 +1,56 @@
+#ifndef MIPE_PRESENCE_H
+#define MIPE_PRESENCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// MIPE PRESENCE CONFIGURATION
+// ========================================
+// Drives the per-tag presence estimate kept by mipe_tracker: missed time
+// only accumulates while a tag can actually be heard (continuous scan, or a
+// predicted-window, periodic-sync or link source for that tag), and every
+// present/absent transition is sent to the App as it happens.
+
+// Detector period (bounds the detection latency added on top of the timeout)
+#define MIPE_PRESENCE_TICK_MS       25
+
+// Transitions handled per tick (the rest follow on the next tick)
+#define MIPE_PRESENCE_MAX_EVENTS    8
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Presence event counters
+ */
+struct mipe_presence_stats {
+    uint32_t arrivals;          // Transitions to present
+    uint32_t departures;        // Transitions to absent
+    uint32_t sent;              // Events delivered to the App
+    uint32_t send_errors;       // Events the App could not be notified of
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Start the presence detector
+ */
+void mipe_presence_init(void);
+
+/**
+ * Report whether the continuous scanner is running
+ * @param scanning true while every tag can be heard
+ */
+void mipe_presence_set_scanning(bool scanning);
+
+/**
+ * Get event counters
+ * @param out Destination for the counters
+ */
+void mipe_presence_get_stats(struct mipe_presence_stats *out);
+
+#endif // MIPE_PRESENCE_H
@@ -1,10 +1,16 @@
 #include "mipe_scanner.h"
 #include "ble_service.h"
+#include "host_energy.h"
+#include "host_telemetry.h"
+#include "mipe_tracker.h"
+#include "mipe_sync.h"
 #include <zephyr/logging/log.h>
 #include <zephyr/kernel.h>
 #include <zephyr/bluetooth/bluetooth.h>
 #include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/sys/byteorder.h>
 #include <string.h>
 
 LOG_MODULE_REGISTER(mipe_scanner, LOG_LEVEL_INF);
@@ -21,43 +27,109 @@ static bt_addr_le_t mipe_address;
 static uint32_t connection_start_time = 0;
 
 // ========================================
-// SCANNING CALLBACKS
+// CONNECTED RSSI SAMPLING
 // ========================================
 
-static void scan_cb(const struct bt_le_scan_recv_info *info,
-                    struct net_buf_simple *buf)
+// Dedicated queue: HCI Read RSSI blocks until the controller answers
+K_THREAD_STACK_DEFINE(rssi_workq_stack, MIPE_RSSI_WORKQ_STACK_SIZE);
+static struct k_work_q rssi_workq;
+static struct k_work_delayable rssi_sample_work;
+static struct k_work_sync rssi_sync;
+
+static bool connected_mode_enabled = MIPE_CONNECTED_MODE_DEFAULT;
+static uint32_t sample_period_us = 0;
+static uint32_t rssi_samples = 0;
+static uint32_t rssi_sample_errors = 0;
+
+/**
+ * Read the RSSI of the last packet received on a connection (HCI Read RSSI)
+ */
+static int read_conn_rssi(struct bt_conn *conn, int8_t *rssi)
 {
-    char addr[BT_ADDR_LE_STR_LEN];
-    bt_addr_le_to_str(info->addr, addr, sizeof(addr));
-    
-    // Check if this is a Mipe device
-    if (info->rssi >= MIPE_RSSI_MIN && info->rssi <= MIPE_RSSI_MAX) {
-        LOG_DBG("Mipe device found: %s, RSSI: %d dBm", addr, info->rssi);
-        
-        // Store RSSI data
-        last_rssi = info->rssi;
-        
-        // Send RSSI data to App if connected
-        if (ble_service_is_app_connected()) {
-            uint32_t timestamp = k_uptime_get_32();
-            ble_service_send_rssi_data(info->rssi, timestamp);
-        }
-        
-        // Store Mipe address for potential connection
-        memcpy(&mipe_address, info->addr, sizeof(bt_addr_le_t));
+    struct bt_hci_cp_read_rssi *cp;
+    struct bt_hci_rp_read_rssi *rp;
+    struct net_buf *buf, *rsp = NULL;
+    uint16_t handle;
+    int err;
+    
+    err = bt_hci_get_conn_handle(conn, &handle);
+    if (err) {
+        return err;
     }
+    
+    buf = bt_hci_cmd_create(BT_HCI_OP_READ_RSSI, sizeof(*cp));
+    if (!buf) {
+        return -ENOBUFS;
+    }
+    
+    cp = net_buf_add(buf, sizeof(*cp));
+    cp->handle = sys_cpu_to_le16(handle);
+    
+    err = bt_hci_cmd_send_sync(BT_HCI_OP_READ_RSSI, buf, &rsp);
+    if (err) {
+        return err;
+    }
+    
+    rp = (void *)rsp->data;
+    *rssi = rp->rssi;
+    net_buf_unref(rsp);
+    
+    return 0;
 }
 
-static void scan_timeout_cb(void)
+/**
+ * Update the sampling period from the current connection interval
+ */
+static void update_sample_period(struct bt_conn *conn)
 {
-    LOG_INF("Scan timeout - no Mipe devices found");
-    scanning_active = false;
+    struct bt_conn_info info;
+    
+    if (bt_conn_get_info(conn, &info) == 0) {
+        sample_period_us = BT_GAP_CONN_INTERVAL_TO_US(info.le.interval);
+        host_energy_set(HOST_ENERGY_MIPE_LINK, true, sample_period_us);
+        LOG_INF("Mipe link interval %u us - sampling RSSI every connection event",
+                sample_period_us);
+    }
 }
 
-static struct bt_le_scan_cb scan_callbacks = {
-    .recv = scan_cb,
-    .timeout = scan_timeout_cb,
-};
+/**
+ * Sample RSSI once per connection event and feed it to the tag table
+ */
+static void rssi_sample_work_handler(struct k_work *work)
+{
+    struct bt_conn *conn = mipe_conn;
+    int8_t rssi;
+    
+    if (!connected_to_mipe || !conn) {
+        return;
+    }
+    
+    int err = read_conn_rssi(conn, &rssi);
+    if (err) {
+        rssi_sample_errors++;
+        LOG_DBG("Read RSSI failed: %d", err);
+    } else if (rssi != MIPE_RSSI_UNAVAILABLE) {
+        last_rssi = rssi;
+        rssi_samples++;
+        mipe_tracker_report(&mipe_address, rssi, true, BT_GAP_LE_PHY_NONE,
+                            k_uptime_get_32());
+        host_telemetry_sample(HOST_TELEMETRY_SRC_CONN, &mipe_address, rssi, BT_GAP_LE_PHY_NONE,
+                              true, NULL);
+    }
+    
+    k_work_reschedule_for_queue(&rssi_workq, &rssi_sample_work,
+                                K_USEC(MAX(sample_period_us, MIPE_RSSI_MIN_PERIOD_US)));
+}
+
+/**
+ * Battery voltage from the last sync, 0 if none is available
+ */
+static float synced_battery_voltage(void)
+{
+    float voltage;
+    
+    return mipe_scanner_read_battery(&voltage) == 0 ? voltage : 0.0f;
+}
 
 // ========================================
 // CONNECTION CALLBACKS
@@ -66,50 +138,83 @@ static struct bt_le_scan_cb scan_callbacks = {
 static void mipe_connected(struct bt_conn *conn, uint8_t err)
 {
     char addr[BT_ADDR_LE_STR_LEN];
+    
+    // Only handle the link created by mipe_scanner_connect_to_mipe()
+    if (conn != mipe_conn) {
+        return;
+    }
+    
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
     
     if (err) {
         LOG_ERR("Failed to connect to Mipe %s (err %u)", addr, err);
+        bt_conn_unref(mipe_conn);
+        mipe_conn = NULL;
         connected_to_mipe = false;
         return;
     }
     
     LOG_INF("Connected to Mipe: %s", addr);
-    mipe_conn = bt_conn_ref(conn);
     connected_to_mipe = true;
+    host_telemetry_event(HOST_TELEMETRY_EV_MIPE_LINK, 1, 0);
     connection_start_time = k_uptime_get_32();
     
+    // Start connection-event RSSI sampling
+    update_sample_period(conn);
+    k_work_reschedule_for_queue(&rssi_workq, &rssi_sample_work, K_NO_WAIT);
+    
     // Send connection status to App
     if (ble_service_is_app_connected()) {
-        ble_service_send_mipe_status(2, last_rssi, (uint8_t *)addr, 0, 3.8f);
+        ble_service_send_mipe_status(2, last_rssi, bt_conn_get_dst(conn)->a.val, 0, synced_battery_voltage());
     }
 }
 
 static void mipe_disconnected(struct bt_conn *conn, uint8_t reason)
 {
     char addr[BT_ADDR_LE_STR_LEN];
-    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
     
+    if (conn != mipe_conn) {
+        return;
+    }
+    
+    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
     LOG_INF("Disconnected from Mipe %s (reason %u)", addr, reason);
     
-    if (mipe_conn == conn) {
-        bt_conn_unref(mipe_conn);
-        mipe_conn = NULL;
-        connected_to_mipe = false;
-        
-        // Calculate connection duration
-        uint32_t connection_duration = k_uptime_get_32() - connection_start_time;
-        
-        // Send disconnection status to App
-        if (ble_service_is_app_connected()) {
-            ble_service_send_mipe_status(4, last_rssi, (uint8_t *)addr, connection_duration, 3.8f);
-        }
+    // Wait for a running sample to finish: it uses mipe_conn without a reference
+    connected_to_mipe = false;
+    k_work_cancel_delayable_sync(&rssi_sample_work, &rssi_sync);
+    
+    bt_conn_unref(mipe_conn);
+    mipe_conn = NULL;
+    host_energy_set(HOST_ENERGY_MIPE_LINK, false, 0);
+    host_telemetry_event(HOST_TELEMETRY_EV_MIPE_LINK, 0, reason);
+    
+    // Calculate connection duration
+    uint32_t connection_duration = k_uptime_get_32() - connection_start_time;
+    LOG_INF("Mipe link lasted %u ms, %u RSSI samples", connection_duration, rssi_samples);
+    
+    // Send disconnection status to App
+    if (ble_service_is_app_connected()) {
+        ble_service_send_mipe_status(4, last_rssi, mipe_address.a.val, connection_duration, synced_battery_voltage());
     }
 }
 
+static void mipe_le_param_updated(struct bt_conn *conn, uint16_t interval,
+                                  uint16_t latency, uint16_t timeout)
+{
+    if (conn != mipe_conn) {
+        return;
+    }
+    
+    sample_period_us = BT_GAP_CONN_INTERVAL_TO_US(interval);
+    host_energy_set(HOST_ENERGY_MIPE_LINK, true, sample_period_us);
+    LOG_INF("Mipe link interval updated to %u us", sample_period_us);
+}
+
 static struct bt_conn_cb mipe_conn_callbacks = {
     .connected = mipe_connected,
     .disconnected = mipe_disconnected,
+    .le_param_updated = mipe_le_param_updated,
 };
 
 // ========================================
@@ -120,12 +225,12 @@ int mipe_scanner_init(void)
 {
     LOG_INF("Initializing Mipe scanner");
     
-    // Register scan callbacks
-    int err = bt_le_scan_cb_register(&scan_callbacks);
-    if (err) {
-        LOG_ERR("Failed to register scan callbacks: %d", err);
-        return err;
-    }
+    // Advertisement reports are handled by the Host scan callback in main.c
+    
+    k_work_queue_start(&rssi_workq, rssi_workq_stack,
+                       K_THREAD_STACK_SIZEOF(rssi_workq_stack),
+                       MIPE_RSSI_WORKQ_PRIORITY, NULL);
+    k_work_init_delayable(&rssi_sample_work, rssi_sample_work_handler);
     
     // Register connection callbacks
     bt_conn_cb_register(&mipe_conn_callbacks);
@@ -188,7 +293,7 @@ bool mipe_scanner_is_active(void)
     return scanning_active;
 }
 
-int mipe_scanner_connect_to_mipe(const bt_addr_le_t *addr)
+int mipe_scanner_connect_to_mipe(const bt_addr_le_t *addr, uint8_t phy)
 {
     if (!addr) {
         return -EINVAL;
@@ -204,16 +309,26 @@ int mipe_scanner_connect_to_mipe(const bt_addr_le_t *addr)
     
     LOG_INF("Connecting to Mipe: %s", addr_str);
     
-    // Configure connection parameters
+    // Configure connection parameters - short interval for connection-event RSSI sampling
     struct bt_le_conn_param conn_param = BT_LE_CONN_PARAM_INIT(
-        BT_GAP_INIT_CONN_INT_MIN,          // 30ms min interval
-        BT_GAP_INIT_CONN_INT_MAX,          // 50ms max interval
+        MIPE_LINK_INT_MIN,                 // 7.5ms min interval
+        MIPE_LINK_INT_MAX,                 // 30ms max interval
         0,                                  // No latency
         BT_GAP_INIT_CONN_TIMEOUT           // 4 second timeout
     );
     
+    memcpy(&mipe_address, addr, sizeof(bt_addr_le_t));
+    
+    // Initiate on the PHY the tag advertises on (Coded in long-range mode)
+    struct bt_conn_le_create_param create_param = BT_CONN_LE_CREATE_PARAM_INIT(
+        (phy == BT_GAP_LE_PHY_CODED) ? (BT_CONN_LE_OPT_CODED | BT_CONN_LE_OPT_NO_1M)
+                                     : BT_CONN_LE_OPT_NONE,
+        BT_GAP_SCAN_FAST_INTERVAL,
+        BT_GAP_SCAN_FAST_INTERVAL
+    );
+    
     // Create connection
-    int err = bt_conn_le_create(addr, &conn_param, &mipe_conn);
+    int err = bt_conn_le_create(addr, &create_param, &conn_param, &mipe_conn);
     if (err) {
         LOG_ERR("Failed to create connection: %d", err);
         return err;
@@ -221,7 +336,7 @@ int mipe_scanner_connect_to_mipe(const bt_addr_le_t *addr)
     
     // Send scanning status to App
     if (ble_service_is_app_connected()) {
-        ble_service_send_mipe_status(1, last_rssi, (uint8_t *)addr, 0, 3.8f);
+        ble_service_send_mipe_status(1, last_rssi, addr->a.val, 0, synced_battery_voltage());
     }
     
     return 0;
@@ -252,18 +367,21 @@ bool mipe_scanner_is_connected_to_mipe(void)
 
 int mipe_scanner_read_battery(float *battery_voltage)
 {
-    if (!connected_to_mipe || !mipe_conn) {
-        return -ENOTCONN;
-    }
+    struct mipe_sync_result sync;
     
     if (!battery_voltage) {
         return -EINVAL;
     }
     
-    // For now, return fake 3.8V battery reading
-    *battery_voltage = 3.8f;
+    // Battery comes from the last successful sync transaction
+    if (mipe_sync_get_last_result(&sync) || sync.err || sync.battery_mv == 0) {
+        return -ENODATA;
+    }
+    
+    *battery_voltage = sync.battery_mv / 1000.0f;
     
-    LOG_INF("Battery reading: %.2fV (fake)", *battery_voltage);
+    LOG_INF("Battery reading: %.2fV (synced %u ms ago)", (double)*battery_voltage,
+            k_uptime_get_32() - sync.host_clock_ms);
     return 0;
 }
 
@@ -282,3 +400,44 @@ int mipe_scanner_get_mipe_address(bt_addr_le_t *addr)
     memcpy(addr, &mipe_address, sizeof(bt_addr_le_t));
     return 0;
 }
+
+void mipe_scanner_set_connected_mode(bool enable)
+{
+    if (connected_mode_enabled == enable) {
+        return;
+    }
+    
+    connected_mode_enabled = enable;
+    LOG_INF("Connected measurement mode %s", enable ? "ENABLED" : "DISABLED");
+    
+    // Leaving connected mode drops the persistent link
+    if (!enable && connected_to_mipe) {
+        mipe_scanner_disconnect_from_mipe();
+    }
+}
+
+bool mipe_scanner_is_connected_mode(void)
+{
+    return connected_mode_enabled;
+}
+
+struct bt_conn *mipe_scanner_get_conn(void)
+{
+    return connected_to_mipe ? mipe_conn : NULL;
+}
+
+bool mipe_scanner_is_link_busy(void)
+{
+    // A connection attempt is pending or established
+    return mipe_conn != NULL;
+}
+
+void mipe_scanner_get_link_stats(uint32_t *samples, uint32_t *errors)
+{
+    if (samples) {
+        *samples = rssi_samples;
+    }
+    if (errors) {
+        *errors = rssi_sample_errors;
+    }
+}
@@ -19,6 +19,24 @@
 // Mipe device name to scan for
 #define MIPE_DEVICE_NAME     "MIPE"
 
+// Connected measurement: persistent link sampled on every connection event
+#ifndef MIPE_CONNECTED_MODE_DEFAULT
+#define MIPE_CONNECTED_MODE_DEFAULT  false
+#endif
+#define MIPE_LINK_INT_MIN    6     // 7.5ms (1.25ms units)
+#define MIPE_LINK_INT_MAX    24    // 30ms (1.25ms units)
+
+// HCI Read RSSI returns 127 when no RSSI is available
+#define MIPE_RSSI_UNAVAILABLE 127
+
+// Sampling period floor (the shortest connection interval), also used
+// until the link interval is known
+#define MIPE_RSSI_MIN_PERIOD_US     7500
+
+// RSSI sampling work queue
+#define MIPE_RSSI_WORKQ_STACK_SIZE  1024
+#define MIPE_RSSI_WORKQ_PRIORITY    5
+
 // ========================================
 // FUNCTION PROTOTYPES
 // ========================================
@@ -50,9 +68,10 @@ bool mipe_scanner_is_active(void);
 /**
  * Connect to Mipe device for battery reading
  * @param addr Mipe device address
+ * @param phy Primary PHY the tag advertises on (BT_GAP_LE_PHY_*)
  * @return 0 on success, negative error code on failure
  */
-int mipe_scanner_connect_to_mipe(const bt_addr_le_t *addr);
+int mipe_scanner_connect_to_mipe(const bt_addr_le_t *addr, uint8_t phy);
 
 /**
  * Disconnect from Mipe device
@@ -67,9 +86,9 @@ int mipe_scanner_disconnect_from_mipe(void);
 bool mipe_scanner_is_connected_to_mipe(void);
 
 /**
- * Read battery voltage from Mipe (fake 3.8V for now)
+ * Get the battery voltage read by the last successful Mipe sync
  * @param battery_voltage Pointer to store battery voltage
- * @return 0 on success, negative error code on failure
+ * @return 0 on success, -ENODATA if no battery reading is available
  */
 int mipe_scanner_read_battery(float *battery_voltage);
 
@@ -79,6 +98,39 @@ int mipe_scanner_read_battery(float *battery_voltage);
  */
 int8_t mipe_scanner_get_last_rssi(void);
 
+/**
+ * Enable or disable connected measurement mode
+ * When enabled the Host keeps a link to the Mipe and samples RSSI on every
+ * connection event instead of relying on advertisements only.
+ * @param enable true to enable, false to disable (drops an open link)
+ */
+void mipe_scanner_set_connected_mode(bool enable);
+
+/**
+ * Check if connected measurement mode is enabled
+ * @return true if enabled, false otherwise
+ */
+bool mipe_scanner_is_connected_mode(void);
+
+/**
+ * Get the established Mipe link
+ * @return Connection object, or NULL if not connected
+ */
+struct bt_conn *mipe_scanner_get_conn(void);
+
+/**
+ * Check if a Mipe link is being created or is established
+ * @return true if a link attempt is pending or connected, false otherwise
+ */
+bool mipe_scanner_is_link_busy(void);
+
+/**
+ * Get connection-event RSSI sampling counters
+ * @param samples Number of RSSI samples taken (may be NULL)
+ * @param errors Number of failed RSSI reads (may be NULL)
+ */
+void mipe_scanner_get_link_stats(uint32_t *samples, uint32_t *errors);
+
 /**
  * Get Mipe device address
  * @param addr Pointer to store device address
@@ -0,0 +1,562 @@
+#include "mipe_sync.h"
+#include "mipe_scanner.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(mipe_sync, LOG_LEVEL_INF);
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+enum sync_state {
+    SYNC_IDLE,
+    SYNC_CONNECTING,
+    SYNC_DISCOVERING,
+    SYNC_READING,
+    SYNC_DISCONNECTING,
+};
+
+static const struct bt_uuid_128 sync_service_uuid = BT_UUID_INIT_128(BT_UUID_MIPE_SYNC_SERVICE_VAL);
+static const struct bt_uuid_128 sync_battery_uuid = BT_UUID_INIT_128(BT_UUID_MIPE_SYNC_BATTERY_VAL);
+static const struct bt_uuid_128 sync_clock_uuid = BT_UUID_INIT_128(BT_UUID_MIPE_SYNC_CLOCK_VAL);
+
+static enum sync_state state = SYNC_IDLE;
+static struct bt_conn *sync_conn = NULL;
+static bool own_conn = false;
+static mipe_sync_done_cb_t done_callback = NULL;
+
+// Current and last completed transaction
+static struct mipe_sync_result result;
+static struct mipe_sync_result last_result;
+static bool last_result_valid = false;
+
+// Phase timestamps (uptime ms)
+static uint32_t t_start;
+static uint32_t t_connected;
+static uint32_t t_read_request;
+static uint32_t t_disconnect_start;
+
+static struct k_work_delayable timeout_work;
+static struct k_work report_work;
+static struct k_work save_work;
+
+// GATT procedure parameters (must stay valid while the procedure runs)
+static struct bt_gatt_discover_params discover_params;
+static struct bt_gatt_read_params read_params;
+static uint16_t read_handles[2];
+static uint16_t svc_end_handle;
+static uint16_t found_battery_handle;
+static uint16_t found_clock_handle;
+
+// ========================================
+// HANDLE CACHE
+// ========================================
+
+struct handle_cache_entry {
+    bt_addr_le_t addr;
+    uint16_t battery_handle;
+    uint16_t clock_handle;
+    bool valid;
+};
+
+static struct handle_cache_entry handle_cache[MIPE_SYNC_HANDLE_CACHE_SIZE];
+static uint8_t handle_cache_next = 0;
+
+#define HANDLE_CACHE_KEY    "mipe_sync/handles"
+
+#if defined(CONFIG_SETTINGS)
+/**
+ * Restore the cache saved by an earlier boot (settings_load())
+ */
+static int handle_cache_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+
+    if (!settings_name_steq(name, "handles", &next) || next) {
+        return -ENOENT;
+    }
+
+    // A different cache size or layout is dropped; tags are rediscovered
+    if (len != sizeof(handle_cache)) {
+        return 0;
+    }
+
+    ssize_t read = read_cb(cb_arg, handle_cache, sizeof(handle_cache));
+    if (read != sizeof(handle_cache)) {
+        memset(handle_cache, 0, sizeof(handle_cache));
+        return read < 0 ? read : -EINVAL;
+    }
+
+    // Replace entries in order after a reboot
+    handle_cache_next = 0;
+    LOG_INF("Mipe sync handle cache restored");
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(mipe_sync, "mipe_sync", NULL, handle_cache_set, NULL, NULL);
+#endif
+
+static struct handle_cache_entry *cache_lookup(const bt_addr_le_t *addr)
+{
+    for (int i = 0; i < ARRAY_SIZE(handle_cache); i++) {
+        if (handle_cache[i].valid && bt_addr_le_eq(&handle_cache[i].addr, addr)) {
+            return &handle_cache[i];
+        }
+    }
+    return NULL;
+}
+
+static void cache_store(const bt_addr_le_t *addr, uint16_t battery_handle, uint16_t clock_handle)
+{
+    struct handle_cache_entry *entry = cache_lookup(addr);
+
+    if (!entry) {
+        // Replace the oldest entry
+        entry = &handle_cache[handle_cache_next];
+        handle_cache_next = (handle_cache_next + 1) % ARRAY_SIZE(handle_cache);
+    }
+
+    bt_addr_le_copy(&entry->addr, addr);
+    entry->battery_handle = battery_handle;
+    entry->clock_handle = clock_handle;
+    entry->valid = true;
+
+    k_work_submit(&save_work);
+}
+
+static void cache_invalidate(struct handle_cache_entry *entry)
+{
+    entry->valid = false;
+    k_work_submit(&save_work);
+}
+
+// ========================================
+// TRANSACTION HELPERS
+// ========================================
+
+static void finish(int err)
+{
+    uint32_t now = k_uptime_get_32();
+
+    if (state == SYNC_IDLE) {
+        return;
+    }
+
+    k_work_cancel_delayable(&timeout_work);
+
+    if (result.err == 0) {
+        result.err = err;
+    }
+    result.total_ms = now - t_start;
+    if (own_conn && state == SYNC_DISCONNECTING) {
+        result.disconnect_ms = now - t_disconnect_start;
+    }
+
+    if (sync_conn) {
+        bt_conn_unref(sync_conn);
+        sync_conn = NULL;
+    }
+    state = SYNC_IDLE;
+
+    last_result = result;
+    last_result_valid = true;
+
+    // Report from the system work queue, not the Bluetooth stack context
+    k_work_submit(&report_work);
+}
+
+static void end_transaction(int err)
+{
+    if (err && result.err == 0) {
+        result.err = err;
+    }
+
+    if (!own_conn) {
+        // Borrowed link stays up for connected measurement
+        finish(0);
+        return;
+    }
+
+    state = SYNC_DISCONNECTING;
+    t_disconnect_start = k_uptime_get_32();
+    int disc_err = bt_conn_disconnect(sync_conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+    if (disc_err) {
+        LOG_WRN("Sync disconnect failed: %d", disc_err);
+        finish(disc_err);
+    }
+}
+
+static uint8_t read_cb(struct bt_conn *conn, uint8_t err,
+                       struct bt_gatt_read_params *params,
+                       const void *data, uint16_t length);
+static int start_discovery(void);
+
+static int start_read(uint16_t battery_handle, uint16_t clock_handle)
+{
+    read_handles[0] = battery_handle;
+    read_handles[1] = clock_handle;
+
+    memset(&read_params, 0, sizeof(read_params));
+    read_params.func = read_cb;
+    read_params.handle_count = ARRAY_SIZE(read_handles);
+    read_params.handles = read_handles;
+    read_params.multiple_variable = false;
+
+    state = SYNC_READING;
+    t_read_request = k_uptime_get_32();
+    return bt_gatt_read(sync_conn, &read_params);
+}
+
+static uint8_t read_cb(struct bt_conn *conn, uint8_t err,
+                       struct bt_gatt_read_params *params,
+                       const void *data, uint16_t length)
+{
+    if (state != SYNC_READING) {
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (err) {
+        LOG_WRN("Sync read failed (ATT err 0x%02x)", err);
+
+        // Cached handles may be stale (Mipe firmware changed) - rediscover once
+        if (result.cached_handles) {
+            struct handle_cache_entry *entry = cache_lookup(&result.addr);
+            if (entry) {
+                cache_invalidate(entry);
+            }
+            result.cached_handles = false;
+
+            int disc_err = start_discovery();
+            if (disc_err == 0) {
+                return BT_GATT_ITER_STOP;
+            }
+            LOG_ERR("Sync rediscovery failed: %d", disc_err);
+        }
+        end_transaction(-EIO);
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (data) {
+        // Read Multiple response: battery value followed by clock value
+        if (length < MIPE_SYNC_BATTERY_LEN + MIPE_SYNC_CLOCK_LEN) {
+            LOG_WRN("Sync read response too short: %u bytes", length);
+            end_transaction(-EMSGSIZE);
+            return BT_GATT_ITER_STOP;
+        }
+
+        const uint8_t *bytes = data;
+        result.battery_mv = sys_get_le16(&bytes[0]);
+        result.battery_percent = bytes[2];
+        result.mipe_clock_ms = sys_get_le32(&bytes[MIPE_SYNC_BATTERY_LEN]);
+        result.host_clock_ms = k_uptime_get_32();
+        result.clock_rtt_ms = result.host_clock_ms - t_read_request;
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    // data == NULL: read procedure complete
+    result.read_ms = k_uptime_get_32() - t_connected;
+    end_transaction(0);
+    return BT_GATT_ITER_STOP;
+}
+
+static uint8_t discover_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                           struct bt_gatt_discover_params *params)
+{
+    if (state != SYNC_DISCOVERING) {
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (params->type == BT_GATT_DISCOVER_PRIMARY) {
+        if (!attr) {
+            LOG_ERR("Mipe sync service not found");
+            end_transaction(-ENOENT);
+            return BT_GATT_ITER_STOP;
+        }
+
+        const struct bt_gatt_service_val *svc = attr->user_data;
+        svc_end_handle = svc->end_handle;
+
+        // Continue with the characteristics of this service
+        discover_params.uuid = NULL;
+        discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+        discover_params.start_handle = attr->handle + 1;
+        discover_params.end_handle = svc_end_handle;
+
+        int err = bt_gatt_discover(conn, &discover_params);
+        if (err) {
+            LOG_ERR("Characteristic discovery failed: %d", err);
+            end_transaction(err);
+        }
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (attr) {
+        const struct bt_gatt_chrc *chrc = attr->user_data;
+
+        if (bt_uuid_cmp(chrc->uuid, &sync_battery_uuid.uuid) == 0) {
+            found_battery_handle = chrc->value_handle;
+        } else if (bt_uuid_cmp(chrc->uuid, &sync_clock_uuid.uuid) == 0) {
+            found_clock_handle = chrc->value_handle;
+        }
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    // Characteristic discovery complete
+    if (!found_battery_handle || !found_clock_handle) {
+        LOG_ERR("Mipe sync characteristics missing (battery 0x%04x, clock 0x%04x)",
+                found_battery_handle, found_clock_handle);
+        end_transaction(-ENOENT);
+        return BT_GATT_ITER_STOP;
+    }
+
+    LOG_INF("Mipe sync handles discovered: battery 0x%04x, clock 0x%04x - caching",
+            found_battery_handle, found_clock_handle);
+    cache_store(&result.addr, found_battery_handle, found_clock_handle);
+
+    int err = start_read(found_battery_handle, found_clock_handle);
+    if (err) {
+        LOG_ERR("Sync read request failed: %d", err);
+        end_transaction(err);
+    }
+    return BT_GATT_ITER_STOP;
+}
+
+static int start_discovery(void)
+{
+    found_battery_handle = 0;
+    found_clock_handle = 0;
+
+    memset(&discover_params, 0, sizeof(discover_params));
+    discover_params.uuid = &sync_service_uuid.uuid;
+    discover_params.func = discover_cb;
+    discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+    discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+    discover_params.type = BT_GATT_DISCOVER_PRIMARY;
+
+    state = SYNC_DISCOVERING;
+    return bt_gatt_discover(sync_conn, &discover_params);
+}
+
+/**
+ * Link is up: read with cached handles, or discover them first
+ */
+static void start_gatt_phase(void)
+{
+    struct handle_cache_entry *entry = cache_lookup(&result.addr);
+    int err;
+
+    if (entry) {
+        result.cached_handles = true;
+        err = start_read(entry->battery_handle, entry->clock_handle);
+    } else {
+        err = start_discovery();
+    }
+
+    if (err) {
+        LOG_ERR("Sync GATT request failed: %d", err);
+        end_transaction(err);
+    }
+}
+
+// ========================================
+// WORK HANDLERS
+// ========================================
+
+static void timeout_work_handler(struct k_work *work)
+{
+    if (state == SYNC_IDLE) {
+        return;
+    }
+
+    LOG_WRN("Mipe sync timed out after %u ms (state %d)", MIPE_SYNC_TIMEOUT_MS, state);
+    result.err = -ETIMEDOUT;
+
+    if (own_conn && sync_conn) {
+        // Also cancels a pending connection attempt
+        state = SYNC_DISCONNECTING;
+        t_disconnect_start = k_uptime_get_32();
+        if (bt_conn_disconnect(sync_conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN) == 0) {
+            return;
+        }
+    }
+    finish(-ETIMEDOUT);
+}
+
+static void report_work_handler(struct k_work *work)
+{
+    if (done_callback) {
+        done_callback(&last_result);
+    }
+}
+
+/**
+ * Persist the handle cache (flash writes stay out of the Bluetooth stack context)
+ */
+static void save_work_handler(struct k_work *work)
+{
+    if (!IS_ENABLED(CONFIG_SETTINGS)) {
+        return;
+    }
+
+    int err = settings_save_one(HANDLE_CACHE_KEY, handle_cache, sizeof(handle_cache));
+    if (err) {
+        LOG_WRN("Failed to save Mipe sync handles: %d", err);
+    }
+}
+
+// ========================================
+// CONNECTION CALLBACKS
+// ========================================
+
+static void sync_connected(struct bt_conn *conn, uint8_t err)
+{
+    if (conn != sync_conn) {
+        return;
+    }
+
+    // Also reached when the timeout cancelled a pending connection attempt
+    if (err) {
+        LOG_ERR("Sync connection failed (err %u)", err);
+        finish(-ENOTCONN);
+        return;
+    }
+
+    if (state != SYNC_CONNECTING) {
+        return;
+    }
+
+    t_connected = k_uptime_get_32();
+    result.connect_ms = t_connected - t_start;
+    LOG_INF("Sync link up in %u ms", result.connect_ms);
+
+    start_gatt_phase();
+}
+
+static void sync_disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    if (conn != sync_conn) {
+        return;
+    }
+
+    if (state != SYNC_DISCONNECTING) {
+        LOG_WRN("Sync link lost during transaction (reason %u)", reason);
+        finish(-ECONNRESET);
+        return;
+    }
+
+    finish(0);
+}
+
+static struct bt_conn_cb sync_conn_callbacks = {
+    .connected = sync_connected,
+    .disconnected = sync_disconnected,
+};
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+int mipe_sync_init(mipe_sync_done_cb_t done_cb)
+{
+    done_callback = done_cb;
+
+    k_work_init_delayable(&timeout_work, timeout_work_handler);
+    k_work_init(&report_work, report_work_handler);
+    k_work_init(&save_work, save_work_handler);
+    bt_conn_cb_register(&sync_conn_callbacks);
+
+    LOG_INF("Mipe sync initialized (timeout %u ms, %d cached tags)",
+            MIPE_SYNC_TIMEOUT_MS, MIPE_SYNC_HANDLE_CACHE_SIZE);
+    return 0;
+}
+
+int mipe_sync_start(const bt_addr_le_t *addr, uint8_t phy)
+{
+    char addr_str[BT_ADDR_LE_STR_LEN];
+    int err;
+
+    if (!addr) {
+        return -EINVAL;
+    }
+
+    if (state != SYNC_IDLE) {
+        return -EBUSY;
+    }
+
+    bt_addr_le_to_str(addr, addr_str, sizeof(addr_str));
+
+    memset(&result, 0, sizeof(result));
+    bt_addr_le_copy(&result.addr, addr);
+    t_start = k_uptime_get_32();
+
+    // Reuse the connected-measurement link when it points at this tag
+    struct bt_conn *link = mipe_scanner_get_conn();
+    if (link && mipe_scanner_is_connected_to_mipe() &&
+        bt_addr_le_eq(bt_conn_get_dst(link), addr)) {
+        LOG_INF("Mipe sync with %s over existing link", addr_str);
+
+        sync_conn = bt_conn_ref(link);
+        own_conn = false;
+        result.reused_link = true;
+        t_connected = t_start;
+        k_work_reschedule(&timeout_work, K_MSEC(MIPE_SYNC_TIMEOUT_MS));
+
+        start_gatt_phase();
+        return 0;
+    }
+
+    LOG_INF("Mipe sync with %s - connecting", addr_str);
+
+    // Long-range tags only advertise on the Coded PHY
+    struct bt_conn_le_create_param create_param = BT_CONN_LE_CREATE_PARAM_INIT(
+        (phy == BT_GAP_LE_PHY_CODED) ? (BT_CONN_LE_OPT_CODED | BT_CONN_LE_OPT_NO_1M)
+                                     : BT_CONN_LE_OPT_NONE,
+        MIPE_SYNC_SCAN_INTERVAL,
+        MIPE_SYNC_SCAN_WINDOW
+    );
+    create_param.timeout = MIPE_SYNC_TIMEOUT_MS / 10;
+
+    struct bt_le_conn_param conn_param = BT_LE_CONN_PARAM_INIT(
+        MIPE_SYNC_CONN_INT,
+        MIPE_SYNC_CONN_INT,
+        0,
+        MIPE_SYNC_SUPERVISION
+    );
+
+    own_conn = true;
+    state = SYNC_CONNECTING;
+
+    err = bt_conn_le_create(addr, &create_param, &conn_param, &sync_conn);
+    if (err) {
+        LOG_ERR("Sync connection create failed: %d", err);
+        state = SYNC_IDLE;
+        sync_conn = NULL;
+        return err;
+    }
+
+    k_work_reschedule(&timeout_work, K_MSEC(MIPE_SYNC_TIMEOUT_MS));
+    return 0;
+}
+
+bool mipe_sync_is_busy(void)
+{
+    return state != SYNC_IDLE;
+}
+
+int mipe_sync_get_last_result(struct mipe_sync_result *out)
+{
+    if (!last_result_valid) {
+        return -ENODATA;
+    }
+
+    *out = last_result;
+    return 0;
+}
@@ -0,0 +1,110 @@
+#ifndef MIPE_SYNC_H
+#define MIPE_SYNC_H
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// MIPE SYNC SERVICE DEFINITIONS
+// ========================================
+// Must match Mipe/src/sync_service.h
+
+#define BT_UUID_MIPE_SYNC_SERVICE_VAL \
+    BT_UUID_128_ENCODE(0x4d495045, 0x5359, 0x4e43, 0x8000, 0x000000000000)
+
+// Battery: uint16 millivolts (LE) + uint8 percent; 0 mV = not measured
+#define BT_UUID_MIPE_SYNC_BATTERY_VAL \
+    BT_UUID_128_ENCODE(0x4d495045, 0x5359, 0x4e43, 0x8000, 0x000000000001)
+
+// Clock: uint32 Mipe uptime in milliseconds (LE)
+#define BT_UUID_MIPE_SYNC_CLOCK_VAL \
+    BT_UUID_128_ENCODE(0x4d495045, 0x5359, 0x4e43, 0x8000, 0x000000000002)
+
+#define MIPE_SYNC_BATTERY_LEN   3
+#define MIPE_SYNC_CLOCK_LEN     4
+
+// ========================================
+// MIPE SYNC CONFIGURATION
+// ========================================
+
+// Whole transaction budget (connect + read + disconnect)
+#define MIPE_SYNC_TIMEOUT_MS        2000
+
+// Aggressive initial parameters: 100% initiator duty cycle, 7.5ms interval
+#define MIPE_SYNC_SCAN_INTERVAL     BT_GAP_SCAN_FAST_INTERVAL_MIN   // 30ms
+#define MIPE_SYNC_SCAN_WINDOW       BT_GAP_SCAN_FAST_INTERVAL_MIN   // 30ms
+#define MIPE_SYNC_CONN_INT          6       // 7.5ms (1.25ms units)
+#define MIPE_SYNC_SUPERVISION       100     // 1s (10ms units)
+
+// Number of Mipe tags whose GATT handles are remembered (kept in settings
+// across reboots; tags are not bonded, so the cache is keyed by address)
+#define MIPE_SYNC_HANDLE_CACHE_SIZE 8
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Outcome of one sync transaction
+ */
+struct mipe_sync_result {
+    bt_addr_le_t addr;
+    int err;                    // 0 on success, negative error code on failure
+    uint16_t battery_mv;        // Battery voltage in mV (0 = not measured by the Mipe)
+    uint8_t battery_percent;
+    uint32_t mipe_clock_ms;     // Mipe uptime reported in the clock characteristic
+    uint32_t host_clock_ms;     // Host uptime when the read response arrived
+    uint32_t clock_rtt_ms;      // Read request to response (bounds when the clock was sampled)
+    uint32_t connect_ms;        // Connection setup time
+    uint32_t read_ms;           // Discovery (if needed) + read time
+    uint32_t disconnect_ms;     // Disconnection time
+    uint32_t total_ms;          // Whole transaction
+    bool cached_handles;        // Service discovery skipped
+    bool reused_link;           // Existing Mipe link used, no connect/disconnect
+};
+
+/**
+ * Sync completion callback (runs on the system work queue)
+ * @param result Transaction outcome and per-phase timings
+ */
+typedef void (*mipe_sync_done_cb_t)(const struct mipe_sync_result *result);
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Initialize the Mipe sync transaction handler
+ * @param done_cb Called when a transaction completes or fails
+ * @return 0 on success, negative error code on failure
+ */
+int mipe_sync_init(mipe_sync_done_cb_t done_cb);
+
+/**
+ * Start a sync transaction: connect, read battery and clock, disconnect
+ * Reuses the connected-measurement link when it is open to the same tag.
+ * Scanning must be stopped by the caller before a new connection can be created.
+ * @param addr Mipe tag address
+ * @param phy Primary PHY the tag advertises on (BT_GAP_LE_PHY_*)
+ * @return 0 on success, -EBUSY if a transaction is running, negative error code otherwise
+ */
+int mipe_sync_start(const bt_addr_le_t *addr, uint8_t phy);
+
+/**
+ * Check if a sync transaction is running
+ * @return true if busy, false otherwise
+ */
+bool mipe_sync_is_busy(void);
+
+/**
+ * Get the result of the last completed transaction
+ * @param out Destination for the result
+ * @return 0 on success, -ENODATA if no transaction completed yet
+ */
+int mipe_sync_get_last_result(struct mipe_sync_result *out);
+
+#endif // MIPE_SYNC_H
@@ -0,0 +1,645 @@
+#include "mipe_tracker.h"
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(mipe_tracker, LOG_LEVEL_INF);
+
+BUILD_ASSERT((MIPE_TRACKER_TABLE_SIZE & (MIPE_TRACKER_TABLE_SIZE - 1)) == 0,
+             "Tracker table size must be a power of two");
+BUILD_ASSERT(MIPE_TRACKER_MAX_TAGS < MIPE_TRACKER_TABLE_SIZE,
+             "Tracker table must keep at least one free slot");
+
+#define TABLE_MASK (MIPE_TRACKER_TABLE_SIZE - 1)
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+// Open-addressing table with linear probing, keyed by tag address
+static struct mipe_tag table[MIPE_TRACKER_TABLE_SIZE];
+static int tag_count = 0;
+static int synthetic_count = 0;
+
+// Round-robin position for stream scheduling
+static uint32_t stream_cursor = 0;
+
+// Tag id allocation (one bit per id)
+static uint32_t id_bitmap[256 / 32];
+static uint8_t next_id = 0;
+
+static struct mipe_tracker_perf perf;
+static struct k_spinlock lock;
+
+// ========================================
+// HASH TABLE HELPERS
+// ========================================
+
+/**
+ * FNV-1a hash over address type and bytes
+ */
+static uint32_t addr_hash(const bt_addr_le_t *addr)
+{
+    uint32_t hash = 2166136261u;
+
+    hash = (hash ^ addr->type) * 16777619u;
+    for (int i = 0; i < sizeof(addr->a.val); i++) {
+        hash = (hash ^ addr->a.val[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * Find the slot holding addr, or the empty slot where it would be inserted
+ * @param found Set to true if the slot holds addr
+ */
+static uint32_t find_slot(const bt_addr_le_t *addr, bool *found)
+{
+    uint32_t slot = addr_hash(addr) & TABLE_MASK;
+    uint32_t probes = 1;
+
+    while (table[slot].in_use) {
+        if (bt_addr_le_eq(&table[slot].addr, addr)) {
+            break;
+        }
+        slot = (slot + 1) & TABLE_MASK;
+        probes++;
+    }
+
+    *found = table[slot].in_use;
+
+    perf.lookups++;
+    perf.probes += probes;
+    perf.max_probes = MAX(perf.max_probes, probes);
+
+    return slot;
+}
+
+static int alloc_id(uint8_t *id)
+{
+    for (int i = 0; i < 256; i++) {
+        uint8_t candidate = (uint8_t)(next_id + i);
+
+        if (!(id_bitmap[candidate / 32] & BIT(candidate % 32))) {
+            id_bitmap[candidate / 32] |= BIT(candidate % 32);
+            next_id = candidate + 1;
+            *id = candidate;
+            return 0;
+        }
+    }
+
+    return -ENOMEM;
+}
+
+static void free_id(uint8_t id)
+{
+    id_bitmap[id / 32] &= ~BIT(id % 32);
+}
+
+/**
+ * Remove the entry at slot, shifting later entries of the probe chain back
+ * so lookups never need tombstones.
+ */
+static void remove_slot(uint32_t slot)
+{
+    uint32_t hole = slot;
+    uint32_t next = (slot + 1) & TABLE_MASK;
+
+    if (mipe_tracker_is_synthetic(&table[slot].addr)) {
+        synthetic_count--;
+    }
+    free_id(table[slot].id);
+
+    while (table[next].in_use) {
+        uint32_t home = addr_hash(&table[next].addr) & TABLE_MASK;
+
+        // Move the entry into the hole unless its home lies cyclically in (hole, next]
+        bool stays = (hole <= next) ? (home > hole && home <= next)
+                                    : (home > hole || home <= next);
+        if (!stays) {
+            table[hole] = table[next];
+            hole = next;
+        }
+        next = (next + 1) & TABLE_MASK;
+    }
+
+    memset(&table[hole], 0, sizeof(table[hole]));
+    tag_count--;
+}
+
+/**
+ * Slot holds a real tag (in use and not synthetic)
+ */
+static bool is_live(const struct mipe_tag *tag)
+{
+    return tag->in_use && !mipe_tracker_is_synthetic(&tag->addr);
+}
+
+static void update_phy_stats(struct mipe_phy_stats *stats, int8_t rssi)
+{
+    if (stats->reports == 0) {
+        stats->rssi_min = rssi;
+        stats->rssi_max = rssi;
+    } else {
+        stats->rssi_min = MIN(stats->rssi_min, rssi);
+        stats->rssi_max = MAX(stats->rssi_max, rssi);
+    }
+
+    stats->reports++;
+    stats->rssi_sum += rssi;
+    stats->rssi_sq_sum += (uint32_t)((int32_t)rssi * rssi);
+}
+
+/**
+ * Missed events in a row that keep the false-alarm probability below
+ * MIPE_TRACKER_PRESENCE_FALSE_ALARM_PPM, and the resulting timeout
+ */
+static void update_presence_timeout(struct mipe_tag_presence *p)
+{
+    if (p->gaps < MIPE_TRACKER_PRESENCE_MIN_GAPS) {
+        p->k = 0;
+        p->timeout_ms = MIPE_TRACKER_PRESENCE_MAX_TIMEOUT_MS;
+        return;
+    }
+
+    // Per-event reception probability p = 1 / mean events per report; miss = (1 - p)^k
+    uint32_t p_q16 = (uint32_t)(((uint64_t)256 << 16) / MAX(p->events_q8, 256U));
+    uint32_t miss_q16 = 65536U - MIN(p_q16, 65535U);
+    uint64_t miss_ppm = 1000000;
+    uint8_t k = 0;
+
+    while (miss_ppm > MIPE_TRACKER_PRESENCE_FALSE_ALARM_PPM && k < MIPE_TRACKER_PRESENCE_MAX_K) {
+        miss_ppm = (miss_ppm * miss_q16) >> 16;
+        k++;
+    }
+
+    // Never shorter than the longest interval the tag announced
+    uint32_t min_ms = p->ceiling_ms ? p->ceiling_ms + MIPE_TRACKER_PRESENCE_ADV_DELAY_MS +
+                                      MIPE_TRACKER_PRESENCE_SLACK_MS : 0;
+
+    p->k = k;
+    p->timeout_ms = CLAMP(((uint32_t)k * p->interval_q4 >> 4) + MIPE_TRACKER_PRESENCE_SLACK_MS,
+                          min_ms, MIPE_TRACKER_PRESENCE_MAX_TIMEOUT_MS);
+}
+
+/**
+ * Learn the interval and reception rate from a report gap
+ * Only gaps during which the tag was present and observable are used.
+ */
+static void update_presence(struct mipe_tag_presence *p, uint32_t gap_ms)
+{
+    // Gaps that end an absence are not part of the reception statistics
+    if (p->present && p->gap_observed && gap_ms > 0) {
+        uint32_t gap_q4 = gap_ms << 4;
+
+        // Late for the learned timeout, but within the announced ceiling: the
+        // tag stepped its interval up, so the estimate starts over
+        bool late = p->k > 0 &&
+                    gap_ms > ((uint32_t)p->k * p->interval_q4 >> 4) + MIPE_TRACKER_PRESENCE_SLACK_MS;
+
+        if (late) {
+            p->gaps = 0;
+        }
+
+        if (p->interval_q4 == 0 || late) {
+            p->interval_q4 = gap_q4;
+            p->events_q8 = 256;
+        } else {
+            // Advertising events covered by the gap
+            uint32_t n = (gap_q4 + p->interval_q4 / 2) / p->interval_q4;
+
+            if (n == 0) {
+                // Faster than the estimate: the tag shortened its interval
+                p->interval_q4 -= (p->interval_q4 - gap_q4) / 4;
+                n = 1;
+            } else {
+                p->interval_q4 += ((int32_t)(gap_q4 / n) - (int32_t)p->interval_q4) / 8;
+            }
+            p->events_q8 += ((int32_t)(n << 8) - (int32_t)p->events_q8) / 8;
+        }
+
+        if (p->gaps < UINT8_MAX) {
+            p->gaps++;
+        }
+        update_presence_timeout(p);
+    }
+
+    p->gap_observed = true;
+    p->unheard_ms = 0;
+    if (!p->present) {
+        p->present = true;
+        p->changed = true;
+    }
+}
+
+/**
+ * Integer square root (for the RSSI standard deviation)
+ */
+static uint32_t isqrt(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+void mipe_tracker_init(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    memset(table, 0, sizeof(table));
+    memset(id_bitmap, 0, sizeof(id_bitmap));
+    memset(&perf, 0, sizeof(perf));
+    tag_count = 0;
+    synthetic_count = 0;
+    stream_cursor = 0;
+    next_id = 0;
+
+    k_spin_unlock(&lock, key);
+
+    LOG_INF("Mipe tracker initialized: %d tags max, %u bytes per tag, %u bytes total",
+            MIPE_TRACKER_MAX_TAGS, (unsigned int)sizeof(struct mipe_tag),
+            (unsigned int)sizeof(table));
+}
+
+int mipe_tracker_report(const bt_addr_le_t *addr, int8_t rssi, bool connectable,
+                        uint8_t phy, uint32_t now)
+{
+    uint32_t start = k_cycle_get_32();
+    int err = 0;
+    bool found;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    perf.reports++;
+    uint32_t slot = find_slot(addr, &found);
+    struct mipe_tag *tag = &table[slot];
+
+    if (!found) {
+        uint8_t id;
+
+        if (tag_count >= MIPE_TRACKER_MAX_TAGS || alloc_id(&id)) {
+            perf.table_full++;
+            err = -ENOMEM;
+            goto out;
+        }
+
+        memset(tag, 0, sizeof(*tag));
+        bt_addr_le_copy(&tag->addr, addr);
+        tag->id = id;
+        tag->in_use = true;
+        tag->filtered_rssi = (int32_t)rssi * 256;
+        tag->first_seen = now;
+        tag->stats.rssi_min = rssi;
+        tag->stats.rssi_max = rssi;
+        tag->presence.timeout_ms = MIPE_TRACKER_PRESENCE_MAX_TIMEOUT_MS;
+        update_presence(&tag->presence, 0);
+        tag_count++;
+        if (mipe_tracker_is_synthetic(addr)) {
+            synthetic_count++;
+        }
+    } else {
+        update_presence(&tag->presence, now - tag->last_seen);
+        tag->filtered_rssi += ((int32_t)rssi * 256 - tag->filtered_rssi) /
+                              MIPE_TRACKER_FILTER_DIV;
+        tag->stats.rssi_min = MIN(tag->stats.rssi_min, rssi);
+        tag->stats.rssi_max = MAX(tag->stats.rssi_max, rssi);
+    }
+
+    tag->last_rssi = rssi;
+    tag->last_seen = now;
+    tag->fresh = true;
+    tag->connectable = connectable;
+    if (phy == BT_GAP_LE_PHY_1M || phy == BT_GAP_LE_PHY_CODED) {
+        tag->last_phy = phy;
+        update_phy_stats(&tag->phy[phy == BT_GAP_LE_PHY_CODED ? MIPE_PHY_CODED : MIPE_PHY_1M],
+                         rssi);
+    }
+    if (connectable) {
+        tag->last_connectable = now;
+    } else {
+        tag->beacon = true;
+    }
+    tag->stats.reports++;
+    tag->stats.rssi_sum += rssi;
+
+out:
+    perf.cycles += k_cycle_get_32() - start;
+    k_spin_unlock(&lock, key);
+
+    return err;
+}
+
+int mipe_tracker_report_telemetry(const bt_addr_le_t *addr, uint8_t seq, int8_t tx_power,
+                                  uint8_t battery_percent, uint32_t uptime_s,
+                                  uint16_t interval_ceiling_ms)
+{
+    bool found;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    uint32_t slot = find_slot(addr, &found);
+    if (!found) {
+        k_spin_unlock(&lock, key);
+        return -ENOENT;
+    }
+
+    struct mipe_tag *tag = &table[slot];
+    struct mipe_tag_telemetry *tm = &tag->telemetry;
+    uint8_t gap = (uint8_t)(seq - tm->seq);
+
+    if (!tm->valid || uptime_s < tm->uptime_s || gap >= MIPE_TRACKER_SEQ_RESYNC_GAP) {
+        // First telemetry, tag reboot or a gap too long to tell: restart counting
+        tag->stats.seq_received = 1;
+        tag->stats.seq_expected = 1;
+    } else if (gap > 0) {
+        // Repeats of the same sequence number are not new versions. Versions
+        // sent while the tag could not be heard are not expected either.
+        tag->stats.seq_received++;
+        tag->stats.seq_expected += tm->gap_observed ? gap : 1;
+    }
+
+    tm->valid = true;
+    tm->seq = seq;
+    tm->tx_power = tx_power;
+    tm->battery_percent = battery_percent;
+    tm->uptime_s = uptime_s;
+    tm->gap_observed = true;
+
+    if (tag->presence.ceiling_ms != interval_ceiling_ms) {
+        tag->presence.ceiling_ms = interval_ceiling_ms;
+        update_presence_timeout(&tag->presence);
+    }
+
+    k_spin_unlock(&lock, key);
+    return 0;
+}
+
+bool mipe_tracker_get(const bt_addr_le_t *addr, struct mipe_tag *out)
+{
+    bool found;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    uint32_t slot = find_slot(addr, &found);
+    if (found) {
+        *out = table[slot];
+    }
+
+    k_spin_unlock(&lock, key);
+    return found;
+}
+
+bool mipe_tracker_next_for_stream(struct mipe_tag *out)
+{
+    bool found = false;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    // Start after the tag streamed last so every tag with fresh data gets its turn
+    for (uint32_t i = 1; i <= MIPE_TRACKER_TABLE_SIZE; i++) {
+        uint32_t slot = (stream_cursor + i) & TABLE_MASK;
+        struct mipe_tag *tag = &table[slot];
+
+        if (is_live(tag) && tag->fresh) {
+            *out = *tag;
+            found = true;
+            break;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+    return found;
+}
+
+void mipe_tracker_mark_streamed(const bt_addr_le_t *addr, uint32_t now)
+{
+    bool found;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    uint32_t slot = find_slot(addr, &found);
+    if (found) {
+        struct mipe_tag *tag = &table[slot];
+
+        tag->fresh = false;
+        tag->last_streamed = now;
+        tag->stats.streamed++;
+        stream_cursor = slot;
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+int mipe_tracker_expire(uint32_t now, uint32_t timeout_ms)
+{
+    int removed = 0;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    uint32_t slot = 0;
+    while (slot < MIPE_TRACKER_TABLE_SIZE) {
+        struct mipe_tag *tag = &table[slot];
+
+        if (tag->in_use && !tag->presence.present && (now - tag->last_seen) >= timeout_ms) {
+            // Backward shift may move another entry into this slot - re-check it
+            remove_slot(slot);
+            removed++;
+            continue;
+        }
+        slot++;
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (removed > 0) {
+        LOG_INF("Expired %d tag(s) not seen for %u ms, %d still tracked",
+                removed, timeout_ms, tag_count);
+    }
+    return removed;
+}
+
+int mipe_tracker_presence_update(uint32_t elapsed_ms, bool all_observed,
+                                 const bt_addr_le_t *observed, int observed_count,
+                                 struct mipe_presence_event *events, int max_events)
+{
+    int count = 0;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (uint32_t slot = 0; slot < MIPE_TRACKER_TABLE_SIZE; slot++) {
+        struct mipe_tag *tag = &table[slot];
+        struct mipe_tag_presence *p = &tag->presence;
+
+        if (!is_live(tag)) {
+            continue;
+        }
+
+        bool observable = all_observed;
+        for (int i = 0; i < observed_count && !observable; i++) {
+            observable = bt_addr_le_eq(&tag->addr, &observed[i]);
+        }
+
+        if (!observable) {
+            // Silence while nobody listens says nothing about the tag
+            p->gap_observed = false;
+            tag->telemetry.gap_observed = false;
+        } else {
+            p->unheard_ms += elapsed_ms;
+            if (p->present && p->unheard_ms >= p->timeout_ms) {
+                p->present = false;
+                p->changed = true;
+            }
+        }
+
+        if (p->changed && count < max_events) {
+            bt_addr_le_copy(&events[count].addr, &tag->addr);
+            events[count].id = tag->id;
+            events[count].present = p->present;
+            events[count].timeout_ms = p->timeout_ms;
+            p->changed = false;
+            count++;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+    return count;
+}
+
+void mipe_tracker_foreach(mipe_tracker_cb_t cb, void *user_data)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (uint32_t slot = 0; slot < MIPE_TRACKER_TABLE_SIZE; slot++) {
+        if (is_live(&table[slot])) {
+            cb(&table[slot], user_data);
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+bool mipe_tracker_next(uint32_t *cursor, struct mipe_tag *out)
+{
+    bool found = false;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    while (*cursor < MIPE_TRACKER_TABLE_SIZE) {
+        const struct mipe_tag *tag = &table[(*cursor)++];
+
+        if (is_live(tag)) {
+            *out = *tag;
+            found = true;
+            break;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+    return found;
+}
+
+int mipe_tracker_count(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    int count = tag_count - synthetic_count;
+
+    k_spin_unlock(&lock, key);
+    return count;
+}
+
+bool mipe_tracker_is_synthetic(const bt_addr_le_t *addr)
+{
+    return addr->type == BT_ADDR_LE_RANDOM &&
+           sys_get_le32(&addr->a.val[2]) == MIPE_TRACKER_SYNTHETIC_ADDR_PREFIX;
+}
+
+int mipe_tracker_remove_synthetic(void)
+{
+    int removed = 0;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    uint32_t slot = 0;
+    while (slot < MIPE_TRACKER_TABLE_SIZE) {
+        if (table[slot].in_use && mipe_tracker_is_synthetic(&table[slot].addr)) {
+            // Backward shift may move another entry into this slot - re-check it
+            remove_slot(slot);
+            removed++;
+            continue;
+        }
+        slot++;
+    }
+
+    k_spin_unlock(&lock, key);
+    return removed;
+}
+
+int8_t mipe_tag_filtered_rssi(const struct mipe_tag *tag)
+{
+    // Round to nearest dBm (filtered value is negative in practice)
+    int32_t value = tag->filtered_rssi;
+    return (int8_t)((value >= 0 ? value + 128 : value - 128) / 256);
+}
+
+int8_t mipe_tag_normalized_rssi(const struct mipe_tag *tag)
+{
+    int32_t rssi = mipe_tag_filtered_rssi(tag);
+
+    if (tag->telemetry.valid) {
+        // A louder tag reads stronger at the same distance - scale it to the reference
+        rssi += MIPE_TRACKER_REFERENCE_TX_POWER - tag->telemetry.tx_power;
+    }
+
+    return (int8_t)CLAMP(rssi, INT8_MIN, INT8_MAX);
+}
+
+uint32_t mipe_tag_phy_rssi(const struct mipe_tag *tag, enum mipe_tracker_phy phy,
+                           int32_t *mean_x10, uint32_t *stddev_x10)
+{
+    const struct mipe_phy_stats *stats = &tag->phy[phy];
+    int64_t n = stats->reports;
+
+    if (n == 0) {
+        *mean_x10 = 0;
+        *stddev_x10 = 0;
+        return 0;
+    }
+
+    // Variance x100 = (n * sum_sq - sum^2) * 100 / n^2
+    int64_t spread = n * (int64_t)stats->rssi_sq_sum - (int64_t)stats->rssi_sum * stats->rssi_sum;
+    uint64_t variance_x100 = (uint64_t)MAX(spread, 0) * 100U / (uint64_t)(n * n);
+
+    *mean_x10 = (int32_t)((int64_t)stats->rssi_sum * 10 / n);
+    *stddev_x10 = isqrt((uint32_t)MIN(variance_x100, UINT32_MAX));
+    return stats->reports;
+}
+
+uint32_t mipe_tag_loss_permille(const struct mipe_tag *tag)
+{
+    if (tag->stats.seq_expected == 0) {
+        return 0;
+    }
+
+    return 1000U - tag->stats.seq_received * 1000U / tag->stats.seq_expected;
+}
+
+void mipe_tracker_get_perf(struct mipe_tracker_perf *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = perf;
+    k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,343 @@
+#ifndef MIPE_TRACKER_H
+#define MIPE_TRACKER_H
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/addr.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// MIPE TRACKER CONFIGURATION
+// ========================================
+
+// Maximum number of Mipe tags tracked at the same time
+#define MIPE_TRACKER_MAX_TAGS       64
+
+// Hash table slots (power of two, kept at 2x capacity so probe chains stay short)
+#define MIPE_TRACKER_TABLE_SIZE     128
+
+// RSSI filter: exponential moving average with alpha = 1 / MIPE_TRACKER_FILTER_DIV
+#define MIPE_TRACKER_FILTER_DIV     4
+
+// RSSI value used when no valid reading exists
+#define MIPE_TRACKER_RSSI_INVALID   -100
+
+// Calibrated TX power (RSSI at 1 m) that normalized RSSI values are scaled to
+#define MIPE_TRACKER_REFERENCE_TX_POWER -59
+
+// Sequence gap treated as a tag restart instead of packet loss
+#define MIPE_TRACKER_SEQ_RESYNC_GAP 128
+
+// Presence: a tag is declared absent after k advertising events in a row are
+// missed, with k chosen so a present tag is declared absent with at most this
+// probability (parts per million, from its observed reception rate)
+#define MIPE_TRACKER_PRESENCE_FALSE_ALARM_PPM   1000
+
+// Fully observed report gaps needed before the learned timeout is used
+#define MIPE_TRACKER_PRESENCE_MIN_GAPS          4
+
+// Timeout until the interval is learned, and upper bound of the learned one
+#define MIPE_TRACKER_PRESENCE_MAX_TIMEOUT_MS    10000
+
+// Added to the timeout for advDelay (0-10 ms per event) and report latency
+#define MIPE_TRACKER_PRESENCE_SLACK_MS          20
+
+// Tags step their interval up from burst to slow (Mipe/src/adv_scheduler.h)
+// and announce the longest interval they may use before their next payload
+// update. The timeout never drops below that interval plus advDelay, so a
+// step-up is not taken for absence. A gap the learned timeout alone would
+// not have covered restarts the interval estimate.
+#define MIPE_TRACKER_PRESENCE_ADV_DELAY_MS      10
+
+// Upper bound for k (very lossy tags fall back to the maximum timeout)
+#define MIPE_TRACKER_PRESENCE_MAX_K             32
+
+// Reserved static random addresses C0:41:4F:4C:xx:xx for synthetic reports
+// (scan_load.h). They take the full report path but are never streamed,
+// announced, listed or counted.
+#define MIPE_TRACKER_SYNTHETIC_ADDR_PREFIX      0xC0414F4C  // a.val[5..2]
+
+// Primary advertising PHYs with separate statistics
+enum mipe_tracker_phy {
+    MIPE_PHY_1M,
+    MIPE_PHY_CODED,
+    MIPE_PHY_COUNT,
+};
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Per-tag reception statistics
+ */
+struct mipe_tag_stats {
+    uint32_t reports;        // Advertisement reports received
+    uint32_t streamed;       // Samples sent to the App
+    int32_t rssi_sum;        // Sum of raw RSSI values (for the mean)
+    int8_t rssi_min;
+    int8_t rssi_max;
+    uint32_t seq_received;   // Distinct telemetry sequence numbers received
+    uint32_t seq_expected;   // Sequence numbers sent while the tag was observable
+};
+
+/**
+ * Per-PHY RSSI statistics (advertising reports only)
+ */
+struct mipe_phy_stats {
+    uint32_t reports;
+    int32_t rssi_sum;
+    uint64_t rssi_sq_sum;    // Sum of squared RSSI, for the standard deviation
+    int8_t rssi_min;
+    int8_t rssi_max;
+};
+
+/**
+ * Telemetry last advertised by the tag
+ */
+struct mipe_tag_telemetry {
+    bool valid;              // Tag advertises telemetry
+    uint8_t seq;             // Latest sequence number
+    int8_t tx_power;         // Calibrated RSSI at 1 m (dBm)
+    uint8_t battery_percent; // 0-100, 0xFF if not measured
+    uint32_t uptime_s;       // Tag uptime in seconds
+    bool gap_observed;       // Tag observable for the whole time since the latest sequence
+};
+
+/**
+ * Presence estimate (times only advance while the tag can be heard)
+ */
+struct mipe_tag_presence {
+    bool present;            // Current presence decision
+    bool changed;            // Decision changed since the last presence event
+    bool gap_observed;       // Tag was observable for the whole time since the latest report
+    uint8_t gaps;            // Fully observed gaps in the estimate (saturating)
+    uint8_t k;               // Missed events before the tag is declared absent
+    uint32_t interval_q4;    // Advertising interval estimate (ms, Q4)
+    uint32_t events_q8;      // Mean advertising events per received report (Q8)
+    uint32_t unheard_ms;     // Observable time since the latest report
+    uint32_t timeout_ms;     // Absence timeout
+    uint16_t ceiling_ms;     // Longest interval the tag announced, 0 if not announced
+};
+
+/**
+ * Presence transition of one tag
+ */
+struct mipe_presence_event {
+    bt_addr_le_t addr;
+    uint8_t id;
+    bool present;
+    uint32_t timeout_ms;     // Timeout in force (detection latency bound)
+};
+
+/**
+ * One tracked Mipe tag
+ */
+struct mipe_tag {
+    bt_addr_le_t addr;
+    uint8_t id;              // Stable id for the lifetime of the entry, sent to the App
+    bool in_use;
+    int8_t last_rssi;        // Last raw RSSI (dBm)
+    int32_t filtered_rssi;   // Filtered RSSI in Q8 fixed point (dBm * 256)
+    uint32_t first_seen;     // Uptime (ms) of the first report
+    uint32_t last_seen;      // Uptime (ms) of the latest report
+    uint32_t last_streamed;  // Uptime (ms) of the latest sample streamed to the App
+    bool fresh;              // New report since the last streamed sample
+    bool connectable;        // Latest report was connectable
+    uint32_t last_connectable; // Uptime (ms) of the latest connectable report
+    bool beacon;             // Tag has been seen advertising non-connectable
+    uint8_t last_phy;        // Primary PHY of the latest advertising report (BT_GAP_LE_PHY_*)
+    struct mipe_phy_stats phy[MIPE_PHY_COUNT];
+    struct mipe_tag_stats stats;
+    struct mipe_tag_telemetry telemetry;
+    struct mipe_tag_presence presence;
+};
+
+/**
+ * Lookup cost counters (for benchmarking the report path)
+ */
+struct mipe_tracker_perf {
+    uint32_t lookups;        // Number of table lookups (reports, telemetry, gets)
+    uint32_t reports;        // Calls to mipe_tracker_report()
+    uint32_t probes;         // Total slots inspected by those lookups
+    uint32_t max_probes;     // Longest probe sequence seen
+    uint32_t cycles;         // Total CPU cycles spent in mipe_tracker_report()
+    uint32_t table_full;     // Reports dropped because the table was full
+};
+
+/**
+ * Iteration callback
+ * @param tag Snapshot of the tag
+ * @param user_data Caller context
+ */
+typedef void (*mipe_tracker_cb_t)(const struct mipe_tag *tag, void *user_data);
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Initialize (clear) the tracking table
+ */
+void mipe_tracker_init(void);
+
+/**
+ * Record an advertisement report from a Mipe tag
+ * Inserts the tag if it is not tracked yet.
+ * @param addr Tag address
+ * @param rssi Received RSSI (dBm)
+ * @param connectable Report came from connectable advertising (or a link)
+ * @param phy Primary PHY (BT_GAP_LE_PHY_*), BT_GAP_LE_PHY_NONE for link samples
+ * @param now Current uptime in milliseconds
+ * @return 0 on success, -ENOMEM if the table is full
+ */
+int mipe_tracker_report(const bt_addr_le_t *addr, int8_t rssi, bool connectable,
+                        uint8_t phy, uint32_t now);
+
+/**
+ * Record advertised telemetry for a tracked tag
+ * Call after mipe_tracker_report() for the same advertisement.
+ * @param addr Tag address
+ * @param seq Sequence number
+ * @param tx_power Calibrated RSSI at 1 m (dBm)
+ * @param battery_percent Battery level
+ * @param uptime_s Tag uptime in seconds
+ * @param interval_ceiling_ms Longest interval until the next update (0: not advertised)
+ * @return 0 on success, -ENOENT if the tag is not tracked
+ */
+int mipe_tracker_report_telemetry(const bt_addr_le_t *addr, uint8_t seq, int8_t tx_power,
+                                  uint8_t battery_percent, uint32_t uptime_s,
+                                  uint16_t interval_ceiling_ms);
+
+/**
+ * Get a snapshot of a tracked tag
+ * @param addr Tag address
+ * @param out Destination for the snapshot
+ * @return true if the tag is tracked, false otherwise
+ */
+bool mipe_tracker_get(const bt_addr_le_t *addr, struct mipe_tag *out);
+
+/**
+ * Pick the next tag to stream to the App (round-robin over tags with fresh data)
+ * The tag keeps its turn until mipe_tracker_mark_streamed(), so a sample
+ * that could not be sent is retried on the next pass.
+ * @param out Destination for the snapshot
+ * @return true if a tag with fresh data was found, false otherwise
+ */
+bool mipe_tracker_next_for_stream(struct mipe_tag *out);
+
+/**
+ * Mark the tag returned by mipe_tracker_next_for_stream() as streamed
+ * @param addr Tag address
+ * @param now Current uptime in milliseconds
+ */
+void mipe_tracker_mark_streamed(const bt_addr_le_t *addr, uint32_t now);
+
+/**
+ * Remove absent tags that have not been seen for a while
+ * Present tags are kept until the presence detector declares them absent,
+ * so tags are not dropped while the Host cannot hear them (advertising mode).
+ * @param now Current uptime in milliseconds
+ * @param timeout_ms Age after which an absent tag is removed
+ * @return Number of tags removed
+ */
+int mipe_tracker_expire(uint32_t now, uint32_t timeout_ms);
+
+/**
+ * Advance the presence detector
+ * Tags that cannot be heard keep their decision; their next gap is not used
+ * for the interval estimate.
+ * @param elapsed_ms Time since the previous update
+ * @param all_observed The continuous scanner was running (every tag observable)
+ * @param observed Tags heard through a dedicated source (windows, periodic sync, link)
+ * @param observed_count Number of entries in observed
+ * @param events Destination for presence transitions
+ * @param max_events Capacity of events (further transitions are returned next time)
+ * @return Number of events written
+ */
+int mipe_tracker_presence_update(uint32_t elapsed_ms, bool all_observed,
+                                 const bt_addr_le_t *observed, int observed_count,
+                                 struct mipe_presence_event *events, int max_events);
+
+/**
+ * Call a function for every tracked tag (synthetic tags excluded)
+ * The callback runs with the table locked and must not call back into the tracker.
+ * @param cb Callback
+ * @param user_data Passed through to the callback
+ */
+void mipe_tracker_foreach(mipe_tracker_cb_t cb, void *user_data);
+
+/**
+ * Copy out the next tracked tag, one slot at a time (synthetic tags excluded)
+ * The table is only locked while a tag is copied, so the caller can log or
+ * call other modules. Entries moved by a concurrent removal may be skipped
+ * or returned twice.
+ * @param cursor Iteration state, 0 to start
+ * @param out Destination for the snapshot
+ * @return true if a tag was copied, false at the end of the table
+ */
+bool mipe_tracker_next(uint32_t *cursor, struct mipe_tag *out);
+
+/**
+ * Number of tracked tags
+ * @return Tag count, synthetic tags excluded
+ */
+int mipe_tracker_count(void);
+
+/**
+ * Check for the reserved synthetic address range
+ * @param addr Address to check
+ * @return true if addr is a synthetic (load test) address
+ */
+bool mipe_tracker_is_synthetic(const bt_addr_le_t *addr);
+
+/**
+ * Remove every synthetic tag (end of a load test)
+ * @return Number of tags removed
+ */
+int mipe_tracker_remove_synthetic(void);
+
+/**
+ * Filtered RSSI of a tag in whole dBm
+ * @param tag Tag snapshot
+ * @return Filtered RSSI (dBm)
+ */
+int8_t mipe_tag_filtered_rssi(const struct mipe_tag *tag);
+
+/**
+ * Filtered RSSI normalized to the reference TX power
+ * Tags without telemetry are returned unchanged.
+ * @param tag Tag snapshot
+ * @return Normalized RSSI (dBm)
+ */
+int8_t mipe_tag_normalized_rssi(const struct mipe_tag *tag);
+
+/**
+ * RSSI mean and standard deviation on one PHY
+ * @param tag Tag snapshot
+ * @param phy PHY index
+ * @param mean_x10 Mean RSSI in 0.1 dBm
+ * @param stddev_x10 Standard deviation in 0.1 dB
+ * @return Number of reports on that PHY
+ */
+uint32_t mipe_tag_phy_rssi(const struct mipe_tag *tag, enum mipe_tracker_phy phy,
+                           int32_t *mean_x10, uint32_t *stddev_x10);
+
+/**
+ * Telemetry sequence versions missed while the tag was observable
+ * The tag advances its sequence number about once a second and repeats
+ * it in every advertising event, so this counts versions, not packets.
+ * Versions sent while nothing listened (scanner off for advertising) are
+ * not expected.
+ * @param tag Tag snapshot
+ * @return Missed versions in per mille, 0 if no telemetry was received
+ */
+uint32_t mipe_tag_loss_permille(const struct mipe_tag *tag);
+
+/**
+ * Get lookup cost counters
+ * @param out Destination for the counters
+ */
+void mipe_tracker_get_perf(struct mipe_tracker_perf *out);
+
+#endif // MIPE_TRACKER_H
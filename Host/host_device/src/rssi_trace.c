@@ -0,0 +1,397 @@
+#include "rssi_trace.h"
+#include "mipe_tracker.h"
+#include "mipe_pa_sync.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <errno.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(rssi_trace, LOG_LEVEL_INF);
+
+#if RSSI_TRACE_CAPTURE && RSSI_TRACE_REPLAY
+#error "RSSI trace capture and replay share the console UART: enable only one"
+#endif
+
+#define TRACE_ENABLED       (RSSI_TRACE_CAPTURE || RSSI_TRACE_REPLAY)
+
+#define TRACE_STACK_SIZE    1536
+#define CRC_INIT            0xFF
+
+// Sync, sync, length, crc
+#define FRAME_OVERHEAD      4
+#define FRAME_LEN           (RSSI_TRACE_BODY_LEN + FRAME_OVERHEAD)
+
+// Capture: UART output backlog; replay: more than one acknowledge window
+#define TRACE_BUF_SIZE      2048
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct k_spinlock lock;
+static struct rssi_trace_stats stats;
+
+#if TRACE_ENABLED
+static const struct device *const uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+
+RING_BUF_DECLARE(trace_ring, TRACE_BUF_SIZE);
+K_SEM_DEFINE(trace_sem, 0, 1);
+
+static void trace_thread(void *p1, void *p2, void *p3);
+K_THREAD_DEFINE(rssi_trace_tid, TRACE_STACK_SIZE, trace_thread, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+#endif
+
+#if RSSI_TRACE_REPLAY
+static rssi_trace_stream_fn stream_fn;
+static rssi_trace_report_fn report_fn;
+static uint32_t stream_interval;
+
+/**
+ * State of one replay run (from the first frame to the end frame)
+ */
+struct replay_run {
+    bool active;
+    uint32_t first_ts;          // Capture timestamp of the first frame
+    uint32_t base;              // Virtual time of the first frame
+    uint32_t now;               // Current virtual time
+    uint32_t next_stream;       // Next packetizer tick
+    uint32_t wall_start;
+    uint32_t frames;
+    uint32_t notifications;
+    uint64_t report_cycles;
+    uint32_t report_max;
+    uint32_t stream_calls;
+    uint64_t stream_cycles;
+    uint32_t stream_max;
+};
+
+static struct replay_run run;
+static uint32_t crc_errors = 0;
+static uint32_t rx_overruns = 0;
+#endif
+
+// ========================================
+// CAPTURE
+// ========================================
+
+#if RSSI_TRACE_CAPTURE
+static void trace_thread(void *p1, void *p2, void *p3)
+{
+    while (1) {
+        k_sem_take(&trace_sem, K_FOREVER);
+
+        uint8_t *data;
+        uint32_t len;
+        while ((len = ring_buf_get_claim(&trace_ring, &data, TRACE_BUF_SIZE)) > 0) {
+            for (uint32_t i = 0; i < len; i++) {
+                uart_poll_out(uart_dev, data[i]);
+            }
+            ring_buf_get_finish(&trace_ring, len);
+        }
+    }
+}
+#endif
+
+void rssi_trace_capture(const bt_addr_le_t *addr, int8_t rssi, uint8_t adv_type,
+                        bool connectable, uint8_t phy,
+                        const struct mipe_telemetry *telemetry, uint32_t now)
+{
+#if RSSI_TRACE_CAPTURE
+    uint8_t frame[FRAME_LEN];
+    uint8_t *body = &frame[3];
+
+    frame[0] = RSSI_TRACE_SYNC_0;
+    frame[1] = RSSI_TRACE_SYNC_1;
+    frame[2] = RSSI_TRACE_BODY_LEN;
+    sys_put_le32(now, &body[0]);
+    body[4] = addr->type;
+    memcpy(&body[5], addr->a.val, sizeof(addr->a.val));
+    body[11] = (uint8_t)rssi;
+    body[12] = adv_type;
+    body[13] = phy;
+    body[14] = connectable ? RSSI_TRACE_FLAG_CONNECTABLE : 0;
+    memset(&body[15], 0, RSSI_TRACE_BODY_LEN - 15);
+    if (telemetry) {
+        body[14] |= RSSI_TRACE_FLAG_TELEMETRY;
+        body[15] = telemetry->seq;
+        body[16] = (uint8_t)telemetry->tx_power;
+        body[17] = telemetry->battery_percent;
+        sys_put_le32(telemetry->uptime_s, &body[18]);
+    }
+    frame[FRAME_LEN - 1] = crc8_ccitt(CRC_INIT, &frame[2], RSSI_TRACE_BODY_LEN + 1);
+
+    // Scan and periodic reports come from different contexts: keep frames whole
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (ring_buf_space_get(&trace_ring) >= sizeof(frame)) {
+        ring_buf_put(&trace_ring, frame, sizeof(frame));
+        stats.captured++;
+    } else {
+        stats.dropped++;
+    }
+    k_spin_unlock(&lock, key);
+
+    k_sem_give(&trace_sem);
+#endif
+}
+
+// ========================================
+// REPLAY
+// ========================================
+
+#if RSSI_TRACE_REPLAY
+static void uart_isr(const struct device *dev, void *user_data)
+{
+    uint8_t buf[32];
+
+    if (!uart_irq_update(dev)) {
+        return;
+    }
+
+    while (uart_irq_rx_ready(dev)) {
+        int len = uart_fifo_read(dev, buf, sizeof(buf));
+        if (len <= 0) {
+            break;
+        }
+        if (ring_buf_put(&trace_ring, buf, len) < len) {
+            rx_overruns++;
+        }
+    }
+    k_sem_give(&trace_sem);
+}
+
+/**
+ * Run the packetizer for every send interval up to the virtual time
+ */
+static void advance_stream(uint32_t now)
+{
+    while ((int32_t)(now - run.next_stream) >= 0) {
+        uint32_t start = k_cycle_get_32();
+        stream_fn(run.next_stream);
+        uint32_t cycles = k_cycle_get_32() - start;
+
+        run.stream_calls++;
+        run.stream_cycles += cycles;
+        run.stream_max = MAX(run.stream_max, cycles);
+        run.next_stream += stream_interval;
+    }
+}
+
+static void start_run(uint32_t ts)
+{
+    // Every run starts from an empty tag table so results are reproducible
+    mipe_tracker_init();
+
+    memset(&run, 0, sizeof(run));
+    run.active = true;
+    run.first_ts = ts;
+    run.base = k_uptime_get_32();
+    run.now = run.base;
+    run.next_stream = run.base + stream_interval;
+    run.wall_start = run.base;
+    crc_errors = 0;
+    rx_overruns = 0;
+
+    LOG_INF("REPLAY,START");
+}
+
+static void finish_run(void)
+{
+    if (!run.active) {
+        return;
+    }
+
+    // Ticks up to the last report, as the live packetizer would have run them
+    advance_stream(run.now);
+
+    uint32_t wall_ms = MAX(k_uptime_get_32() - run.wall_start, 1U);
+    uint32_t virtual_ms = run.now - run.base;
+
+    LOG_INF("REPLAY,DONE,frames=%u,notifications=%u,virtual_ms=%u,wall_ms=%u,speedup=%u,"
+            "report_avg_ns=%u,report_max_ns=%u,stream_avg_ns=%u,stream_max_ns=%u,"
+            "crc_errors=%u,overruns=%u",
+            run.frames, run.notifications, virtual_ms, wall_ms, virtual_ms / wall_ms,
+            run.frames ? (uint32_t)k_cyc_to_ns_floor64(run.report_cycles / run.frames) : 0,
+            (uint32_t)k_cyc_to_ns_floor64(run.report_max),
+            run.stream_calls ? (uint32_t)k_cyc_to_ns_floor64(run.stream_cycles /
+                                                             run.stream_calls) : 0,
+            (uint32_t)k_cyc_to_ns_floor64(run.stream_max), crc_errors, rx_overruns);
+    run.active = false;
+}
+
+/**
+ * Rebuild one report and feed it through the scan (or periodic sync)
+ * receive path on the virtual clock
+ */
+static void replay_frame(const uint8_t *body, uint8_t len)
+{
+    uint32_t ts = sys_get_le32(&body[0]);
+    bool has_telemetry = len >= RSSI_TRACE_BODY_LEN && (body[14] & RSSI_TRACE_FLAG_TELEMETRY);
+    struct mipe_telemetry telemetry;
+    uint8_t data[MIPE_ADV_DATA_MAX_LEN];
+    struct net_buf_simple buf;
+    bt_addr_le_t addr;
+
+    if (!run.active) {
+        start_run(ts);
+    }
+
+    addr.type = body[4];
+    memcpy(addr.a.val, &body[5], sizeof(addr.a.val));
+    run.now = run.base + (ts - run.first_ts);
+
+    if (has_telemetry) {
+        telemetry.seq = body[15];
+        telemetry.tx_power = (int8_t)body[16];
+        telemetry.battery_percent = body[17];
+        telemetry.uptime_s = sys_get_le32(&body[18]);
+        telemetry.interval_ceiling_ms = 0;     // Not captured
+    }
+    net_buf_simple_init_with_data(&buf, data,
+                                  mipe_adv_build(has_telemetry ? &telemetry : NULL, data));
+
+    // Packetizer ticks that fall before this report run first
+    advance_stream(run.now);
+
+    uint32_t start = k_cycle_get_32();
+    if (body[12] == RSSI_TRACE_ADV_TYPE_PERIODIC) {
+        mipe_pa_sync_report(&addr, (int8_t)body[11], body[13], &buf, run.now);
+    } else {
+        struct bt_le_scan_recv_info info = {
+            .addr = &addr,
+            .sid = 0,
+            .rssi = (int8_t)body[11],
+            .tx_power = 0x7F,
+            .adv_type = body[12],
+            .adv_props = (body[14] & RSSI_TRACE_FLAG_CONNECTABLE) ?
+                         BT_GAP_ADV_PROP_CONNECTABLE : 0,
+            .interval = 0,
+            .primary_phy = body[13],
+            .secondary_phy = 0,
+        };
+
+        report_fn(&info, &buf, run.now);
+    }
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    run.report_cycles += cycles;
+    run.report_max = MAX(run.report_max, cycles);
+    run.frames++;
+
+    if (run.frames % RSSI_TRACE_ACK_FRAMES == 0) {
+        LOG_INF("REPLAY,ACK,%u", run.frames);
+    }
+}
+
+static void trace_thread(void *p1, void *p2, void *p3)
+{
+    enum { WAIT_SYNC_0, WAIT_SYNC_1, WAIT_LEN, WAIT_BODY, WAIT_CRC } state = WAIT_SYNC_0;
+    uint8_t body[RSSI_TRACE_BODY_LEN];
+    uint8_t len = 0;
+    uint8_t pos = 0;
+
+    while (1) {
+        uint8_t byte;
+
+        if (ring_buf_get(&trace_ring, &byte, 1) == 0) {
+            k_sem_take(&trace_sem, K_FOREVER);
+            continue;
+        }
+
+        switch (state) {
+        case WAIT_SYNC_0:
+            state = byte == RSSI_TRACE_SYNC_0 ? WAIT_SYNC_1 : WAIT_SYNC_0;
+            break;
+        case WAIT_SYNC_1:
+            state = byte == RSSI_TRACE_SYNC_1 ? WAIT_LEN :
+                    byte == RSSI_TRACE_SYNC_0 ? WAIT_SYNC_1 : WAIT_SYNC_0;
+            break;
+        case WAIT_LEN:
+            // Only known frame layouts and the end frame are accepted
+            len = byte;
+            pos = 0;
+            state = len == 0 ? WAIT_CRC :
+                    len == RSSI_TRACE_BODY_LEN || len == RSSI_TRACE_BODY_LEN_V1 ? WAIT_BODY :
+                    WAIT_SYNC_0;
+            break;
+        case WAIT_BODY:
+            body[pos++] = byte;
+            state = pos == len ? WAIT_CRC : WAIT_BODY;
+            break;
+        case WAIT_CRC: {
+            uint8_t crc = crc8_ccitt(CRC_INIT, &len, 1);
+            crc = crc8_ccitt(crc, body, len);
+            if (crc != byte) {
+                crc_errors++;
+            } else if (len == 0) {
+                finish_run();
+            } else {
+                replay_frame(body, len);
+            }
+            state = WAIT_SYNC_0;
+            break;
+        }
+        }
+    }
+}
+#endif
+
+void rssi_trace_on_notify(uint8_t tag_id, int8_t rssi, uint32_t now, uint8_t phy)
+{
+#if RSSI_TRACE_REPLAY
+    if (run.active) {
+        run.notifications++;
+        LOG_INF("REPLAY,NOTIFY,%u,%u,%d,%u", now - run.base, tag_id, rssi, phy);
+    }
+#endif
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+int rssi_trace_init(rssi_trace_stream_fn stream, uint32_t stream_interval_ms,
+                    rssi_trace_report_fn report)
+{
+    memset(&stats, 0, sizeof(stats));
+
+#if TRACE_ENABLED
+    if (!device_is_ready(uart_dev)) {
+        LOG_ERR("Console UART not ready");
+        return -ENODEV;
+    }
+#endif
+
+#if RSSI_TRACE_REPLAY
+    stream_fn = stream;
+    report_fn = report;
+    stream_interval = stream_interval_ms;
+
+    int err = uart_irq_callback_user_data_set(uart_dev, uart_isr, NULL);
+    if (err) {
+        LOG_ERR("UART interrupt setup failed: %d", err);
+        return err;
+    }
+    uart_irq_rx_enable(uart_dev);
+
+    LOG_INF("RSSI trace replay ready: send frames on the console UART (scanning disabled)");
+#elif RSSI_TRACE_CAPTURE
+    LOG_INF("RSSI trace capture active: %u byte frames on the console UART", FRAME_LEN);
+#endif
+
+    return 0;
+}
+
+void rssi_trace_get_stats(struct rssi_trace_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = stats;
+    k_spin_unlock(&lock, key);
+}
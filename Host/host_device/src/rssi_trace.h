@@ -0,0 +1,127 @@
+#ifndef RSSI_TRACE_H
+#define RSSI_TRACE_H
+
+#include "mipe_adv.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/addr.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// RSSI TRACE CAPTURE AND REPLAY CONFIGURATION
+// ========================================
+// Capture: every matched Mipe report is written to the console UART as a
+// binary frame, interleaved with the log text:
+//   [0xA5][0x5A][len][body][crc8]
+//   body: timestamp_ms u32, addr type, addr[6], rssi i8, adv type, phy, flags,
+//         telemetry seq, tx_power i8, battery, uptime_s u32
+// crc8 is CRC-8/CCITT (init 0xFF) over len and body. Build with capture.conf
+// so the logs do not crowd the UART.
+//
+// Replay: frames sent back on the console UART (same format, len 0 ends
+// the run) are rebuilt into advertising reports and fed through the scan
+// callback (periodic reports through the periodic sync path), then the
+// RSSI packetizer, on a virtual clock, as fast as the UART delivers them.
+// Scanning is disabled. Recordings from before the telemetry fields
+// (RSSI_TRACE_BODY_LEN_V1) replay as tags without telemetry.
+// The Host logs, one line each:
+//   REPLAY,NOTIFY,time_ms,tag,rssi,phy        every RSSI notification
+//   REPLAY,ACK,frames                         every RSSI_TRACE_ACK_FRAMES frames
+//   REPLAY,DONE,...                           run summary with stage timing
+// Build with replay.conf. rssi_trace.py drives both modes from a PC.
+
+#ifndef RSSI_TRACE_CAPTURE
+#define RSSI_TRACE_CAPTURE          0
+#endif
+
+#ifndef RSSI_TRACE_REPLAY
+#define RSSI_TRACE_REPLAY           0
+#endif
+
+#define RSSI_TRACE_SYNC_0           0xA5
+#define RSSI_TRACE_SYNC_1           0x5A
+#define RSSI_TRACE_BODY_LEN         22
+#define RSSI_TRACE_BODY_LEN_V1      15
+
+// Advertisement type for reports from a periodic advertising train
+// (the scan reports carry the BT_GAP_ADV_TYPE_* value)
+#define RSSI_TRACE_ADV_TYPE_PERIODIC 0xF0
+
+// Frame flags
+#define RSSI_TRACE_FLAG_CONNECTABLE 0x01
+#define RSSI_TRACE_FLAG_TELEMETRY   0x02    // Telemetry fields are valid
+
+// Replay flow control: acknowledge after this many processed frames
+#define RSSI_TRACE_ACK_FRAMES       32
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Packetizer run by replay at each send interval of the virtual clock
+ * @param now Virtual time in milliseconds
+ */
+typedef void (*rssi_trace_stream_fn)(uint32_t now);
+
+/**
+ * Scan report handler fed by replay (the scan callback on a given clock)
+ * @param info Rebuilt report
+ * @param buf Rebuilt advertising data
+ * @param now Virtual time in milliseconds
+ */
+typedef void (*rssi_trace_report_fn)(const struct bt_le_scan_recv_info *info,
+                                     struct net_buf_simple *buf, uint32_t now);
+
+/**
+ * Capture statistics
+ */
+struct rssi_trace_stats {
+    uint32_t captured;      // Frames written to the UART
+    uint32_t dropped;       // Frames lost to a full output buffer
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Initialize capture or replay (no-op when both are disabled)
+ * @param stream Packetizer for replay
+ * @param stream_interval_ms Send interval of the packetizer
+ * @param report Scan report handler for replay
+ * @return 0 on success, negative error code on failure
+ */
+int rssi_trace_init(rssi_trace_stream_fn stream, uint32_t stream_interval_ms,
+                    rssi_trace_report_fn report);
+
+/**
+ * Record one matched report (capture builds only)
+ * @param addr Tag address
+ * @param rssi Report RSSI in dBm
+ * @param adv_type BT_GAP_ADV_TYPE_* or RSSI_TRACE_ADV_TYPE_PERIODIC
+ * @param connectable Report was connectable
+ * @param phy Primary PHY of the report
+ * @param telemetry Decoded telemetry (NULL if the report had none)
+ * @param now Timestamp passed to the tracker
+ */
+void rssi_trace_capture(const bt_addr_le_t *addr, int8_t rssi, uint8_t adv_type,
+                        bool connectable, uint8_t phy,
+                        const struct mipe_telemetry *telemetry, uint32_t now);
+
+/**
+ * Record one RSSI notification produced by the packetizer (replay builds only)
+ * @param tag_id Tag the sample belongs to
+ * @param rssi Filtered RSSI in dBm
+ * @param now Packetizer time in milliseconds
+ * @param phy PHY reported with the sample
+ */
+void rssi_trace_on_notify(uint8_t tag_id, int8_t rssi, uint32_t now, uint8_t phy);
+
+/**
+ * Get capture statistics
+ * @param out Destination for the statistics
+ */
+void rssi_trace_get_stats(struct rssi_trace_stats *out);
+
+#endif // RSSI_TRACE_H
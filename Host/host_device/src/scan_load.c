@@ -0,0 +1,287 @@
+#include "scan_load.h"
+#include "mipe_adv.h"
+#include "mipe_tracker.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/sys/byteorder.h>
+#include <errno.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(scan_load, LOG_LEVEL_INF);
+
+#define LOAD_STACK_SIZE     2048
+#define MIPE_DEVICES        (SCAN_LOAD_DEVICES * SCAN_LOAD_MIPE_PERMILLE / 1000)
+
+/**
+ * One queued report (the payload is built by the receiving thread)
+ */
+struct load_report {
+    uint16_t device;
+    uint8_t seq;
+};
+
+/**
+ * Counters of one rate step
+ */
+struct load_step {
+    uint32_t offered;
+    uint32_t queue_drops;
+    uint32_t mipe_offered;
+    uint32_t mipe_drops;
+    uint32_t delivered;
+    uint64_t busy_cycles;
+};
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct {
+    const char *name;
+    scan_load_recv_fn recv;
+} impls[SCAN_LOAD_MAX_IMPLS];
+static int impl_count = 0;
+
+#if SCAN_LOAD
+static const uint32_t rates[] = SCAN_LOAD_RATES;
+
+static scan_load_recv_fn active_recv;
+static struct load_step step;
+static uint32_t rate_credit = 0;
+static uint32_t offered_rate = 0;
+static uint32_t step_ticks = 0;
+static uint8_t device_seq[SCAN_LOAD_DEVICES];
+static uint16_t next_device = 0;
+
+K_MSGQ_DEFINE(report_queue, sizeof(struct load_report), SCAN_LOAD_QUEUE_DEPTH, 4);
+
+static void generator_handler(struct k_timer *timer);
+K_TIMER_DEFINE(generator_timer, generator_handler, NULL);
+
+static void rx_thread(void *p1, void *p2, void *p3);
+static void control_thread(void *p1, void *p2, void *p3);
+K_SEM_DEFINE(start_sem, 0, 1);
+K_SEM_DEFINE(step_done_sem, 0, 1);
+
+// The receiver runs where scan callbacks run: the Bluetooth RX thread priority
+K_THREAD_DEFINE(scan_load_rx_tid, LOAD_STACK_SIZE, rx_thread, NULL, NULL, NULL,
+                K_PRIO_COOP(CONFIG_BT_RX_PRIO), 0, 0);
+K_THREAD_DEFINE(scan_load_ctrl_tid, 1024, control_thread, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+#endif
+
+// ========================================
+// REPORT GENERATION
+// ========================================
+
+#if SCAN_LOAD
+/**
+ * Controller side: queue this millisecond's share of the offered rate
+ * The timer ends the step itself: a saturated receiver starves the
+ * low-priority control thread.
+ */
+static void generator_handler(struct k_timer *timer)
+{
+    if (++step_ticks > SCAN_LOAD_STEP_MS) {
+        k_timer_stop(timer);
+        k_sem_give(&step_done_sem);
+        return;
+    }
+
+    rate_credit += offered_rate;
+
+    while (rate_credit >= 1000) {
+        struct load_report report = {
+            .device = next_device,
+            .seq = device_seq[next_device]++,
+        };
+        bool mipe = report.device < MIPE_DEVICES;
+
+        rate_credit -= 1000;
+        next_device = (next_device + 1) % SCAN_LOAD_DEVICES;
+        step.offered++;
+        step.mipe_offered += mipe ? 1 : 0;
+
+        if (k_msgq_put(&report_queue, &report, K_NO_WAIT)) {
+            step.queue_drops++;
+            step.mipe_drops += mipe ? 1 : 0;
+        }
+    }
+}
+
+/**
+ * Advertising data of a virtual device: Mipe telemetry or a foreign beacon
+ */
+static uint8_t build_adv_data(const struct load_report *report, uint8_t *data)
+{
+    uint8_t len = 0;
+
+    if (report->device < MIPE_DEVICES) {
+        struct mipe_telemetry telemetry = {
+            .seq = report->seq,
+            .tx_power = -59,
+            .battery_percent = 80,
+            .uptime_s = 0,
+        };
+
+        return mipe_adv_build(&telemetry, data);
+    }
+
+    data[len++] = 2;
+    data[len++] = BT_DATA_FLAGS;
+    data[len++] = BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR;
+
+    // Typical phone/beacon payload: 23 byte manufacturer data the parser must skip
+    data[len++] = 24;
+    data[len++] = BT_DATA_MANUFACTURER_DATA;
+    data[len++] = 0x4C;
+    data[len++] = 0x00;
+    for (int i = 0; i < 21; i++) {
+        data[len++] = (uint8_t)(report->device + i);
+    }
+
+    return len;
+}
+
+/**
+ * Bluetooth RX side: hand queued reports to the callback under test
+ */
+static void rx_thread(void *p1, void *p2, void *p3)
+{
+    uint8_t data[BT_GAP_ADV_MAX_ADV_DATA_LEN];
+    struct load_report report;
+
+    while (1) {
+        k_msgq_get(&report_queue, &report, K_FOREVER);
+
+        // Reserved synthetic address derived from the device index
+        bt_addr_le_t addr = {
+            .type = BT_ADDR_LE_RANDOM,
+            .a.val = { report.device & 0xFF, report.device >> 8 },
+        };
+        struct bt_le_scan_recv_info info = {
+            .addr = &addr,
+            .sid = 0,
+            .rssi = -50 - (int8_t)(report.device % 40) - (int8_t)(report.seq % 8),
+            .tx_power = 0x7F,
+            .adv_type = BT_GAP_ADV_TYPE_ADV_NONCONN_IND,
+            .adv_props = 0,
+            .interval = 0,
+            .primary_phy = BT_GAP_LE_PHY_1M,
+            .secondary_phy = 0,
+        };
+        struct net_buf_simple buf;
+
+        sys_put_le32(MIPE_TRACKER_SYNTHETIC_ADDR_PREFIX, &addr.a.val[2]);
+        net_buf_simple_init_with_data(&buf, data, build_adv_data(&report, data));
+
+        uint32_t start = k_cycle_get_32();
+        active_recv(&info, &buf);
+        step.busy_cycles += k_cycle_get_32() - start;
+        step.delivered++;
+    }
+}
+
+// ========================================
+// RATE LADDER
+// ========================================
+
+/**
+ * Offer one rate for SCAN_LOAD_STEP_MS and log its row
+ * @return Loss in permille
+ */
+static uint32_t run_step(const char *name, uint32_t rate)
+{
+    struct mipe_tracker_perf perf_before, perf_after;
+
+    memset(&step, 0, sizeof(step));
+    rate_credit = 0;
+    step_ticks = 0;
+    offered_rate = rate;
+    mipe_tracker_get_perf(&perf_before);
+
+    uint32_t start = k_cycle_get_32();
+    k_timer_start(&generator_timer, K_MSEC(1), K_MSEC(1));
+    k_sem_take(&step_done_sem, K_FOREVER);
+
+    // Let the receiver finish what the controller already queued
+    while (k_msgq_num_used_get(&report_queue) > 0) {
+        k_msleep(1);
+    }
+    uint32_t elapsed = k_cycle_get_32() - start;
+    mipe_tracker_get_perf(&perf_after);
+
+    // Mipe reports are also lost when the tag table is full
+    uint32_t mipe_lost = step.mipe_drops + (perf_after.table_full - perf_before.table_full);
+    uint32_t loss = step.offered ? step.queue_drops * 1000U / step.offered : 0;
+
+    LOG_INF("SCANLOAD,%s,%u,%u,%u,%u,%u,%u,%u,%u", name, rate, step.offered,
+            step.delivered, loss, step.mipe_offered, mipe_lost,
+            step.delivered ? (uint32_t)k_cyc_to_ns_floor64(step.busy_cycles / step.delivered) : 0,
+            (uint32_t)(step.busy_cycles * 1000U / elapsed));
+    return loss;
+}
+
+static void control_thread(void *p1, void *p2, void *p3)
+{
+    k_sem_take(&start_sem, K_FOREVER);
+    k_msleep(SCAN_LOAD_START_DELAY_MS);
+
+    LOG_INF("Scan load: %u devices (%u Mipe-like), %u rates of %u ms, queue %u",
+            SCAN_LOAD_DEVICES, MIPE_DEVICES, (unsigned int)ARRAY_SIZE(rates),
+            SCAN_LOAD_STEP_MS, SCAN_LOAD_QUEUE_DEPTH);
+    LOG_INF("SCANLOAD,impl,rate,offered,delivered,loss_permille,mipe_offered,mipe_lost,"
+            "ns_per_report,cpu_permille");
+
+    for (int i = 0; i < impl_count; i++) {
+        uint32_t saturation = 0;
+
+        // Same starting point for every callback; real tags stay tracked
+        mipe_tracker_remove_synthetic();
+        active_recv = impls[i].recv;
+
+        for (int r = 0; r < ARRAY_SIZE(rates); r++) {
+            uint32_t loss = run_step(impls[i].name, rates[r]);
+            if (saturation == 0 && loss > SCAN_LOAD_SATURATION_PERMILLE) {
+                saturation = rates[r];
+            }
+        }
+
+        if (saturation) {
+            LOG_INF("SCANLOAD,%s,saturation,%u", impls[i].name, saturation);
+        } else {
+            LOG_INF("SCANLOAD,%s,saturation,none up to %u", impls[i].name,
+                    rates[ARRAY_SIZE(rates) - 1]);
+        }
+    }
+
+    mipe_tracker_remove_synthetic();
+
+    LOG_INF("Scan load finished");
+}
+#endif
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+int scan_load_add(const char *name, scan_load_recv_fn recv)
+{
+    if (impl_count >= SCAN_LOAD_MAX_IMPLS) {
+        return -ENOMEM;
+    }
+
+    impls[impl_count].name = name;
+    impls[impl_count].recv = recv;
+    impl_count++;
+    return 0;
+}
+
+void scan_load_start(void)
+{
+#if SCAN_LOAD
+    k_sem_give(&start_sem);
+#endif
+}
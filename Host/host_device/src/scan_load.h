@@ -0,0 +1,89 @@
+#ifndef SCAN_LOAD_H
+#define SCAN_LOAD_H
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// SCAN PATH LOAD GENERATOR CONFIGURATION
+// ========================================
+// Injects synthetic advertising reports from SCAN_LOAD_DEVICES virtual
+// devices into a scan receive callback, at increasing rates. A timer plays
+// the controller and queues reports at the offered rate; a thread at the
+// Bluetooth RX priority hands them to the callback. Reports that find the
+// queue full are lost, like reports the controller cannot deliver. The
+// queue holds two timer ticks at the highest rate, so only a receiver that
+// falls behind loses reports, not the 1 ms batching.
+// Virtual devices use the reserved MIPE_TRACKER_SYNTHETIC_ADDR_PREFIX
+// addresses: the tracker processes them but keeps them away from the App,
+// the beacon and the tag counts, and they are removed after each run.
+// One CSV row per rate and callback:
+//   SCANLOAD,impl,rate,offered,delivered,loss_permille,mipe_offered,mipe_lost,ns_per_report,cpu_permille
+// and the first rate losing more than SCAN_LOAD_SATURATION_PERMILLE:
+//   SCANLOAD,impl,saturation,rate
+// Build with -DSCAN_LOAD=1 (test builds only: the load competes with real scanning).
+
+#ifndef SCAN_LOAD
+#define SCAN_LOAD                       0
+#endif
+
+// Virtual advertisers (Mipe-like ones first)
+#ifndef SCAN_LOAD_DEVICES
+#define SCAN_LOAD_DEVICES               64
+#endif
+
+// Share of the virtual advertisers that look like Mipe tags
+#ifndef SCAN_LOAD_MIPE_PERMILLE
+#define SCAN_LOAD_MIPE_PERMILLE         250
+#endif
+
+// Offered report rates, reports/s
+#define SCAN_LOAD_MAX_RATE              50000
+#define SCAN_LOAD_RATES                 { 1000, 2000, 5000, 10000, 20000, SCAN_LOAD_MAX_RATE }
+
+// Duration of each rate
+#define SCAN_LOAD_STEP_MS               2000
+
+// Report queue between the generator and the callback (controller buffers):
+// two 1 ms generator bursts at the highest rate
+#define SCAN_LOAD_QUEUE_DEPTH           (2 * SCAN_LOAD_MAX_RATE / 1000)
+
+// Loss above this marks the saturation point
+#define SCAN_LOAD_SATURATION_PERMILLE   10
+
+// Delay after boot before the first run
+#define SCAN_LOAD_START_DELAY_MS        5000
+
+// Scan receive callbacks under test
+#define SCAN_LOAD_MAX_IMPLS             4
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+/**
+ * Scan receive callback (same signature as struct bt_le_scan_cb.recv)
+ */
+typedef void (*scan_load_recv_fn)(const struct bt_le_scan_recv_info *info,
+                                  struct net_buf_simple *buf);
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Add a scan receive callback to the runs (before scan_load_start)
+ * @param name Label for the CSV rows
+ * @param recv Callback under test
+ * @return 0 on success, -ENOMEM if SCAN_LOAD_MAX_IMPLS are registered
+ */
+int scan_load_add(const char *name, scan_load_recv_fn recv);
+
+/**
+ * Run the rate ladder for every registered callback, once
+ * (no-op unless built with SCAN_LOAD)
+ */
+void scan_load_start(void);
+
+#endif // SCAN_LOAD_H
@@ -0,0 +1,426 @@
+#include "scan_predictor.h"
+#include "mipe_scanner.h"
+#include "mipe_sync.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gap.h>
+#include <stdlib.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(scan_predictor, LOG_LEVEL_INF);
+
+// Lead time needed to start the scanner before a window
+#define WINDOW_SETUP_US     1000
+
+// Scan interval/window unit (0.625 ms) and limits
+#define SCAN_UNIT_US        625
+#define SCAN_UNITS_MIN      0x0004
+#define SCAN_UNITS_MAX      0x4000
+
+// ========================================
+// GLOBAL VARIABLES
+// ========================================
+
+static struct k_spinlock lock;
+static uint32_t scan_options;
+static bool enabled = false;
+
+// Followed tag
+static bt_addr_le_t target;
+static bool has_target = false;
+static uint8_t target_phy = BT_GAP_LE_PHY_1M;
+
+// Interval and phase estimate
+static enum scan_predictor_state state = SCAN_PREDICTOR_ACQUIRE;
+static uint32_t interval_us = 0;
+static uint32_t jitter_us = 0;
+static int64_t last_arrival_us = 0;
+static uint8_t inliers = 0;
+static uint8_t outliers = 0;
+
+// Window scheduling and closed loop
+static bool window_open = false;
+static bool window_captured = false;
+static int64_t window_start_us = 0;
+static int64_t window_close_us = 0;
+static uint32_t widen_us = 0;
+static uint32_t block_windows = 0;
+static uint32_t block_captures = 0;
+static uint32_t missed_windows = 0;
+static int64_t track_since_us = 0;
+
+static struct scan_predictor_stats stats;
+
+static void open_work_handler(struct k_work *work);
+static void close_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(open_work, open_work_handler);
+static K_WORK_DELAYABLE_DEFINE(close_work, close_work_handler);
+
+// ========================================
+// ESTIMATOR
+// ========================================
+
+static int64_t now_us(void)
+{
+    return (int64_t)k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+/**
+ * Window half-width for an arrival k events after the last capture
+ * advDelay is added per event, so the spread grows with every missed event.
+ * Must be called with the lock held.
+ */
+static uint32_t half_window_us(uint32_t k)
+{
+    return SCAN_PREDICTOR_ADV_DELAY_US / 2U + SCAN_PREDICTOR_MARGIN_MIN_US + widen_us +
+           (k - 1U) * (SCAN_PREDICTOR_ADV_DELAY_US / 4U);
+}
+
+/**
+ * Windows only pay off when they cover a small part of the interval
+ * Must be called with the lock held.
+ */
+static bool schedulable(void)
+{
+    return interval_us >= SCAN_PREDICTOR_MIN_INTERVAL_US &&
+           4U * half_window_us(1) <= interval_us;
+}
+
+/**
+ * Leave TRACK and learn the tag again
+ * Must be called with the lock held.
+ */
+static void enter_acquire(int64_t now)
+{
+    if (state == SCAN_PREDICTOR_TRACK && enabled) {
+        stats.track_time_us += now - track_since_us;
+    }
+    state = SCAN_PREDICTOR_ACQUIRE;
+    inliers = 0;
+    outliers = 0;
+}
+
+/**
+ * Update interval and jitter from the time since the previous report
+ * Must be called with the lock held.
+ * @return true if the predictor just locked
+ */
+static bool update_estimate(int64_t delta, int64_t now)
+{
+    if (interval_us == 0) {
+        interval_us = (uint32_t)delta;
+        return false;
+    }
+
+    // Number of advertising events between the two reports
+    uint32_t n = (uint32_t)((delta + interval_us / 2U) / interval_us);
+    int64_t residual = delta - (int64_t)n * interval_us;
+    uint32_t tolerance = MIN(interval_us / 4U,
+                             SCAN_PREDICTOR_ADV_DELAY_US / 2U +
+                             n * (SCAN_PREDICTOR_ADV_DELAY_US / 4U));
+
+    if (n == 0 || llabs(residual) > tolerance) {
+        inliers = 0;
+        if (++outliers >= SCAN_PREDICTOR_RELEARN_SAMPLES) {
+            // The tag changed its interval (adaptive schedule): start over
+            LOG_INF("Advertising interval changed - relearning");
+            enter_acquire(now);
+            interval_us = (uint32_t)delta;
+            jitter_us = 0;
+        }
+        return false;
+    }
+
+    outliers = 0;
+    interval_us += (int32_t)(delta / n - interval_us) / 8;
+    jitter_us += ((int32_t)llabs(residual) - (int32_t)jitter_us) / 8;
+
+    if (state == SCAN_PREDICTOR_ACQUIRE && ++inliers >= SCAN_PREDICTOR_LOCK_SAMPLES &&
+        schedulable()) {
+        state = SCAN_PREDICTOR_TRACK;
+        track_since_us = now;
+        widen_us = 0;
+        block_windows = 0;
+        block_captures = 0;
+        missed_windows = 0;
+        stats.locks++;
+        return true;
+    }
+
+    return false;
+}
+
+// ========================================
+// WINDOW SCHEDULING
+// ========================================
+
+/**
+ * Schedule the window around the next predicted arrival
+ */
+static void schedule_next(void)
+{
+    int64_t now = now_us();
+    int64_t open_at = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (enabled && state == SCAN_PREDICTOR_TRACK) {
+        // Earliest arrival whose window can still be opened in time
+        uint32_t k = 1;
+        int64_t predicted = last_arrival_us + interval_us;
+
+        while (predicted - half_window_us(k) < now + WINDOW_SETUP_US) {
+            k++;
+            predicted += interval_us;
+        }
+        open_at = predicted - half_window_us(k);
+        window_close_us = predicted + half_window_us(k);
+    }
+    k_spin_unlock(&lock, key);
+
+    if (open_at != 0) {
+        k_work_reschedule(&open_work, K_USEC(open_at - now));
+    }
+}
+
+static void open_work_handler(struct k_work *work)
+{
+    struct bt_le_scan_param param = {
+        .type = BT_LE_SCAN_TYPE_PASSIVE,
+        .options = BT_LE_SCAN_OPT_NONE,
+    };
+    int64_t now = now_us();
+    bool skip;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (!enabled || state != SCAN_PREDICTOR_TRACK) {
+        k_spin_unlock(&lock, key);
+        return;
+    }
+    // Scan only the PHY the tag uses (and only if scanning it is allowed)
+    if (target_phy == BT_GAP_LE_PHY_CODED && (scan_options & BT_LE_SCAN_OPT_CODED)) {
+        param.options = BT_LE_SCAN_OPT_CODED | BT_LE_SCAN_OPT_NO_1M;
+    }
+    param.interval = CLAMP((window_close_us - now + SCAN_UNIT_US - 1) / SCAN_UNIT_US,
+                           SCAN_UNITS_MIN, SCAN_UNITS_MAX);
+    param.window = param.interval;
+    k_spin_unlock(&lock, key);
+
+    // Connection creation needs the scanner idle
+    skip = mipe_sync_is_busy() || mipe_scanner_is_link_busy();
+    if (!skip && bt_le_scan_start(&param, NULL) != 0) {
+        skip = true;
+    }
+
+    key = k_spin_lock(&lock);
+    if (skip) {
+        stats.skipped++;
+    } else {
+        window_open = true;
+        window_captured = false;
+        window_start_us = now;
+        stats.windows++;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (skip) {
+        schedule_next();
+    } else {
+        k_work_reschedule(&close_work, K_USEC(MAX(window_close_us - now, 0)));
+    }
+}
+
+/**
+ * Closed loop: widen on a poor block, narrow slowly on a perfect one
+ * Must be called with the lock held.
+ */
+static void evaluate_block(int64_t now)
+{
+    uint32_t permille = block_captures * 1000U / block_windows;
+
+    stats.block_permille = permille;
+    block_windows = 0;
+    block_captures = 0;
+
+    if (permille < SCAN_PREDICTOR_TARGET_PERMILLE) {
+        widen_us = widen_us ? widen_us * 2U : SCAN_PREDICTOR_WIDEN_STEP_US;
+        LOG_INF("Capture rate %u.%u%% below target - window +/-%u us",
+                permille / 10U, permille % 10U, half_window_us(1));
+        if (!schedulable()) {
+            LOG_WRN("Windows too wide for a %u us interval - scanning continuously",
+                    interval_us);
+            stats.losses++;
+            enter_acquire(now);
+        }
+    } else if (permille >= SCAN_PREDICTOR_NARROW_PERMILLE && widen_us > 0) {
+        widen_us -= widen_us / 4U;
+        if (widen_us < SCAN_PREDICTOR_WIDEN_STEP_US / 4U) {
+            widen_us = 0;
+        }
+    }
+}
+
+static bool is_window_open(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    bool open = window_open;
+
+    k_spin_unlock(&lock, key);
+    return open;
+}
+
+/**
+ * Close the open window and account for it
+ */
+static void close_window(void)
+{
+    int64_t now = now_us();
+
+    bt_le_scan_stop();
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    window_open = false;
+    stats.scan_time_us += now - window_start_us;
+
+    block_windows++;
+    if (window_captured) {
+        stats.captures++;
+        block_captures++;
+        missed_windows = 0;
+    } else if (++missed_windows >= SCAN_PREDICTOR_LOST_WINDOWS) {
+        // Tag gone or phase lost: follow whichever tag is heard next
+        LOG_WRN("%u windows missed - tag lost", missed_windows);
+        stats.losses++;
+        enter_acquire(now);
+        has_target = false;
+        interval_us = 0;
+    }
+
+    if (state == SCAN_PREDICTOR_TRACK && block_windows >= SCAN_PREDICTOR_RATE_BLOCK) {
+        evaluate_block(now);
+    }
+    k_spin_unlock(&lock, key);
+}
+
+static void close_work_handler(struct k_work *work)
+{
+    if (!is_window_open()) {
+        return;
+    }
+
+    close_window();
+    schedule_next();
+}
+
+// ========================================
+// PUBLIC FUNCTIONS
+// ========================================
+
+void scan_predictor_init(uint32_t options)
+{
+    scan_options = options;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void scan_predictor_report(const bt_addr_le_t *addr, uint8_t phy)
+{
+    int64_t now = now_us();
+    bool locked = false;
+    bool captured = false;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (!has_target) {
+        bt_addr_le_copy(&target, addr);
+        has_target = true;
+        interval_us = 0;
+        jitter_us = 0;
+        last_arrival_us = now;
+        enter_acquire(now);
+    } else if (bt_addr_le_eq(addr, &target) &&
+               now - last_arrival_us >= SCAN_PREDICTOR_DUPLICATE_US) {
+        target_phy = phy;
+        locked = update_estimate(now - last_arrival_us, now);
+        last_arrival_us = now;
+        if (window_open && !window_captured) {
+            window_captured = true;
+            captured = true;
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    if (locked) {
+        LOG_INF("Locked to advertising interval %u us (jitter %u us)",
+                interval_us, jitter_us);
+        schedule_next();
+    }
+
+    // Received: close the window early to free the radio
+    if (captured) {
+        k_work_reschedule(&close_work, K_NO_WAIT);
+    }
+}
+
+void scan_predictor_enable(bool enable)
+{
+    if (!SCAN_PREDICTOR_ENABLED) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    bool was_enabled = enabled;
+    enabled = enable;
+    if (state == SCAN_PREDICTOR_TRACK) {
+        if (was_enabled && !enable) {
+            stats.track_time_us += now_us() - track_since_us;
+        } else if (!was_enabled && enable) {
+            track_since_us = now_us();
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    if (enable) {
+        schedule_next();
+        return;
+    }
+
+    struct k_work_sync sync;
+    k_work_cancel_delayable_sync(&open_work, &sync);
+    k_work_cancel_delayable_sync(&close_work, &sync);
+    if (is_window_open()) {
+        close_window();
+    }
+}
+
+bool scan_predictor_is_enabled(void)
+{
+    return enabled;
+}
+
+bool scan_predictor_get_target(bt_addr_le_t *addr)
+{
+    bool tracking;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    tracking = enabled && has_target && state == SCAN_PREDICTOR_TRACK;
+    if (tracking) {
+        bt_addr_le_copy(addr, &target);
+    }
+    k_spin_unlock(&lock, key);
+
+    return tracking;
+}
+
+void scan_predictor_get_stats(struct scan_predictor_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = stats;
+    out->state = state;
+    out->interval_us = interval_us;
+    out->jitter_us = jitter_us;
+    out->half_window_us = half_window_us(1);
+    if (enabled && state == SCAN_PREDICTOR_TRACK) {
+        out->track_time_us += now_us() - track_since_us;
+    }
+    k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,122 @@
+#ifndef SCAN_PREDICTOR_H
+#define SCAN_PREDICTOR_H
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/addr.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================
+// SCAN PREDICTOR CONFIGURATION
+// ========================================
+// Learns the advertising interval and phase of one Mipe tag from report
+// arrival times and scans only in short windows around the predicted
+// arrivals. A closed loop widens the windows when the capture rate drops
+// below the target and narrows them again when it is comfortably above.
+
+// Use predicted scan windows when not scanning continuously
+#ifndef SCAN_PREDICTOR_ENABLED
+#define SCAN_PREDICTOR_ENABLED          1
+#endif
+
+// Random advDelay added by the advertiser to every event (Core spec: 0-10 ms)
+#define SCAN_PREDICTOR_ADV_DELAY_US     10000
+
+// Reports closer together than this are the same advertising event
+#define SCAN_PREDICTOR_DUPLICATE_US     2000
+
+// Consecutive consistent intervals needed before windows are scheduled
+#define SCAN_PREDICTOR_LOCK_SAMPLES     8
+
+// Consecutive inconsistent intervals that restart the interval estimate
+#define SCAN_PREDICTOR_RELEARN_SAMPLES  4
+
+// Intervals shorter than this are cheaper to scan continuously
+#define SCAN_PREDICTOR_MIN_INTERVAL_US  250000
+
+// Window margin on each side of the advDelay spread
+#define SCAN_PREDICTOR_MARGIN_MIN_US    2000
+#define SCAN_PREDICTOR_WIDEN_STEP_US    2000
+
+// Closed loop: capture rate evaluated over blocks of windows
+#define SCAN_PREDICTOR_RATE_BLOCK       20
+#define SCAN_PREDICTOR_TARGET_PERMILLE  950     // Widen below this
+#define SCAN_PREDICTOR_NARROW_PERMILLE  1000    // Narrow only after a perfect block
+
+// Consecutive missed windows after which the phase is considered lost
+#define SCAN_PREDICTOR_LOST_WINDOWS     8
+
+// ========================================
+// DATA TYPES
+// ========================================
+
+enum scan_predictor_state {
+    SCAN_PREDICTOR_ACQUIRE,     // Learning the interval, scanning continuously
+    SCAN_PREDICTOR_TRACK,       // Locked, scanning in predicted windows
+};
+
+/**
+ * Predictor statistics
+ */
+struct scan_predictor_stats {
+    enum scan_predictor_state state;
+    uint32_t interval_us;       // Estimated advertising interval (including mean advDelay)
+    uint32_t jitter_us;         // Mean absolute prediction error
+    uint32_t half_window_us;    // Current window half-width
+    uint32_t windows;           // Windows opened
+    uint32_t captures;          // Windows in which the tag was received
+    uint32_t skipped;           // Windows skipped (scanner busy)
+    uint32_t locks;             // Transitions into TRACK
+    uint32_t losses;            // Transitions back to ACQUIRE after missed windows
+    uint32_t block_permille;    // Capture rate of the last complete block
+    uint64_t scan_time_us;      // Radio time spent in windows
+    uint64_t track_time_us;     // Time spent in TRACK while enabled
+};
+
+// ========================================
+// FUNCTION PROTOTYPES
+// ========================================
+
+/**
+ * Initialize the predictor
+ * @param scan_options Scan options used for windows (BT_LE_SCAN_OPT_*)
+ */
+void scan_predictor_init(uint32_t scan_options);
+
+/**
+ * Record an advertising report arrival
+ * Call from the scan receive callback for every Mipe report. The predictor
+ * follows the first tag it hears until the tag is lost.
+ * @param addr Tag address
+ * @param phy Primary PHY of the report (BT_GAP_LE_PHY_*)
+ */
+void scan_predictor_report(const bt_addr_le_t *addr, uint8_t phy);
+
+/**
+ * Allow or stop predicted scan windows
+ * Disable before starting a continuous scan or creating a connection;
+ * returns once any open window is closed.
+ * @param enable true to schedule windows, false to stop
+ */
+void scan_predictor_enable(bool enable);
+
+/**
+ * Check whether predicted scan windows are allowed
+ * @return true if enabled
+ */
+bool scan_predictor_is_enabled(void);
+
+/**
+ * Get the tag currently followed with predicted windows
+ * @param addr Destination for the address
+ * @return true if windows are being scheduled for a tag, false otherwise
+ */
+bool scan_predictor_get_target(bt_addr_le_t *addr);
+
+/**
+ * Get predictor statistics
+ * @param out Destination for the statistics
+ */
+void scan_predictor_get_stats(struct scan_predictor_stats *out);
+
+#endif // SCAN_PREDICTOR_H
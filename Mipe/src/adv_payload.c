@@ -0,0 +1,103 @@
+/**
+ * Advertising Payload - telemetry manufacturer data with periodic refresh
+ */
+
+#include "adv_payload.h"
+#include "adv_scheduler.h"
+#include "battery.h"
+#include "periodic_adv.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(adv_payload, LOG_LEVEL_INF);
+
+static uint8_t mfg_data[MIPE_MFG_DATA_LEN];
+static uint8_t seq;
+
+static struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA(BT_DATA_NAME_COMPLETE, "MIPE", 4),
+    BT_DATA(BT_DATA_MANUFACTURER_DATA, mfg_data, sizeof(mfg_data)),
+};
+
+static void update_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(update_work, update_work_handler);
+
+static uint32_t update_period_ms(void);
+
+/**
+ * Fill the telemetry fields from the current state
+ */
+static void fill_mfg_data(void)
+{
+    uint8_t percent;
+
+    if (battery_get(NULL, &percent)) {
+        percent = MIPE_MFG_BATTERY_UNKNOWN;
+    }
+
+    /* Cover every interval used until the next update reaches the air */
+    uint32_t ceiling_ms = adv_scheduler_get_interval_ceiling_ms(
+        update_period_ms() + adv_scheduler_get_interval_max_ms());
+
+    sys_put_le16(MIPE_MFG_COMPANY_ID, &mfg_data[0]);
+    mfg_data[2] = MIPE_MFG_FORMAT_ID;
+    mfg_data[3] = seq;
+    mfg_data[4] = (uint8_t)MIPE_TX_POWER_1M_DBM;
+    mfg_data[5] = percent;
+    sys_put_le32(k_uptime_get_32() / 1000U, &mfg_data[6]);
+    mfg_data[10] = MIN(DIV_ROUND_UP(ceiling_ms, MIPE_MFG_INTERVAL_UNIT_MS), UINT8_MAX);
+}
+
+/**
+ * Update period: each sequence number must be on air for at least two
+ * advertising events, or the Host would count it as lost.
+ */
+static uint32_t update_period_ms(void)
+{
+    return MAX(ADV_PAYLOAD_UPDATE_MIN_MS, 2U * adv_scheduler_get_interval_max_ms());
+}
+
+static void update_work_handler(struct k_work *work)
+{
+    bool advertising = adv_scheduler_is_advertising();
+
+    /* Only advance the sequence while it can actually be received */
+    if (advertising || periodic_adv_is_running()) {
+        seq++;
+        fill_mfg_data();
+
+        int err = advertising ? adv_scheduler_update_data() : 0;
+        if (err) {
+            LOG_WRN("Failed to update advertising data (err %d)", err);
+        }
+
+        err = periodic_adv_update_data();
+        if (err) {
+            LOG_WRN("Failed to update periodic advertising data (err %d)", err);
+        }
+    }
+
+    k_work_reschedule(&update_work, K_MSEC(update_period_ms()));
+}
+
+void adv_payload_init(void)
+{
+    seq = 0;
+    fill_mfg_data();
+    k_work_reschedule(&update_work, K_MSEC(update_period_ms()));
+}
+
+const struct bt_data *adv_payload_get(size_t *len)
+{
+    *len = ARRAY_SIZE(ad);
+    return ad;
+}
+
+uint8_t adv_payload_get_seq(void)
+{
+    return seq;
+}
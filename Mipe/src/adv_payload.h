@@ -0,0 +1,60 @@
+/**
+ * Advertising Payload
+ *
+ * Builds the Mipe advertising data: flags, name and a compact
+ * manufacturer-specific telemetry element. The telemetry lets the Host
+ * identify a Mipe, count lost packets and learn battery and TX power
+ * without connecting.
+ *
+ * Manufacturer data layout (little endian, 11 bytes):
+ *   0-1  company id (0xFFFF, reserved for testing)
+ *   2    format id ('M')
+ *   3    sequence number, incremented on every payload update
+ *   4    calibrated TX power: expected RSSI at 1 m (dBm, signed)
+ *   5    battery level (0-100 %, 0xFF = not measured)
+ *   6-9  uptime in seconds
+ *   10   longest advertising interval until the next update (10 ms units,
+ *        rounded up), so the Host can time out absence before a slower
+ *        schedule step instead of after it
+ */
+
+#ifndef ADV_PAYLOAD_H
+#define ADV_PAYLOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+#define MIPE_MFG_COMPANY_ID     0xFFFF
+#define MIPE_MFG_FORMAT_ID      0x4D
+#define MIPE_MFG_DATA_LEN       11
+#define MIPE_MFG_BATTERY_UNKNOWN 0xFF
+
+/* Measured RSSI at 1 m for the default TX power (0 dBm), calibrate per design */
+#define MIPE_TX_POWER_1M_DBM    (-59)
+
+/* Unit of the advertised interval ceiling */
+#define MIPE_MFG_INTERVAL_UNIT_MS 10
+
+/* Payload update period, never shorter than two advertising intervals */
+#define ADV_PAYLOAD_UPDATE_MIN_MS 1000
+
+/**
+ * Build the initial payload and start periodic updates
+ */
+void adv_payload_init(void);
+
+/**
+ * Advertising data elements
+ * @param len Number of elements
+ * @return Advertising data, valid for the lifetime of the application
+ */
+const struct bt_data *adv_payload_get(size_t *len);
+
+/**
+ * Current sequence number
+ * @return Sequence number
+ */
+uint8_t adv_payload_get_seq(void);
+
+#endif /* ADV_PAYLOAD_H */
@@ -0,0 +1,443 @@
+/**
+ * Adaptive Advertising Scheduler - interval stepping and restart after disconnect
+ */
+
+#include "adv_scheduler.h"
+#include "energy_model.h"
+
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(adv_scheduler, LOG_LEVEL_INF);
+
+/* Mean extra delay the controller adds to every advertising event (0-10 ms) */
+#define ADV_DELAY_MEAN_US 5000
+
+static const char *const state_names[ADV_SCHED_STATE_COUNT] = {
+    [ADV_SCHED_BURST] = "burst",
+    [ADV_SCHED_FAST] = "fast",
+    [ADV_SCHED_NORMAL] = "normal",
+    [ADV_SCHED_SLOW] = "slow",
+};
+
+static struct adv_sched_step schedule[ADV_SCHED_STATE_COUNT] = {
+    [ADV_SCHED_BURST] = {
+        ADV_SCHED_BURST_INT_MIN, ADV_SCHED_BURST_INT_MAX, ADV_SCHED_BURST_DURATION_MS
+    },
+    [ADV_SCHED_FAST] = {
+        ADV_SCHED_FAST_INT_MIN, ADV_SCHED_FAST_INT_MAX, ADV_SCHED_FAST_DURATION_MS
+    },
+    [ADV_SCHED_NORMAL] = {
+        ADV_SCHED_NORMAL_INT_MIN, ADV_SCHED_NORMAL_INT_MAX, ADV_SCHED_NORMAL_DURATION_MS
+    },
+    [ADV_SCHED_SLOW] = {
+        ADV_SCHED_SLOW_INT_MIN, ADV_SCHED_SLOW_INT_MAX, ADV_SCHED_SLOW_DURATION_MS
+    },
+};
+
+static const struct bt_data *adv_data;
+static size_t adv_data_len;
+
+static enum adv_sched_state state = ADV_SCHED_FAST;
+static bool advertising;
+static bool connected;
+
+/* Restart state machine, only touched from the system work queue */
+static bool restart_pending;
+static uint32_t retry_delay_ms;
+static int64_t disconnect_time;
+static struct adv_sched_restart_stats restart_stats;
+
+/* Beacon mode: non-connectable, with periodic connectable windows */
+static bool beacon_mode;
+static bool window_open;
+
+/* Long-range mode: extended advertising on the Coded PHY from its own set */
+static bool long_range;
+static bool coded_active;
+static struct bt_le_ext_adv *coded_set;
+
+static void step_work_handler(struct k_work *work);
+static void window_work_handler(struct k_work *work);
+static void restart_work_handler(struct k_work *work);
+static void disconnect_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(step_work, step_work_handler);
+static K_WORK_DELAYABLE_DEFINE(window_work, window_work_handler);
+static K_WORK_DELAYABLE_DEFINE(restart_work, restart_work_handler);
+static K_WORK_DEFINE(disconnect_work, disconnect_work_handler);
+
+/**
+ * Mean time between advertising events of a schedule entry
+ */
+static uint32_t event_period_us(const struct adv_sched_step *step)
+{
+    return ((uint32_t)step->interval_min + step->interval_max) * 625U / 2U +
+           ADV_DELAY_MEAN_US;
+}
+
+/**
+ * Stop whichever advertiser is running
+ */
+static void stop_advertising(void)
+{
+    if (!advertising) {
+        return;
+    }
+
+    int err = coded_active ? bt_le_ext_adv_stop(coded_set) : bt_le_adv_stop();
+    if (err && err != -EALREADY) {
+        LOG_WRN("Failed to stop advertising (err %d)", err);
+    }
+    advertising = false;
+}
+
+/**
+ * Start extended advertising on the Coded PHY, creating the set on first use
+ */
+static int start_coded(const struct bt_le_adv_param *param)
+{
+    int err;
+
+    if (!coded_set) {
+        err = bt_le_ext_adv_create(param, NULL, &coded_set);
+    } else {
+        err = bt_le_ext_adv_update_param(coded_set, param);
+    }
+    if (err) {
+        return err;
+    }
+
+    err = bt_le_ext_adv_set_data(coded_set, adv_data, adv_data_len, NULL, 0);
+    if (err) {
+        return err;
+    }
+
+    return bt_le_ext_adv_start(coded_set, BT_LE_EXT_ADV_START_DEFAULT);
+}
+
+/**
+ * (Re)start advertising for the current state and mode
+ * Connectable windows in beacon mode always use the normal intervals so the
+ * Host can connect within the window whatever state the schedule is in.
+ */
+static int start_advertising(void)
+{
+    bool connectable = !beacon_mode || window_open;
+    const struct adv_sched_step *step =
+        (beacon_mode && window_open) ? &schedule[ADV_SCHED_NORMAL] : &schedule[state];
+    uint32_t options = connectable ? BT_LE_ADV_OPT_CONN : BT_LE_ADV_OPT_NONE;
+    uint32_t period_us = event_period_us(step);
+    uint32_t charge_factor = 1;
+    int err;
+
+    if (long_range) {
+        options |= BT_LE_ADV_OPT_EXT_ADV | BT_LE_ADV_OPT_CODED;
+#if defined(CONFIG_BT_EXT_ADV_CODING_SELECTION)
+        options |= BT_LE_ADV_OPT_REQUIRE_S8_CODING;
+#endif
+        /* Same event rate, but an S8 event occupies the radio several times longer */
+        charge_factor = ENERGY_CODED_CHARGE_FACTOR;
+    }
+
+    struct bt_le_adv_param param = BT_LE_ADV_PARAM_INIT(
+        options, step->interval_min, step->interval_max, NULL);
+
+    stop_advertising();
+
+    err = long_range ? start_coded(&param)
+                     : bt_le_adv_start(&param, adv_data, adv_data_len, NULL, 0);
+    if (err) {
+        LOG_DBG("Failed to start %s advertising (err %d)", state_names[state], err);
+        energy_model_enter(ENERGY_IDLE, 0);
+        return err;
+    }
+
+    advertising = true;
+    coded_active = long_range;
+
+    if (!connectable) {
+        energy_model_enter_scaled(ENERGY_BEACON, period_us, charge_factor);
+    } else if (beacon_mode) {
+        energy_model_enter_scaled(ENERGY_ADV_NORMAL, period_us, charge_factor);
+    } else {
+        energy_model_enter_scaled((enum energy_state)(ENERGY_ADV_BURST + state), period_us,
+                                  charge_factor);
+    }
+
+    LOG_INF("Advertising %s%s%s: %u-%u ms", state_names[state],
+            connectable ? "" : " (beacon)", long_range ? " on Coded PHY" : "",
+            step->interval_min * 625U / 1000U, step->interval_max * 625U / 1000U);
+
+    return 0;
+}
+
+/**
+ * Enter a schedule state and arm its timers
+ */
+static int enter_state(enum adv_sched_state new_state)
+{
+    const struct adv_sched_step *step = &schedule[new_state];
+
+    state = new_state;
+
+    int err = start_advertising();
+    if (err) {
+        return err;
+    }
+
+    if (step->duration_ms > 0 && state + 1 < ADV_SCHED_STATE_COUNT) {
+        k_work_reschedule(&step_work, K_MSEC(step->duration_ms));
+    } else {
+        k_work_cancel_delayable(&step_work);
+    }
+
+    if (beacon_mode && !k_work_delayable_is_pending(&window_work)) {
+        k_work_reschedule(&window_work, K_MSEC(ADV_SCHED_BEACON_WINDOW_PERIOD_MS));
+    }
+
+    return 0;
+}
+
+/**
+ * Open or close the connectable window in beacon mode
+ */
+static void window_work_handler(struct k_work *work)
+{
+    if (!beacon_mode || connected || restart_pending) {
+        window_open = false;
+        return;
+    }
+
+    window_open = !window_open;
+    start_advertising();
+
+    k_work_reschedule(&window_work,
+                      K_MSEC(window_open ? ADV_SCHED_BEACON_WINDOW_MS :
+                             ADV_SCHED_BEACON_WINDOW_PERIOD_MS - ADV_SCHED_BEACON_WINDOW_MS));
+}
+
+/**
+ * Move one step down the schedule once the current state has timed out
+ */
+static void step_work_handler(struct k_work *work)
+{
+    if (connected || !advertising || state + 1 >= ADV_SCHED_STATE_COUNT) {
+        return;
+    }
+
+    enter_state(state + 1);
+    energy_model_log();
+}
+
+/**
+ * Restart advertising after a disconnect, backing off on failure
+ */
+static void restart_work_handler(struct k_work *work)
+{
+    if (!restart_pending || connected) {
+        restart_pending = false;
+        return;
+    }
+
+    int err = enter_state(ADV_SCHED_BURST);
+    if (err) {
+        restart_stats.retries++;
+        LOG_WRN("Advertising restart failed (err %d), retry in %u ms", err, retry_delay_ms);
+        k_work_reschedule(&restart_work, K_MSEC(retry_delay_ms));
+        retry_delay_ms = MIN(retry_delay_ms * 2U, ADV_SCHED_RETRY_MAX_MS);
+        return;
+    }
+
+    uint32_t latency_ms = (uint32_t)(k_uptime_get() - disconnect_time);
+
+    restart_pending = false;
+    restart_stats.restarts++;
+    restart_stats.last_latency_ms = latency_ms;
+    restart_stats.max_latency_ms = MAX(restart_stats.max_latency_ms, latency_ms);
+    restart_stats.total_latency_ms += latency_ms;
+
+    LOG_INF("Rediscoverable %u ms after disconnect (avg %u ms, max %u ms, %u retries)",
+            latency_ms, restart_stats.total_latency_ms / restart_stats.restarts,
+            restart_stats.max_latency_ms, restart_stats.retries);
+}
+
+/**
+ * Arm the restart state machine (system work queue context)
+ */
+static void disconnect_work_handler(struct k_work *work)
+{
+    restart_pending = true;
+    retry_delay_ms = ADV_SCHED_RETRY_MIN_MS;
+    k_work_reschedule(&restart_work, K_NO_WAIT);
+}
+
+void adv_scheduler_init(const struct bt_data *ad, size_t ad_len)
+{
+    adv_data = ad;
+    adv_data_len = ad_len;
+    state = ADV_SCHED_FAST;
+
+    for (int i = 0; i < ADV_SCHED_STATE_COUNT; i++) {
+        LOG_INF("Schedule %-6s: %u-%u ms for %u ms", state_names[i],
+                schedule[i].interval_min * 625U / 1000U,
+                schedule[i].interval_max * 625U / 1000U,
+                schedule[i].duration_ms);
+    }
+}
+
+int adv_scheduler_set_step(enum adv_sched_state s, const struct adv_sched_step *step)
+{
+    if (s >= ADV_SCHED_STATE_COUNT ||
+        step->interval_min < ADV_SCHED_INT_MIN_ALLOWED ||
+        step->interval_min > step->interval_max) {
+        return -EINVAL;
+    }
+
+    schedule[s] = *step;
+    return 0;
+}
+
+int adv_scheduler_start(void)
+{
+    connected = false;
+    return enter_state(ADV_SCHED_FAST);
+}
+
+void adv_scheduler_stop(void)
+{
+    k_work_cancel_delayable(&step_work);
+    k_work_cancel_delayable(&window_work);
+    window_open = false;
+    k_work_cancel_delayable(&restart_work);
+    restart_pending = false;
+
+    stop_advertising();
+    energy_model_enter(ENERGY_IDLE, 0);
+}
+
+void adv_scheduler_on_connected(uint32_t conn_interval_us)
+{
+    /* The controller stops connectable advertising on connection */
+    k_work_cancel_delayable(&step_work);
+    k_work_cancel_delayable(&window_work);
+    window_open = false;
+    connected = true;
+    advertising = false;
+    state = ADV_SCHED_FAST;
+
+    energy_model_enter(ENERGY_CONNECTED, conn_interval_us);
+}
+
+void adv_scheduler_on_disconnected(void)
+{
+    connected = false;
+    disconnect_time = k_uptime_get();
+    energy_model_enter(ENERGY_IDLE, 0);
+
+    k_work_submit(&disconnect_work);
+}
+
+void adv_scheduler_on_conn_recycled(void)
+{
+    /* A freed connection object is what a -ENOMEM restart was waiting for */
+    if (restart_pending) {
+        k_work_reschedule(&restart_work, K_NO_WAIT);
+    }
+}
+
+void adv_scheduler_get_restart_stats(struct adv_sched_restart_stats *stats)
+{
+    *stats = restart_stats;
+}
+
+int adv_scheduler_set_beacon_mode(bool enable)
+{
+    if (enable == beacon_mode) {
+        return 0;
+    }
+
+    beacon_mode = enable;
+    window_open = false;
+    k_work_cancel_delayable(&window_work);
+
+    LOG_INF("Beacon mode %s", enable ? "enabled" : "disabled");
+
+    if (!advertising) {
+        return 0;
+    }
+
+    if (enable) {
+        k_work_reschedule(&window_work, K_MSEC(ADV_SCHED_BEACON_WINDOW_PERIOD_MS));
+    }
+    return start_advertising();
+}
+
+int adv_scheduler_set_long_range(bool enable)
+{
+    if (enable == long_range) {
+        return 0;
+    }
+
+    LOG_INF("Long-range (Coded PHY) mode %s", enable ? "enabled" : "disabled");
+
+    if (!advertising) {
+        long_range = enable;
+        return 0;
+    }
+
+    /* Stop on the old advertiser before switching */
+    stop_advertising();
+    long_range = enable;
+    return start_advertising();
+}
+
+bool adv_scheduler_is_connectable(void)
+{
+    return advertising && (!beacon_mode || window_open);
+}
+
+int adv_scheduler_update_data(void)
+{
+    if (!advertising) {
+        return 0;
+    }
+
+    if (coded_active) {
+        return bt_le_ext_adv_set_data(coded_set, adv_data, adv_data_len, NULL, 0);
+    }
+    return bt_le_adv_update_data(adv_data, adv_data_len, NULL, 0);
+}
+
+uint32_t adv_scheduler_get_interval_max_ms(void)
+{
+    return schedule[state].interval_max * 625U / 1000U;
+}
+
+uint32_t adv_scheduler_get_interval_ceiling_ms(uint32_t horizon_ms)
+{
+    uint16_t interval_max = schedule[state].interval_max;
+
+    if (beacon_mode) {
+        interval_max = MAX(interval_max, schedule[ADV_SCHED_NORMAL].interval_max);
+    }
+
+    if (state + 1 < ADV_SCHED_STATE_COUNT && k_work_delayable_is_pending(&step_work) &&
+        k_ticks_to_ms_ceil32(k_work_delayable_remaining_get(&step_work)) <= horizon_ms) {
+        interval_max = MAX(interval_max, schedule[state + 1].interval_max);
+    }
+
+    return interval_max * 625U / 1000U;
+}
+
+enum adv_sched_state adv_scheduler_get_state(void)
+{
+    return state;
+}
+
+bool adv_scheduler_is_advertising(void)
+{
+    return advertising;
+}
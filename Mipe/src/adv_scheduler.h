@@ -0,0 +1,191 @@
+/**
+ * Adaptive Advertising Scheduler
+ *
+ * Steps the advertising interval down from fast to normal to slow the longer
+ * the Mipe goes without a connection. Every host request arrives over a
+ * connection, so a connection puts it back into the fast state.
+ *
+ * After a disconnect advertising is restarted from the system work queue,
+ * starting with a short high-duty burst. Failed restarts are retried with
+ * exponential backoff; no Bluetooth callback ever sleeps.
+ *
+ * In beacon mode the Mipe advertises non-connectable (no receive window
+ * after each packet) and only opens a short connectable window, at the
+ * normal interval whatever the schedule state, once per window period. The
+ * Host defers a sync until it sees the window.
+ *
+ * In long-range mode the same schedule runs as extended advertising on the
+ * Coded PHY (S8 coding where the controller supports selecting it).
+ */
+
+#ifndef ADV_SCHEDULER_H
+#define ADV_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+/* Scheduler states, in the order they are stepped through */
+enum adv_sched_state {
+    ADV_SCHED_BURST,
+    ADV_SCHED_FAST,
+    ADV_SCHED_NORMAL,
+    ADV_SCHED_SLOW,
+    ADV_SCHED_STATE_COUNT,
+};
+
+/**
+ * One schedule entry
+ * Intervals are in 0.625 ms units. A duration of 0 keeps the state forever.
+ */
+struct adv_sched_step {
+    uint16_t interval_min;
+    uint16_t interval_max;
+    uint32_t duration_ms;
+};
+
+/* Default schedule */
+#define ADV_SCHED_BURST_INT_MIN     0x0020                      /* 20 ms */
+#define ADV_SCHED_BURST_INT_MAX     0x0020
+#define ADV_SCHED_BURST_DURATION_MS 1000
+
+#define ADV_SCHED_FAST_INT_MIN      BT_GAP_ADV_FAST_INT_MIN_1   /* 30 ms */
+#define ADV_SCHED_FAST_INT_MAX      BT_GAP_ADV_FAST_INT_MAX_1   /* 60 ms */
+#define ADV_SCHED_FAST_DURATION_MS  30000
+
+#define ADV_SCHED_NORMAL_INT_MIN    BT_GAP_ADV_FAST_INT_MIN_2   /* 100 ms */
+#define ADV_SCHED_NORMAL_INT_MAX    BT_GAP_ADV_FAST_INT_MAX_2   /* 150 ms */
+#define ADV_SCHED_NORMAL_DURATION_MS 300000
+
+#define ADV_SCHED_SLOW_INT_MIN      BT_GAP_ADV_SLOW_INT_MIN     /* 1 s */
+#define ADV_SCHED_SLOW_INT_MAX      BT_GAP_ADV_SLOW_INT_MAX     /* 1.2 s */
+#define ADV_SCHED_SLOW_DURATION_MS  0
+
+/* Beacon mode connectable windows */
+#define ADV_SCHED_BEACON_WINDOW_MS          2000
+#define ADV_SCHED_BEACON_WINDOW_PERIOD_MS   30000
+
+/* Shortest interval accepted for connectable legacy advertising */
+#define ADV_SCHED_INT_MIN_ALLOWED   0x0020
+
+/* Restart retry backoff after a failed bt_le_adv_start() */
+#define ADV_SCHED_RETRY_MIN_MS      10
+#define ADV_SCHED_RETRY_MAX_MS      2000
+
+/**
+ * Disconnect-to-rediscoverable latency statistics
+ */
+struct adv_sched_restart_stats {
+    uint32_t restarts;          /* Successful restarts after a disconnect */
+    uint32_t retries;           /* Failed bt_le_adv_start() attempts */
+    uint32_t last_latency_ms;
+    uint32_t max_latency_ms;
+    uint32_t total_latency_ms;
+};
+
+/**
+ * Initialize the scheduler
+ * @param ad Advertising data, must stay valid while advertising
+ * @param ad_len Number of advertising data elements
+ */
+void adv_scheduler_init(const struct bt_data *ad, size_t ad_len);
+
+/**
+ * Replace one schedule entry (applied on the next state entry)
+ * @param state State to configure
+ * @param step New interval range and duration
+ * @return 0 on success, -EINVAL on a bad state or interval range
+ */
+int adv_scheduler_set_step(enum adv_sched_state state, const struct adv_sched_step *step);
+
+/**
+ * Start advertising in the fast state
+ * @return 0 on success, negative error code otherwise
+ */
+int adv_scheduler_start(void);
+
+/**
+ * Stop advertising and the schedule timer
+ */
+void adv_scheduler_stop(void);
+
+/**
+ * Notify the scheduler of a new connection (advertising stops)
+ * @param conn_interval_us Connection interval, for the energy model
+ */
+void adv_scheduler_on_connected(uint32_t conn_interval_us);
+
+/**
+ * Notify the scheduler of a disconnect
+ * Queues the advertising restart (burst state); safe from any callback.
+ */
+void adv_scheduler_on_disconnected(void);
+
+/**
+ * Notify the scheduler that a connection object was freed
+ * Retries a pending restart right away instead of waiting for the backoff.
+ */
+void adv_scheduler_on_conn_recycled(void);
+
+/**
+ * Get disconnect-to-rediscoverable latency statistics
+ * @param stats Destination for the statistics
+ */
+void adv_scheduler_get_restart_stats(struct adv_sched_restart_stats *stats);
+
+/**
+ * Switch between connectable advertising and beacon mode
+ * @param enable true for non-connectable beacons with periodic windows
+ * @return 0 on success, negative error code otherwise
+ */
+int adv_scheduler_set_beacon_mode(bool enable);
+
+/**
+ * Switch between legacy 1M advertising and extended Coded PHY advertising
+ * @param enable true for long-range (Coded PHY) advertising
+ * @return 0 on success, negative error code otherwise
+ */
+int adv_scheduler_set_long_range(bool enable);
+
+/**
+ * Check whether the current advertising accepts connections
+ * @return true if advertising connectable
+ */
+bool adv_scheduler_is_connectable(void);
+
+/**
+ * Push changed advertising data to the controller
+ * The data passed to adv_scheduler_init() has been modified in place.
+ * @return 0 on success (or not advertising), negative error code otherwise
+ */
+int adv_scheduler_update_data(void);
+
+/**
+ * Longest advertising interval of the current state
+ * @return Interval in milliseconds
+ */
+uint32_t adv_scheduler_get_interval_max_ms(void);
+
+/**
+ * Longest advertising interval that may be used within a look-ahead window
+ * Includes a schedule step due within the window and, in beacon mode, the
+ * connectable windows.
+ * @param horizon_ms Look-ahead from now in milliseconds
+ * @return Interval in milliseconds
+ */
+uint32_t adv_scheduler_get_interval_ceiling_ms(uint32_t horizon_ms);
+
+/**
+ * Current scheduler state
+ * @return Scheduler state
+ */
+enum adv_sched_state adv_scheduler_get_state(void);
+
+/**
+ * Check whether advertising is running
+ * @return true if advertising
+ */
+bool adv_scheduler_is_advertising(void);
+
+#endif /* ADV_SCHEDULER_H */
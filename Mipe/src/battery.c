@@ -0,0 +1,214 @@
+/**
+ * Battery Measurement - async oversampled ADC readings with cached result
+ */
+
+#include "battery.h"
+
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/drivers/adc.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(battery, LOG_LEVEL_INF);
+
+#if !DT_NODE_HAS_PROP(DT_PATH(zephyr_user), io_channels)
+#error "Unsupported board: zephyr,user io-channels for the battery ADC is not defined"
+#endif
+
+static const struct adc_dt_spec adc = ADC_DT_SPEC_GET_BY_IDX(DT_PATH(zephyr_user), 0);
+
+/* Single-cell LiPo discharge curve, highest voltage first */
+static const struct {
+    uint16_t millivolts;
+    uint8_t percent;
+} discharge_curve[] = {
+    { 4200, 100 },
+    { 4110, 90 },
+    { 4020, 80 },
+    { 3950, 70 },
+    { 3870, 60 },
+    { 3840, 50 },
+    { 3800, 40 },
+    { 3770, 30 },
+    { 3730, 20 },
+    { 3690, 10 },
+    { 3610, 5 },
+    { 3270, 0 },
+};
+
+/* Cached result: bits 0-15 mV, 16-23 percent, bit 24 valid */
+#define CACHE_VALID BIT(24)
+static atomic_t cache;
+
+static int16_t samples[BATTERY_SAMPLES];
+static atomic_t busy;
+static uint32_t start_cycles;
+static uint32_t conversion_cycles;
+static battery_cb_t measurement_cb;
+
+static void measure_work_handler(struct k_work *work);
+static void publish_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(measure_work, measure_work_handler);
+static K_WORK_DEFINE(publish_work, publish_work_handler);
+
+static enum adc_action sampling_done(const struct device *dev,
+                                     const struct adc_sequence *seq,
+                                     uint16_t sampling_index);
+
+static const struct adc_sequence_options sequence_options = {
+    .interval_us = 0,
+    .callback = sampling_done,
+    .extra_samplings = BATTERY_SAMPLES - 1,
+};
+
+static struct adc_sequence sequence = {
+    .options = &sequence_options,
+    .buffer = samples,
+    .buffer_size = sizeof(samples),
+};
+
+uint8_t battery_mv_to_percent(uint16_t millivolts)
+{
+    if (millivolts >= discharge_curve[0].millivolts) {
+        return discharge_curve[0].percent;
+    }
+
+    for (int i = 1; i < ARRAY_SIZE(discharge_curve); i++) {
+        if (millivolts >= discharge_curve[i].millivolts) {
+            /* Linear interpolation between the two surrounding points */
+            uint32_t span_mv = discharge_curve[i - 1].millivolts - discharge_curve[i].millivolts;
+            uint32_t span_pct = discharge_curve[i - 1].percent - discharge_curve[i].percent;
+            uint32_t above = millivolts - discharge_curve[i].millivolts;
+
+            return discharge_curve[i].percent +
+                   (uint8_t)((above * span_pct + span_mv / 2) / span_mv);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * ADC sampling callback (driver/ISR context)
+ * Averages the burst once the last sample is in and updates the cache.
+ */
+static enum adc_action sampling_done(const struct device *dev,
+                                     const struct adc_sequence *seq,
+                                     uint16_t sampling_index)
+{
+    if (sampling_index < BATTERY_SAMPLES - 1) {
+        return ADC_ACTION_CONTINUE;
+    }
+
+    int32_t sum = 0;
+    for (int i = 0; i < BATTERY_SAMPLES; i++) {
+        sum += MAX(samples[i], 0);
+    }
+
+    /* Convert the sum so the average keeps sub-LSB precision */
+    int32_t sum_mv = sum;
+    if (adc_raw_to_millivolts_dt(&adc, &sum_mv) == 0) {
+        uint32_t adc_mv = ((uint32_t)sum_mv + BATTERY_SAMPLES / 2) / BATTERY_SAMPLES;
+        uint32_t bat_mv = adc_mv * BATTERY_DIVIDER_NUM / BATTERY_DIVIDER_DEN;
+        uint16_t millivolts = (uint16_t)MIN(bat_mv, UINT16_MAX);
+
+        atomic_set(&cache, CACHE_VALID | ((atomic_val_t)battery_mv_to_percent(millivolts) << 16) |
+                           millivolts);
+    }
+
+    conversion_cycles = k_cycle_get_32() - start_cycles;
+    atomic_clear(&busy);
+    k_work_submit(&publish_work);
+
+    return ADC_ACTION_FINISH;
+}
+
+/**
+ * Start one measurement burst and re-arm the timer
+ */
+static void measure_work_handler(struct k_work *work)
+{
+    k_work_reschedule(&measure_work, K_MSEC(BATTERY_MEASURE_INTERVAL_MS));
+
+    /* Never queue behind a conversion that is still running */
+    if (!atomic_cas(&busy, 0, 1)) {
+        LOG_WRN("Previous battery conversion still running, skipped");
+        return;
+    }
+
+    start_cycles = k_cycle_get_32();
+
+    int err = adc_read_async(adc.dev, &sequence, NULL);
+    if (err) {
+        atomic_clear(&busy);
+        LOG_WRN("Battery ADC read failed (err %d)", err);
+    }
+}
+
+/**
+ * Hand a new measurement to the application (system work queue)
+ */
+static void publish_work_handler(struct k_work *work)
+{
+    uint16_t millivolts;
+    uint8_t percent;
+
+    if (battery_get(&millivolts, &percent)) {
+        return;
+    }
+
+    LOG_INF("Battery: %u mV (%u%%), %u samples in %u us", millivolts, percent,
+            BATTERY_SAMPLES, k_cyc_to_us_floor32(conversion_cycles));
+
+    if (measurement_cb) {
+        measurement_cb(millivolts, percent);
+    }
+}
+
+int battery_init(battery_cb_t cb)
+{
+    int err;
+
+    if (!adc_is_ready_dt(&adc)) {
+        LOG_ERR("ADC device not ready");
+        return -ENODEV;
+    }
+
+    err = adc_channel_setup_dt(&adc);
+    if (err < 0) {
+        LOG_ERR("Failed to setup ADC channel: %d", err);
+        return err;
+    }
+
+    /* Fills in channel, resolution and hardware oversampling from devicetree */
+    err = adc_sequence_init_dt(&adc, &sequence);
+    if (err < 0) {
+        LOG_ERR("Failed to init ADC sequence: %d", err);
+        return err;
+    }
+
+    measurement_cb = cb;
+    k_work_reschedule(&measure_work, K_NO_WAIT);
+
+    LOG_INF("Battery measurement every %u s, %u samples averaged",
+            BATTERY_MEASURE_INTERVAL_MS / 1000, BATTERY_SAMPLES);
+    return 0;
+}
+
+int battery_get(uint16_t *millivolts, uint8_t *percent)
+{
+    atomic_val_t value = atomic_get(&cache);
+
+    if (!(value & CACHE_VALID)) {
+        return -ENODATA;
+    }
+
+    if (millivolts) {
+        *millivolts = (uint16_t)(value & 0xFFFF);
+    }
+    if (percent) {
+        *percent = (uint8_t)((value >> 16) & 0xFF);
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * Battery Measurement
+ *
+ * Samples the battery voltage asynchronously on a slow timer. Each
+ * measurement is an averaged burst of (hardware oversampled) ADC samples,
+ * converted in fixed point to millivolts and a state of charge from a
+ * discharge-curve table. Readers only ever see the cached result.
+ */
+
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <stdint.h>
+
+/* Time between measurements */
+#define BATTERY_MEASURE_INTERVAL_MS 60000
+
+/* ADC samples averaged per measurement (each hardware oversampled) */
+#define BATTERY_SAMPLES             8
+
+/* Voltage divider between battery and ADC input: Vbat = Vadc * NUM / DEN */
+#define BATTERY_DIVIDER_NUM         1
+#define BATTERY_DIVIDER_DEN         1
+
+/**
+ * Called from the system work queue after each new measurement
+ * @param millivolts Battery voltage
+ * @param percent State of charge (0-100)
+ */
+typedef void (*battery_cb_t)(uint16_t millivolts, uint8_t percent);
+
+/**
+ * Set up the ADC channel and start periodic measurements
+ * @param cb Measurement callback (may be NULL)
+ * @return 0 on success, negative error code otherwise
+ */
+int battery_init(battery_cb_t cb);
+
+/**
+ * Get the latest measurement without blocking
+ * @param millivolts Battery voltage (may be NULL)
+ * @param percent State of charge (may be NULL)
+ * @return 0 on success, -ENODATA if nothing has been measured yet
+ */
+int battery_get(uint16_t *millivolts, uint8_t *percent);
+
+/**
+ * Convert a battery voltage to state of charge
+ * @param millivolts Battery voltage
+ * @return State of charge (0-100)
+ */
+uint8_t battery_mv_to_percent(uint16_t millivolts);
+
+#endif /* BATTERY_H */
@@ -0,0 +1,250 @@
+/**
+ * Energy Model - per-state time and radio event accounting
+ */
+
+#include "energy_model.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(energy_model, LOG_LEVEL_INF);
+
+static const char *const state_names[ENERGY_STATE_COUNT] = {
+    [ENERGY_ADV_BURST] = "adv burst",
+    [ENERGY_ADV_FAST] = "adv fast",
+    [ENERGY_ADV_NORMAL] = "adv normal",
+    [ENERGY_ADV_SLOW] = "adv slow",
+    [ENERGY_BEACON] = "beacon",
+    [ENERGY_CONNECTED] = "connected",
+    [ENERGY_IDLE] = "idle",
+};
+
+static struct k_spinlock lock;
+static enum energy_state current_state = ENERGY_IDLE;
+static uint32_t current_period_us;
+static uint32_t current_charge_factor = 1;
+static int64_t state_start_ms;
+static uint64_t state_time_ms[ENERGY_STATE_COUNT];
+static uint64_t state_time_us_residue[ENERGY_STATE_COUNT];
+static uint32_t state_events[ENERGY_STATE_COUNT];
+static uint64_t state_charge_nc[ENERGY_STATE_COUNT];
+static uint64_t cpu_cycles_base;
+
+/**
+ * Non-idle CPU cycles since boot (0 without thread usage statistics)
+ */
+static uint64_t cpu_active_cycles(void)
+{
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+    k_thread_runtime_stats_t stats;
+
+    if (k_thread_runtime_stats_all_get(&stats) == 0) {
+        return stats.total_cycles;
+    }
+#endif
+    return 0;
+}
+
+/**
+ * Charge of one radio event in a state
+ */
+static uint32_t event_charge_nc(enum energy_state state)
+{
+    switch (state) {
+    case ENERGY_ADV_BURST:
+    case ENERGY_ADV_FAST:
+    case ENERGY_ADV_NORMAL:
+    case ENERGY_ADV_SLOW:
+        return ENERGY_ADV_EVENT_CHARGE_NC;
+    case ENERGY_BEACON:
+        return ENERGY_BEACON_EVENT_CHARGE_NC;
+    case ENERGY_CONNECTED:
+        return ENERGY_CONN_EVENT_CHARGE_NC;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Radio transmissions and receive windows of one event in a state
+ */
+static void event_packets(enum energy_state state, uint32_t *tx, uint32_t *rx)
+{
+    switch (state) {
+    case ENERGY_ADV_BURST:
+    case ENERGY_ADV_FAST:
+    case ENERGY_ADV_NORMAL:
+    case ENERGY_ADV_SLOW:
+        *tx = ENERGY_ADV_EVENT_TX;
+        *rx = ENERGY_ADV_EVENT_RX;
+        break;
+    case ENERGY_BEACON:
+        *tx = ENERGY_BEACON_EVENT_TX;
+        *rx = 0;
+        break;
+    case ENERGY_CONNECTED:
+        *tx = ENERGY_CONN_EVENT_TX;
+        *rx = ENERGY_CONN_EVENT_RX;
+        break;
+    default:
+        *tx = 0;
+        *rx = 0;
+        break;
+    }
+}
+
+/**
+ * Close the running state interval into the totals (lock held)
+ */
+static void account_current(int64_t now_ms)
+{
+    uint64_t elapsed_ms = (uint64_t)(now_ms - state_start_ms);
+
+    state_time_ms[current_state] += elapsed_ms;
+
+    if (current_period_us > 0) {
+        /* Keep the remainder so short intervals don't lose events */
+        uint64_t elapsed_us = elapsed_ms * 1000U + state_time_us_residue[current_state];
+        uint32_t events = (uint32_t)(elapsed_us / current_period_us);
+
+        state_events[current_state] += events;
+        state_charge_nc[current_state] +=
+            (uint64_t)events * event_charge_nc(current_state) * current_charge_factor;
+        state_time_us_residue[current_state] = elapsed_us % current_period_us;
+    }
+
+    state_start_ms = now_ms;
+}
+
+void energy_model_enter(enum energy_state state, uint32_t event_period_us)
+{
+    energy_model_enter_scaled(state, event_period_us, 1);
+}
+
+void energy_model_enter_scaled(enum energy_state state, uint32_t event_period_us,
+                               uint32_t charge_factor)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    account_current(k_uptime_get());
+    current_state = state;
+    current_period_us = event_period_us;
+    current_charge_factor = charge_factor;
+
+    k_spin_unlock(&lock, key);
+}
+
+void energy_model_reset(void)
+{
+    /* Read outside the lock, the runtime stats take their own */
+    uint64_t cpu_cycles = cpu_active_cycles();
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    state_start_ms = k_uptime_get();
+    for (int i = 0; i < ENERGY_STATE_COUNT; i++) {
+        state_time_ms[i] = 0;
+        state_time_us_residue[i] = 0;
+        state_events[i] = 0;
+        state_charge_nc[i] = 0;
+    }
+    cpu_cycles_base = cpu_cycles;
+
+    k_spin_unlock(&lock, key);
+}
+
+void energy_model_get(struct energy_report *report)
+{
+    uint64_t total_ms = 0;
+    uint64_t cpu_cycles = cpu_active_cycles();
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    account_current(k_uptime_get());
+
+    report->charge_nc = 0;
+    report->tx_packets = 0;
+    report->rx_windows = 0;
+    for (int i = 0; i < ENERGY_STATE_COUNT; i++) {
+        uint32_t tx, rx;
+
+        event_packets(i, &tx, &rx);
+        report->time_ms[i] = state_time_ms[i];
+        report->events[i] = state_events[i];
+        report->charge_nc += state_charge_nc[i];
+        report->tx_packets += state_events[i] * tx;
+        report->rx_windows += state_events[i] * rx;
+        total_ms += state_time_ms[i];
+    }
+    report->cpu_active_ms = k_cyc_to_ms_floor64(cpu_cycles - cpu_cycles_base);
+
+    k_spin_unlock(&lock, key);
+
+    /* nC / ms = uA, so scale by 1000 for nA */
+    report->average_current_na = ENERGY_SLEEP_CURRENT_NA;
+    if (total_ms > 0) {
+        uint64_t cpu_charge_nc = report->cpu_active_ms * ENERGY_CPU_ACTIVE_CURRENT_NA / 1000U;
+
+        report->average_current_na +=
+            (uint32_t)((report->charge_nc + cpu_charge_nc) * 1000U / total_ms);
+    }
+    report->uah_per_day = energy_model_uah_per_day(report->average_current_na);
+}
+
+uint32_t energy_model_project_na(const struct energy_profile *profile)
+{
+    uint64_t current_na = ENERGY_SLEEP_CURRENT_NA;
+
+    for (int i = 0; i < ENERGY_STATE_COUNT; i++) {
+        if (profile->event_period_us[i] == 0) {
+            continue;
+        }
+
+        /* Event charge (nC) per event period (us) gives mA; scale to nA */
+        uint64_t state_na = (uint64_t)event_charge_nc(i) * 1000000U /
+                            profile->event_period_us[i];
+
+        current_na += state_na * profile->share_permille[i] / 1000U;
+    }
+
+    return (uint32_t)current_na;
+}
+
+uint32_t energy_model_lifetime_days(uint32_t average_current_na)
+{
+    if (average_current_na == 0) {
+        return UINT32_MAX;
+    }
+
+    /* mAh * 1e6 = nAh; divide by nA for hours */
+    uint64_t hours = (uint64_t)ENERGY_BATTERY_CAPACITY_MAH * 1000000U / average_current_na;
+
+    return (uint32_t)(hours / 24U);
+}
+
+uint32_t energy_model_uah_per_day(uint32_t average_current_na)
+{
+    /* nA * 24 h = nAh per day; divide by 1000 for uAh */
+    return (uint32_t)((uint64_t)average_current_na * 24U / 1000U);
+}
+
+void energy_model_log(void)
+{
+    struct energy_report report;
+
+    energy_model_get(&report);
+
+    LOG_INF("=== ENERGY MODEL ===");
+    for (int i = 0; i < ENERGY_STATE_COUNT; i++) {
+        LOG_INF("%-10s: %llu ms, %u events", state_names[i],
+                report.time_ms[i], report.events[i]);
+    }
+    LOG_INF("CPU active: %llu ms, radio: %u TX, %u RX windows",
+            report.cpu_active_ms, report.tx_packets, report.rx_windows);
+    LOG_INF("Projected use: %u.%03u mAh/day",
+            report.uah_per_day / 1000U, report.uah_per_day % 1000U);
+    LOG_INF("Average current: %u.%03u uA, projected lifetime %u days (target %u)",
+            report.average_current_na / 1000U, report.average_current_na % 1000U,
+            energy_model_lifetime_days(report.average_current_na),
+            ENERGY_TARGET_LIFETIME_DAYS);
+    LOG_INF("====================");
+}
@@ -0,0 +1,144 @@
+/**
+ * Energy Model
+ *
+ * Tracks time spent in each radio state and estimates the number of radio
+ * events (advertising events, connection events) from the active interval.
+ * A per-event charge and sleep current turn that into an average current,
+ * both for the measured history and for a hypothetical usage profile.
+ * CPU active time (CONFIG_SCHED_THREAD_USAGE_ALL) adds the CPU current.
+ *
+ * The current model values can be overridden with compiler definitions
+ * to evaluate other parts or measured figures without code changes.
+ */
+
+#ifndef ENERGY_MODEL_H
+#define ENERGY_MODEL_H
+
+#include <stdint.h>
+
+/* Radio states */
+enum energy_state {
+    ENERGY_ADV_BURST,
+    ENERGY_ADV_FAST,
+    ENERGY_ADV_NORMAL,
+    ENERGY_ADV_SLOW,
+    ENERGY_BEACON,
+    ENERGY_CONNECTED,
+    ENERGY_IDLE,
+    ENERGY_STATE_COUNT,
+};
+
+/* Current model - nRF54L15 estimates at 0 dBm, adjust to measured values */
+#ifndef ENERGY_SLEEP_CURRENT_NA
+#define ENERGY_SLEEP_CURRENT_NA         3000    /* System ON, RTC/GRTC running */
+#endif
+#ifndef ENERGY_ADV_EVENT_CHARGE_NC
+#define ENERGY_ADV_EVENT_CHARGE_NC      12000   /* Connectable legacy event, 3 channels */
+#endif
+#ifndef ENERGY_BEACON_EVENT_CHARGE_NC
+#define ENERGY_BEACON_EVENT_CHARGE_NC   7000    /* Non-connectable event, no RX windows */
+#endif
+#ifndef ENERGY_CONN_EVENT_CHARGE_NC
+#define ENERGY_CONN_EVENT_CHARGE_NC     4000    /* Empty connection event */
+#endif
+#ifndef ENERGY_CPU_ACTIVE_CURRENT_NA
+#define ENERGY_CPU_ACTIVE_CURRENT_NA    2400000 /* CPU running from RRAM at 128 MHz */
+#endif
+
+/* Charge of a Coded S8 advertising event relative to a 1M legacy event (airtime) */
+#ifndef ENERGY_CODED_CHARGE_FACTOR
+#define ENERGY_CODED_CHARGE_FACTOR      4
+#endif
+
+/* Radio packets per event: TX on each advertising channel, RX windows when connectable */
+#define ENERGY_ADV_EVENT_TX             3
+#define ENERGY_ADV_EVENT_RX             3
+#define ENERGY_BEACON_EVENT_TX          3
+#define ENERGY_CONN_EVENT_TX            1
+#define ENERGY_CONN_EVENT_RX            1
+
+/* Battery used for lifetime projection */
+#ifndef ENERGY_BATTERY_CAPACITY_MAH
+#define ENERGY_BATTERY_CAPACITY_MAH     220
+#endif
+#define ENERGY_TARGET_LIFETIME_DAYS     30
+
+/**
+ * Accumulated time and events per state
+ */
+struct energy_report {
+    uint64_t time_ms[ENERGY_STATE_COUNT];
+    uint32_t events[ENERGY_STATE_COUNT];
+    uint64_t charge_nc;             /* Event charge, excluding sleep current */
+    uint64_t cpu_active_ms;         /* CPU out of idle (0 without thread usage stats) */
+    uint32_t tx_packets;            /* Estimated radio transmissions */
+    uint32_t rx_windows;            /* Estimated radio receive windows */
+    uint32_t average_current_na;    /* Sleep + event charge + CPU over total time */
+    uint32_t uah_per_day;           /* Projected consumption per day */
+};
+
+/**
+ * Usage profile for projections: share of time in each state (per mille)
+ * and the radio event period used in that state
+ */
+struct energy_profile {
+    uint16_t share_permille[ENERGY_STATE_COUNT];
+    uint32_t event_period_us[ENERGY_STATE_COUNT];
+};
+
+/**
+ * Switch the accounted state
+ * @param state New radio state
+ * @param event_period_us Mean time between radio events in that state (0 = none)
+ */
+void energy_model_enter(enum energy_state state, uint32_t event_period_us);
+
+/**
+ * Switch the accounted state with longer (or shorter) radio events
+ * Event and packet counts follow the real period; only the charge of
+ * each event is scaled, e.g. by ENERGY_CODED_CHARGE_FACTOR on the Coded PHY.
+ * @param state New radio state
+ * @param event_period_us Mean time between radio events in that state (0 = none)
+ * @param charge_factor Multiplier of the per-event charge
+ */
+void energy_model_enter_scaled(enum energy_state state, uint32_t event_period_us,
+                               uint32_t charge_factor);
+
+/**
+ * Restart the accounting from now (the current state is kept)
+ */
+void energy_model_reset(void);
+
+/**
+ * Get accumulated time, event counts and average current up to now
+ * @param report Destination for the report
+ */
+void energy_model_get(struct energy_report *report);
+
+/**
+ * Project the average current of a usage profile
+ * @param profile Time shares and event periods
+ * @return Average current in nA
+ */
+uint32_t energy_model_project_na(const struct energy_profile *profile);
+
+/**
+ * Projected battery lifetime for an average current
+ * @param average_current_na Average current in nA
+ * @return Lifetime in days
+ */
+uint32_t energy_model_lifetime_days(uint32_t average_current_na);
+
+/**
+ * Daily consumption for an average current
+ * @param average_current_na Average current in nA
+ * @return Consumption in uAh per day
+ */
+uint32_t energy_model_uah_per_day(uint32_t average_current_na);
+
+/**
+ * Log the accumulated report
+ */
+void energy_model_log(void);
+
+#endif /* ENERGY_MODEL_H */
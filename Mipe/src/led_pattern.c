@@ -0,0 +1,66 @@
+/**
+ * LED Pattern Player - timer-driven flash/solid indication
+ */
+
+#include "led_pattern.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(led_pattern, LOG_LEVEL_INF);
+
+static const struct gpio_dt_spec *led_spec;
+static struct led_pattern active;
+static bool led_on;
+static atomic_t wakeups;
+
+static void led_timer_expiry(struct k_timer *timer);
+K_TIMER_DEFINE(led_timer, led_timer_expiry, NULL);
+
+/**
+ * Timer expiry - toggle the LED and arm the next edge (ISR context)
+ */
+static void led_timer_expiry(struct k_timer *timer)
+{
+    atomic_inc(&wakeups);
+
+    led_on = !led_on;
+    gpio_pin_set_dt(led_spec, led_on);
+
+    uint16_t next_ms = led_on ? active.on_ms : active.period_ms - active.on_ms;
+    k_timer_start(&led_timer, K_MSEC(next_ms), K_NO_WAIT);
+}
+
+void led_pattern_init(const struct gpio_dt_spec *led)
+{
+    led_spec = led;
+    active = LED_PATTERN_OFF;
+    led_on = false;
+}
+
+void led_pattern_set(struct led_pattern pattern)
+{
+    if (pattern.on_ms == active.on_ms && pattern.period_ms == active.period_ms) {
+        return;
+    }
+
+    k_timer_stop(&led_timer);
+    active = pattern;
+
+    if (pattern.on_ms == 0) {
+        led_on = false;
+    } else if (pattern.on_ms >= pattern.period_ms) {
+        led_on = true;
+    } else {
+        /* Start with the flash, then let the timer run the period */
+        led_on = true;
+        k_timer_start(&led_timer, K_MSEC(pattern.on_ms), K_NO_WAIT);
+    }
+
+    gpio_pin_set_dt(led_spec, led_on);
+}
+
+uint32_t led_pattern_get_wakeups(void)
+{
+    return (uint32_t)atomic_get(&wakeups);
+}
@@ -0,0 +1,47 @@
+/**
+ * LED Pattern Player
+ *
+ * Drives an LED from a kernel timer (GRTC on nRF54L) so the application
+ * thread never wakes up for indication. A pattern is an on time within a
+ * period; the timer only fires on the two edges of each period.
+ */
+
+#ifndef LED_PATTERN_H
+#define LED_PATTERN_H
+
+#include <stdint.h>
+#include <zephyr/drivers/gpio.h>
+
+/**
+ * Indication pattern
+ * on_ms == 0 is off, on_ms >= period_ms is solid, anything else flashes.
+ */
+struct led_pattern {
+    uint16_t on_ms;
+    uint16_t period_ms;
+};
+
+#define LED_PATTERN_OFF             ((struct led_pattern){ 0, 0 })
+#define LED_PATTERN_SOLID           ((struct led_pattern){ 1, 1 })
+#define LED_PATTERN_FLASH(on, every) ((struct led_pattern){ (on), (every) })
+
+/**
+ * Initialize the player for an LED
+ * @param led Configured LED output
+ */
+void led_pattern_init(const struct gpio_dt_spec *led);
+
+/**
+ * Switch to a pattern (callable from any context)
+ * Setting the active pattern again keeps its phase.
+ * @param pattern New pattern
+ */
+void led_pattern_set(struct led_pattern pattern);
+
+/**
+ * Number of timer expiries since boot (CPU wakeups caused by the LED)
+ * @return Wakeup count
+ */
+uint32_t led_pattern_get_wakeups(void);
+
+#endif /* LED_PATTERN_H */
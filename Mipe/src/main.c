@@ -3,12 +3,17 @@
  * 
  * Features:
  * - Advertises as "MIPE"
- * - Accepts all connection requests
- * - LED1 flashes 50ms during advertising
+ * - Accepts all connection requests (during connectable windows in beacon mode)
+ * - LED1 flashes 50ms every 2s during advertising (timer driven)
  * - LED1 solid when connected
  * - Returns to advertising when disconnected
  * - Battery service with GATT characteristics
  * - Real battery voltage reading (ADC-based)
+ * - Adaptive advertising interval (fast/normal/slow) with energy model
+ * - Telemetry in manufacturer data (sequence, TX power, battery, uptime)
+ * - Beacon mode: non-connectable with periodic connectable windows
+ * - Optional long-range mode: extended advertising on the Coded PHY (S8)
+ * - Optional periodic advertising train the Host can synchronise to
  */
 
 #include <zephyr/kernel.h>
@@ -17,9 +22,17 @@
 // #include <zephyr/bluetooth/gatt.h>
 // #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/drivers/gpio.h>
-// #include <zephyr/drivers/adc.h>
 #include <zephyr/logging/log.h>
 
+#include "adv_payload.h"
+#include "adv_scheduler.h"
+#include "battery.h"
+#include "energy_model.h"
+#include "led_pattern.h"
+#include "periodic_adv.h"
+#include "sync_service.h"
+#include "uart_cmd.h"
+
 LOG_MODULE_REGISTER(testmipe, LOG_LEVEL_INF);
 
 /* LED definitions - adjust for your board */
@@ -29,13 +42,6 @@ LOG_MODULE_REGISTER(testmipe, LOG_LEVEL_INF);
 #endif
 static const struct gpio_dt_spec led1 = GPIO_DT_SPEC_GET(LED1_NODE, gpios);
 
-/* ADC definitions for battery voltage reading - DISABLED FOR NOW */
-// #define ADC_NODE DT_ALIAS(adc0)
-// #if !DT_NODE_HAS_STATUS(ADC_NODE, okay)
-// #error "Unsupported board: adc0 devicetree alias is not defined"
-// #endif
-// static const struct adc_dt_spec adc = ADC_DT_SPEC_GET(ADC_NODE);
-
 /* Battery service UUIDs - DISABLED FOR NOW */
 // #define BT_UUID_BATTERY_SERVICE BT_UUID_DECLARE_16(0x180F)
 // #define BT_UUID_BATTERY_LEVEL BT_UUID_DECLARE_16(0x2A19)
@@ -43,7 +49,6 @@ static const struct gpio_dt_spec led1 = GPIO_DT_SPEC_GET(LED1_NODE, gpios);
 /* Connection state */
 static struct bt_conn *current_conn = NULL;
 static volatile bool is_connected = false;
-static volatile bool advertising_active = false;
 
 /* Battery level (0-100%) - DISABLED FOR NOW */
 // static uint8_t battery_level = 75; // Default 75%
@@ -51,12 +56,17 @@ static volatile bool advertising_active = false;
 /* Forward declarations */
 static void connected(struct bt_conn *conn, uint8_t err);
 static void disconnected(struct bt_conn *conn, uint8_t reason);
+static void recycled(void);
+static void le_param_updated(struct bt_conn *conn, uint16_t interval,
+                             uint16_t latency, uint16_t timeout);
 // static ssize_t read_battery_level(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset);
 
 /* Connection callbacks */
 BT_CONN_CB_DEFINE(conn_callbacks) = {
     .connected = connected,
     .disconnected = disconnected,
+    .le_param_updated = le_param_updated,
+    .recycled = recycled,
 };
 
 /* GATT Service Definition - DISABLED FOR NOW */
@@ -68,18 +78,70 @@ BT_CONN_CB_DEFINE(conn_callbacks) = {
 //                            read_battery_level, NULL, NULL),
 // );
 
-/* Advertising data - just device name */
-static const struct bt_data ad[] = {
-    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
-    BT_DATA(BT_DATA_NAME_COMPLETE, "MIPE", 4),
+/*
+ * Start in non-connectable beacon mode (connectable windows only). Off by
+ * default: a Host sync or connected measurement then waits up to
+ * ADV_SCHED_BEACON_WINDOW_PERIOD_MS (30 s) for a window instead of
+ * connecting within the 2 s sync budget. Build with it on where the lower
+ * current (see the projection logged at boot) is worth that latency.
+ */
+#ifndef MIPE_BEACON_MODE_DEFAULT
+#define MIPE_BEACON_MODE_DEFAULT false
+#endif
+
+/* Advertise on the Coded PHY for range (needs a Host scanning Coded) */
+#ifndef MIPE_LONG_RANGE_DEFAULT
+#define MIPE_LONG_RANGE_DEFAULT false
+#endif
+
+/* Run a periodic advertising train for synchronised Host sampling */
+#ifndef MIPE_PERIODIC_ADV_DEFAULT
+#define MIPE_PERIODIC_ADV_DEFAULT false
+#endif
+
+/* Energy model report interval while idle */
+#define ENERGY_LOG_INTERVAL_MS 600000
+
+/* Advertising indication: short flash every 2 seconds */
+#define LED_ADV_FLASH_MS 50
+#define LED_ADV_PERIOD_MS 2000
+#define LED_PATTERN_ADVERTISING LED_PATTERN_FLASH(LED_ADV_FLASH_MS, LED_ADV_PERIOD_MS)
+
+/* Wakes the main thread on connection state changes */
+static K_SEM_DEFINE(app_event, 0, 1);
+
+/* Main thread wakeups, compared against the LED timer wakeups */
+static uint32_t app_wakeups = 0;
+
+/* Typical usage profile: mostly idle in slow advertising, a sync every few minutes */
+static const struct energy_profile usage_profile = {
+    .share_permille = {
+        [ENERGY_ADV_FAST] = 20,
+        [ENERGY_ADV_NORMAL] = 150,
+        [ENERGY_ADV_SLOW] = 825,
+        [ENERGY_CONNECTED] = 5,
+    },
+    .event_period_us = {
+        [ENERGY_ADV_FAST] = 50000,
+        [ENERGY_ADV_NORMAL] = 130000,
+        [ENERGY_ADV_SLOW] = 1130000,
+        [ENERGY_CONNECTED] = 7500,
+    },
 };
 
-/* Advertising parameters - fast advertising (100ms intervals) */
-static struct bt_le_adv_param adv_param = BT_LE_ADV_PARAM_INIT(
-    BT_LE_ADV_OPT_CONN,
-    BT_GAP_ADV_FAST_INT_MIN_2,  /* 100ms min */
-    BT_GAP_ADV_FAST_INT_MAX_2,  /* 150ms max */
-    NULL);
+/* Same usage in beacon mode: 2 s connectable window every 30 s */
+static const struct energy_profile beacon_profile = {
+    .share_permille = {
+        [ENERGY_ADV_NORMAL] = 67,
+        [ENERGY_BEACON] = 928,
+        [ENERGY_CONNECTED] = 5,
+    },
+    .event_period_us = {
+        [ENERGY_ADV_NORMAL] = 130000,
+        [ENERGY_BEACON] = 1130000,
+        [ENERGY_CONNECTED] = 7500,
+    },
+};
 
 /**
  * Initialize LED control
@@ -103,72 +165,6 @@ static int led_init(void)
     return 0;
 }
 
-/**
- * Initialize ADC for battery voltage reading - DISABLED FOR NOW
- */
-// static int adc_init(void)
-// {
-//     int ret;
-//     
-//     if (!adc_is_ready_dt(&adc)) {
-//         LOG_ERR("ADC device not ready");
-//         return -ENODEV;
-//     }
-//     
-//     ret = adc_channel_setup_dt(&adc);
-//     if (ret < 0) {
-//         LOG_ERR("Failed to setup ADC channel: %d", ret);
-//         return ret;
-//     }
-//     
-//     LOG_INF("ADC initialized");
-//     return 0;
-// }
-
-/**
- * Read battery voltage and convert to percentage - DISABLED FOR NOW
- */
-// static void read_battery_voltage(void)
-// {
-//     int ret;
-//     uint16_t buf;
-//     struct adc_sequence sequence = {
-//         .buffer = &buf,
-//         .buffer_size = sizeof(buf),
-//     };
-//     
-//     adc_sequence_init_dt(&adc, &sequence);
-//     
-//     ret = adc_read_dt(&adc, &sequence);
-//     if (ret < 0) {
-//         LOG_WRN("Failed to read ADC: %d", ret);
-//         return ret;
-//     }
-//     
-//     /* Convert ADC reading to voltage (assuming 3.3V reference) */
-//     /* This is a simplified conversion - adjust based on your voltage divider */
-//     uint32_t adc_voltage = (uint32_t)buf * 3000 / 4096; // 12-bit ADC
-//     
-//     /* Convert to battery percentage (assuming 3.0V = 0%, 4.2V = 0%) */
-//     if (adc_voltage < 3000) {
-//         battery_level = 0;
-//     } else if (adc_voltage > 4200) {
-//         battery_level = 100;
-//     } else {
-//         battery_level = (uint8_t)((adc_voltage - 3000) * 100 / 1200);
-//     }
-//     
-//     LOG_INF("Battery: %dmV (%d%%)", adc_voltage, battery_level);
-// }
-
-/**
- * Set LED state
- */
-static void led_set(bool state)
-{
-    gpio_pin_set_dt(&led1, state);
-}
-
 /**
  * GATT read callback for battery level - DISABLED FOR NOW
  */
@@ -181,6 +177,14 @@ static void led_set(bool state)
 //     return bt_gatt_attr_read(conn, attr, buf, len, offset, &level, sizeof(level));
 // }
 
+/**
+ * New battery measurement - publish it to the sync service
+ */
+static void battery_updated(uint16_t millivolts, uint8_t percent)
+{
+    sync_service_set_battery(millivolts, percent);
+}
+
 /**
  * Connection established callback
  */
@@ -201,8 +205,28 @@ static void connected(struct bt_conn *conn, uint8_t err)
     current_conn = bt_conn_ref(conn);
     is_connected = true;
     
+    struct bt_conn_info info;
+    uint32_t interval_us = 0;
+    if (bt_conn_get_info(conn, &info) == 0) {
+        interval_us = info.le.interval * 1250U;
+    }
+    adv_scheduler_on_connected(interval_us);
+    
     /* LED solid when connected */
-    led_set(true);
+    led_pattern_set(LED_PATTERN_SOLID);
+    k_sem_give(&app_event);
+}
+
+/**
+ * Connection parameters updated callback
+ */
+static void le_param_updated(struct bt_conn *conn, uint16_t interval,
+                             uint16_t latency, uint16_t timeout)
+{
+    LOG_INF("Connection parameters: interval %u us, latency %u", interval * 1250U, latency);
+    
+    /* Peripheral latency lets the radio skip events */
+    energy_model_enter(ENERGY_CONNECTED, interval * 1250U * (latency + 1U));
 }
 
 /**
@@ -222,35 +246,20 @@ static void disconnected(struct bt_conn *conn, uint8_t reason)
     }
     
     is_connected = false;
-    advertising_active = false;
-    
-    /* Small delay for clean transition */
-    k_msleep(50);
+    led_pattern_set(LED_PATTERN_ADVERTISING);
     
-    /* Restart advertising with proper error handling */
-    int err = bt_le_adv_stop();
-    if (err && err != -EALREADY) {
-        LOG_WRN("Failed to stop advertising (err %d)", err);
-    }
+    /* Restart runs from the work queue - never block the Bluetooth stack here */
+    adv_scheduler_on_disconnected();
     
-    k_msleep(50);
-    
-    err = bt_le_adv_start(&adv_param, ad, ARRAY_SIZE(ad), NULL, 0);
-    if (err) {
-        LOG_ERR("Failed to restart advertising (err %d)", err);
-        /* Try again after a delay */
-        k_msleep(1000);
-        err = bt_le_adv_start(&adv_param, ad, ARRAY_SIZE(ad), NULL, 0);
-        if (err) {
-            LOG_ERR("Second attempt to restart advertising failed (err %d)", err);
-        } else {
-            advertising_active = true;
-            LOG_INF("Advertising restarted (second attempt)");
-        }
-    } else {
-        advertising_active = true;
-        LOG_INF("Advertising restarted");
-    }
+    k_sem_give(&app_event);
+}
+
+/**
+ * Connection object freed callback
+ */
+static void recycled(void)
+{
+    adv_scheduler_on_conn_recycled();
 }
 
 /**
@@ -268,12 +277,7 @@ int main(void)
         LOG_ERR("LED init failed: %d", err);
         return err;
     }
-    
-    /* Initialize ADC - DISABLED FOR NOW */
-    // err = adc_init();
-    // if (err) {
-    //     LOG_WRN("ADC init failed: %d (using default battery level)", err);
-    // }
+    led_pattern_init(&led1);
     
     /* Initialize Bluetooth */
     err = bt_enable(NULL);
@@ -284,48 +288,74 @@ int main(void)
     
     LOG_INF("Bluetooth initialized");
     
-    /* Start advertising */
-    err = bt_le_adv_start(&adv_param, ad, ARRAY_SIZE(ad), NULL, 0);
+    /* Start periodic battery measurement */
+    err = battery_init(battery_updated);
+    if (err) {
+        LOG_WRN("Battery init failed: %d (battery reported as not measured)", err);
+    }
+    
+    /* Report the projected current of the default schedule */
+    uint32_t projected_na = energy_model_project_na(&usage_profile);
+    LOG_INF("Projected average current: %u.%03u uA (%u days on %u mAh)",
+            projected_na / 1000U, projected_na % 1000U,
+            energy_model_lifetime_days(projected_na), ENERGY_BATTERY_CAPACITY_MAH);
+    projected_na = energy_model_project_na(&beacon_profile);
+    LOG_INF("Projected in beacon mode: %u.%03u uA (%u days)",
+            projected_na / 1000U, projected_na % 1000U,
+            energy_model_lifetime_days(projected_na));
+    
+    /* Start advertising with telemetry manufacturer data */
+    size_t ad_len;
+    const struct bt_data *ad = adv_payload_get(&ad_len);
+    
+    adv_payload_init();
+    adv_scheduler_init(ad, ad_len);
+    adv_scheduler_set_beacon_mode(MIPE_BEACON_MODE_DEFAULT);
+    adv_scheduler_set_long_range(MIPE_LONG_RANGE_DEFAULT);
+    err = adv_scheduler_start();
     if (err) {
         LOG_ERR("Advertising failed to start: %d", err);
         return err;
     }
     
-    advertising_active = true;
+    /* The periodic train runs independently of the scheduler, also while connected */
+    if (MIPE_PERIODIC_ADV_DEFAULT) {
+        err = periodic_adv_enable(ad, ad_len, true);
+        if (err) {
+            LOG_WRN("Periodic advertising failed to start: %d", err);
+        }
+    }
+    
+    led_pattern_set(LED_PATTERN_ADVERTISING);
     LOG_INF("Advertising started - Device name: MIPE");
     
-    /* Main control loop */
+    /* Bench builds only: energy report on request over the UART */
+    uart_cmd_start();
+    
+    /* Main control loop - sleeps until a connection event or the energy log */
     while (1) {
-        if (!is_connected) {
-            if (!advertising_active) {
-                /* Try to restart advertising if it stopped */
-                int adv_err = bt_le_adv_start(&adv_param, ad, ARRAY_SIZE(ad), NULL, 0);
-                if (adv_err) {
-                    LOG_WRN("Advertising stopped, restart failed: %d", adv_err);
-                    k_msleep(1000);
-                } else {
-                    advertising_active = true;
-                    LOG_INF("Advertising restarted in main loop");
-                }
-            }
+        k_sem_take(&app_event, K_MSEC(ENERGY_LOG_INTERVAL_MS));
+        app_wakeups++;
+        
+        /* Log measured energy use and wakeup counts */
+        static int64_t last_energy_log = 0;
+        if (k_uptime_get() - last_energy_log >= ENERGY_LOG_INTERVAL_MS) {
+            uint32_t minutes = MAX((uint32_t)(k_uptime_get() / 60000), 1U);
+            uint32_t led_wakeups = led_pattern_get_wakeups();
+            
+            energy_model_log();
+            LOG_INF("Wakeups: app %u, LED %u (%u per minute)", app_wakeups, led_wakeups,
+                    (app_wakeups + led_wakeups) / minutes);
             
-            /* Advertising mode - flash LED for 50ms */
-            led_set(true);
-            k_msleep(50);
-            led_set(false);
-            k_msleep(50);
-        } else {
-            /* Connected mode - LED stays solid */
-            led_set(true);
-            k_msleep(100);
+            struct adv_sched_restart_stats restart;
+            adv_scheduler_get_restart_stats(&restart);
+            if (restart.restarts > 0) {
+                LOG_INF("Re-advertise latency: avg %u ms, max %u ms over %u disconnects",
+                        restart.total_latency_ms / restart.restarts,
+                        restart.max_latency_ms, restart.restarts);
+            }
+            last_energy_log = k_uptime_get();
         }
-        
-        /* Update battery level every 10 seconds - DISABLED FOR NOW */
-        // static uint32_t last_battery_read = 0;
-        // if (k_uptime_get() - last_battery_read > 10000) {
-        //     read_battery_voltage();
-        //     last_battery_read = k_uptime_get();
-        // }
     }
     
     return 0;
@@ -0,0 +1,126 @@
+/**
+ * Periodic Advertising - non-connectable set with a periodic telemetry train
+ */
+
+#include "periodic_adv.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(periodic_adv, LOG_LEVEL_INF);
+
+static struct bt_le_ext_adv *per_set;
+static const struct bt_data *ext_data;
+static size_t ext_data_len;
+static const struct bt_data *per_data;
+static size_t per_data_len;
+static bool running;
+
+/**
+ * Create and configure the set on first use
+ */
+static int create_set(void)
+{
+    const struct bt_le_adv_param param = BT_LE_ADV_PARAM_INIT(
+        BT_LE_ADV_OPT_EXT_ADV | BT_LE_ADV_OPT_USE_TX_POWER,
+        PERIODIC_ADV_EXT_INT_MIN, PERIODIC_ADV_EXT_INT_MAX, NULL);
+    const struct bt_le_per_adv_param per_param = {
+        .interval_min = PERIODIC_ADV_INT_MIN,
+        .interval_max = PERIODIC_ADV_INT_MAX,
+        .options = BT_LE_PER_ADV_OPT_USE_TX_POWER,
+    };
+    int err;
+
+    err = bt_le_ext_adv_create(&param, NULL, &per_set);
+    if (err) {
+        LOG_ERR("Failed to create periodic advertising set (err %d)", err);
+        return err;
+    }
+
+    err = bt_le_per_adv_set_param(per_set, &per_param);
+    if (err) {
+        LOG_ERR("Failed to set periodic advertising parameters (err %d)", err);
+        bt_le_ext_adv_delete(per_set);
+        per_set = NULL;
+        return err;
+    }
+
+    return 0;
+}
+
+int periodic_adv_enable(const struct bt_data *ad, size_t ad_len, bool enable)
+{
+    int err;
+
+    if (enable == running) {
+        return 0;
+    }
+
+    if (!enable) {
+        bt_le_per_adv_stop(per_set);
+        bt_le_ext_adv_stop(per_set);
+        running = false;
+        LOG_INF("Periodic advertising stopped");
+        return 0;
+    }
+
+    ext_data = ad;
+    ext_data_len = ad_len;
+
+    /* Flags are not allowed in periodic advertising data */
+    per_data = ad;
+    per_data_len = ad_len;
+    if (per_data_len > 0 && per_data[0].type == BT_DATA_FLAGS) {
+        per_data++;
+        per_data_len--;
+    }
+
+    if (!per_set) {
+        err = create_set();
+        if (err) {
+            return err;
+        }
+    }
+
+    /* Same elements in the extended advertising so the Host can identify the set */
+    err = bt_le_ext_adv_set_data(per_set, ext_data, ext_data_len, NULL, 0);
+    if (!err) {
+        err = bt_le_per_adv_set_data(per_set, per_data, per_data_len);
+    }
+    if (!err) {
+        err = bt_le_per_adv_start(per_set);
+    }
+    if (!err) {
+        err = bt_le_ext_adv_start(per_set, BT_LE_EXT_ADV_START_DEFAULT);
+    }
+    if (err) {
+        LOG_ERR("Failed to start periodic advertising (err %d)", err);
+        bt_le_per_adv_stop(per_set);
+        return err;
+    }
+
+    running = true;
+    LOG_INF("Periodic advertising started: %u ms interval",
+            PERIODIC_ADV_INT_MIN * 5U / 4U);
+    return 0;
+}
+
+int periodic_adv_update_data(void)
+{
+    if (!running) {
+        return 0;
+    }
+
+    int err = bt_le_per_adv_set_data(per_set, per_data, per_data_len);
+    if (err) {
+        return err;
+    }
+
+    return bt_le_ext_adv_set_data(per_set, ext_data, ext_data_len, NULL, 0);
+}
+
+bool periodic_adv_is_running(void)
+{
+    return running;
+}
@@ -0,0 +1,46 @@
+/**
+ * Periodic Advertising
+ *
+ * Runs a non-connectable extended advertising set with a periodic
+ * advertising train carrying the telemetry payload. A Host synchronised to
+ * the train receives every packet at a known instant instead of relying on
+ * its scan window overlapping an advertisement.
+ */
+
+#ifndef PERIODIC_ADV_H
+#define PERIODIC_ADV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+/* Periodic advertising interval (1.25 ms units) */
+#define PERIODIC_ADV_INT_MIN        160     /* 200 ms */
+#define PERIODIC_ADV_INT_MAX        160
+
+/* Extended advertising interval of the set (only carries the sync info) */
+#define PERIODIC_ADV_EXT_INT_MIN    BT_GAP_ADV_SLOW_INT_MIN
+#define PERIODIC_ADV_EXT_INT_MAX    BT_GAP_ADV_SLOW_INT_MAX
+
+/**
+ * Start or stop the periodic advertising train
+ * @param ad Advertising data for both the extended and periodic advertising
+ * @param ad_len Number of advertising data elements
+ * @param enable true to start, false to stop
+ * @return 0 on success, negative error code otherwise
+ */
+int periodic_adv_enable(const struct bt_data *ad, size_t ad_len, bool enable);
+
+/**
+ * Push changed advertising data to the periodic train
+ * @return 0 on success (or not running), negative error code otherwise
+ */
+int periodic_adv_update_data(void);
+
+/**
+ * Check whether the periodic train is running
+ * @return true if running
+ */
+bool periodic_adv_is_running(void);
+
+#endif /* PERIODIC_ADV_H */
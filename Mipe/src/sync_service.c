@@ -0,0 +1,64 @@
+/**
+ * Mipe Sync Service - battery and clock characteristics for the Host sync
+ */
+
+#include "sync_service.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(sync_service, LOG_LEVEL_INF);
+
+static const struct bt_uuid_128 sync_service_uuid =
+    BT_UUID_INIT_128(BT_UUID_MIPE_SYNC_SERVICE_VAL);
+static const struct bt_uuid_128 sync_battery_uuid =
+    BT_UUID_INIT_128(BT_UUID_MIPE_SYNC_BATTERY_VAL);
+static const struct bt_uuid_128 sync_clock_uuid =
+    BT_UUID_INIT_128(BT_UUID_MIPE_SYNC_CLOCK_VAL);
+
+/* Battery value: no measurement until a battery reading is available */
+static uint8_t battery_value[MIPE_SYNC_BATTERY_LEN];
+
+/**
+ * GATT read callback for the battery characteristic
+ */
+static ssize_t read_battery(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                            void *buf, uint16_t len, uint16_t offset)
+{
+    return bt_gatt_attr_read(conn, attr, buf, len, offset,
+                             battery_value, sizeof(battery_value));
+}
+
+/**
+ * GATT read callback for the clock characteristic
+ */
+static ssize_t read_clock(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                          void *buf, uint16_t len, uint16_t offset)
+{
+    uint8_t clock[MIPE_SYNC_CLOCK_LEN];
+
+    sys_put_le32(k_uptime_get_32(), clock);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, clock, sizeof(clock));
+}
+
+BT_GATT_SERVICE_DEFINE(sync_svc,
+    BT_GATT_PRIMARY_SERVICE(&sync_service_uuid),
+    BT_GATT_CHARACTERISTIC(&sync_battery_uuid.uuid,
+                           BT_GATT_CHRC_READ,
+                           BT_GATT_PERM_READ,
+                           read_battery, NULL, NULL),
+    BT_GATT_CHARACTERISTIC(&sync_clock_uuid.uuid,
+                           BT_GATT_CHRC_READ,
+                           BT_GATT_PERM_READ,
+                           read_clock, NULL, NULL),
+);
+
+void sync_service_set_battery(uint16_t millivolts, uint8_t percent)
+{
+    sys_put_le16(millivolts, &battery_value[0]);
+    battery_value[2] = percent;
+}
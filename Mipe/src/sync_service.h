@@ -0,0 +1,39 @@
+/**
+ * Mipe Sync Service
+ *
+ * Small GATT service read by the Host during a sync transaction.
+ * Both values are fixed length so the Host can fetch them with a single
+ * ATT Read Multiple request using handles cached from an earlier discovery.
+ *
+ * UUIDs and value layouts must match Host/host_device/src/mipe_sync.h
+ */
+
+#ifndef SYNC_SERVICE_H
+#define SYNC_SERVICE_H
+
+#include <zephyr/bluetooth/uuid.h>
+#include <stdint.h>
+
+/* Service UUID: 4d495045-5359-4e43-8000-000000000000 ("MIPE" "SYNC") */
+#define BT_UUID_MIPE_SYNC_SERVICE_VAL \
+    BT_UUID_128_ENCODE(0x4d495045, 0x5359, 0x4e43, 0x8000, 0x000000000000)
+
+/* Battery: uint16 millivolts (LE) + uint8 percent; 0 mV = not measured */
+#define BT_UUID_MIPE_SYNC_BATTERY_VAL \
+    BT_UUID_128_ENCODE(0x4d495045, 0x5359, 0x4e43, 0x8000, 0x000000000001)
+
+/* Clock: uint32 uptime in milliseconds (LE), sampled when the read is served */
+#define BT_UUID_MIPE_SYNC_CLOCK_VAL \
+    BT_UUID_128_ENCODE(0x4d495045, 0x5359, 0x4e43, 0x8000, 0x000000000002)
+
+#define MIPE_SYNC_BATTERY_LEN 3
+#define MIPE_SYNC_CLOCK_LEN   4
+
+/**
+ * Update the battery value served to the Host
+ * @param millivolts Battery voltage in mV (0 = not measured)
+ * @param percent Remaining capacity in percent
+ */
+void sync_service_set_battery(uint16_t millivolts, uint8_t percent);
+
+#endif /* SYNC_SERVICE_H */
@@ -0,0 +1,82 @@
+/**
+ * UART Commands - console line reader
+ */
+
+#include "uart_cmd.h"
+#include "energy_model.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#if MIPE_UART_CMD
+#include <zephyr/console/console.h>
+#endif
+
+LOG_MODULE_REGISTER(uart_cmd, LOG_LEVEL_INF);
+
+#if MIPE_UART_CMD
+#define UART_CMD_STACK_SIZE 1024
+
+static void uart_cmd_thread(void *p1, void *p2, void *p3);
+K_SEM_DEFINE(uart_cmd_start_sem, 0, 1);
+K_THREAD_DEFINE(uart_cmd_tid, UART_CMD_STACK_SIZE, uart_cmd_thread, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+
+/**
+ * Energy report as one CSV line for scripts
+ */
+static void print_energy(void)
+{
+    struct energy_report report;
+
+    energy_model_log();
+    energy_model_get(&report);
+
+    printk("ENERGY");
+    for (int i = 0; i < ENERGY_STATE_COUNT; i++) {
+        printk(",%llu", report.time_ms[i]);
+    }
+    printk(",%llu,%u,%u,%u,%u\n", report.cpu_active_ms, report.tx_packets,
+           report.rx_windows, report.average_current_na, report.uah_per_day);
+}
+
+static void handle_line(const char *line)
+{
+    if (strcmp(line, "energy") == 0) {
+        print_energy();
+    } else if (strcmp(line, "energy reset") == 0) {
+        energy_model_reset();
+        LOG_INF("Energy accounting reset");
+    } else if (strcmp(line, "help") == 0) {
+        LOG_INF("Commands: energy, energy reset, help");
+    } else if (line[0] != '\0') {
+        LOG_WRN("Unknown command: %s", line);
+    }
+}
+
+static void uart_cmd_thread(void *p1, void *p2, void *p3)
+{
+    k_sem_take(&uart_cmd_start_sem, K_FOREVER);
+
+    console_getline_init();
+    LOG_INF("UART commands ready (help)");
+
+    while (1) {
+        char *line = console_getline();
+
+        if (strlen(line) > UART_CMD_MAX_LEN) {
+            LOG_WRN("Command too long");
+            continue;
+        }
+        handle_line(line);
+    }
+}
+#endif
+
+void uart_cmd_start(void)
+{
+#if MIPE_UART_CMD
+    k_sem_give(&uart_cmd_start_sem);
+#endif
+}
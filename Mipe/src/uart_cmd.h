@@ -0,0 +1,28 @@
+/**
+ * UART Commands
+ *
+ * Line commands on the console UART for bench measurements:
+ *   energy        - energy report, also as one CSV line:
+ *                   ENERGY,<ms per state...>,cpu_ms,tx,rx,avg_na,uah_per_day
+ *   energy reset  - restart the energy accounting
+ *   help          - list the commands
+ * Build with -DMIPE_UART_CMD=1 and uart_cmd.conf. Off by default: a UART
+ * receiver kept on costs far more than the tag's average current.
+ */
+
+#ifndef UART_CMD_H
+#define UART_CMD_H
+
+#ifndef MIPE_UART_CMD
+#define MIPE_UART_CMD   0
+#endif
+
+/* Longest accepted command line */
+#define UART_CMD_MAX_LEN    32
+
+/**
+ * Start the command reader thread (no-op unless built with MIPE_UART_CMD)
+ */
+void uart_cmd_start(void);
+
+#endif /* UART_CMD_H */
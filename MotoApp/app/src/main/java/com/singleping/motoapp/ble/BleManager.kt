@@ -6,12 +6,15 @@ import android.bluetooth.BluetoothGatt
 import android.bluetooth.BluetoothGattCharacteristic
 import android.bluetooth.BluetoothManager
 import android.content.Context
+import android.os.SystemClock
 import android.util.Log
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
 import no.nordicsemi.android.ble.BleManager
 import no.nordicsemi.android.ble.data.Data
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import java.util.UUID
 import com.singleping.motoapp.data.MipeStatus
 
@@ -34,22 +37,30 @@ class HostBleManager(context: Context) : BleManager(context) {
         val STATUS_CHAR_UUID: UUID = UUID.fromString("12345678-1234-5678-1234-56789abcdef3")
         val MIPE_STATUS_CHAR_UUID: UUID = UUID.fromString("12345678-1234-5678-1234-56789abcdef4")
         val LOG_DATA_CHAR_UUID: UUID = UUID.fromString("12345678-1234-5678-1234-56789abcdef5")
+        val TIME_SYNC_CHAR_UUID: UUID = UUID.fromString("12345678-1234-5678-1234-56789abcdef6")
+        val PRESENCE_CHAR_UUID: UUID = UUID.fromString("12345678-1234-5678-1234-56789abcdef7")
         
         // Control commands
         const val CMD_START_STREAM: Byte = 0x01
         const val CMD_STOP_STREAM: Byte = 0x02
         const val CMD_GET_STATUS: Byte = 0x03
         const val CMD_MIPE_SYNC: Byte = 0x04
+        const val CMD_TIME_SYNC: Byte = 0x06
+        const val CMD_EPOCH_TIMESTAMPS: Byte = 0x07
+        
+        // RSSI packet length when the Host appends the epoch timestamp
+        private const val RSSI_EPOCH_PACKET_SIZE = 14
     }
     
     // Connection state
     private val _connectionState = MutableStateFlow(false)
     val connectionState: StateFlow<Boolean> = _connectionState.asStateFlow()
     
-    // RSSI data callback
-    var onRssiDataReceived: ((rssi: Int, timestamp: Long) -> Unit)? = null
+    // RSSI data callback (epochMs is the Host-aligned phone time, null if not provided)
+    var onRssiDataReceived: ((rssi: Int, timestamp: Long, epochMs: Long?) -> Unit)? = null
     var onMipeStatusReceived: ((status: MipeStatus) -> Unit)? = null
     var onLogDataReceived: ((log: String) -> Unit)? = null
+    var onPresenceChanged: ((tagId: Int, present: Boolean, timeoutMs: Int) -> Unit)? = null
     
     // GATT characteristics
     private var rssiDataCharacteristic: BluetoothGattCharacteristic? = null
@@ -57,6 +68,14 @@ class HostBleManager(context: Context) : BleManager(context) {
     private var statusCharacteristic: BluetoothGattCharacteristic? = null
     private var mipeStatusCharacteristic: BluetoothGattCharacteristic? = null
     private var logDataCharacteristic: BluetoothGattCharacteristic? = null
+    private var timeSyncCharacteristic: BluetoothGattCharacteristic? = null
+    private var presenceCharacteristic: BluetoothGattCharacteristic? = null
+    
+    // Time sync: monotonic epoch clock with microsecond resolution
+    private val epochBaseUs = System.currentTimeMillis() * 1000 - SystemClock.elapsedRealtimeNanos() / 1000
+    @Volatile private var timeSyncSeq = 0
+    @Volatile private var lastResponseSeq = 0
+    @Volatile private var lastResponseT4Us = 0L
     
     override fun getGattCallback(): BleManagerGattCallback {
         return object : BleManagerGattCallback() {
@@ -72,12 +91,17 @@ class HostBleManager(context: Context) : BleManager(context) {
                     statusCharacteristic = service.getCharacteristic(STATUS_CHAR_UUID)
                     mipeStatusCharacteristic = service.getCharacteristic(MIPE_STATUS_CHAR_UUID)
                     logDataCharacteristic = service.getCharacteristic(LOG_DATA_CHAR_UUID)
+                    // Optional: older Host firmware has no time sync
+                    timeSyncCharacteristic = service.getCharacteristic(TIME_SYNC_CHAR_UUID)
+                    presenceCharacteristic = service.getCharacteristic(PRESENCE_CHAR_UUID)
                     
                     Log.i(TAG, "RSSI Data Characteristic: ${if (rssiDataCharacteristic != null) "FOUND" else "MISSING"}")
                     Log.i(TAG, "Control Characteristic: ${if (controlCharacteristic != null) "FOUND" else "MISSING"}")
                     Log.i(TAG, "Status Characteristic: ${if (statusCharacteristic != null) "FOUND" else "MISSING"}")
                     Log.i(TAG, "Mipe Status Characteristic: ${if (mipeStatusCharacteristic != null) "FOUND" else "MISSING"}")
                     Log.i(TAG, "Log Data Characteristic: ${if (logDataCharacteristic != null) "FOUND" else "MISSING"}")
+                    Log.i(TAG, "Time Sync Characteristic: ${if (timeSyncCharacteristic != null) "FOUND" else "MISSING"}")
+                    Log.i(TAG, "Presence Characteristic: ${if (presenceCharacteristic != null) "FOUND" else "MISSING"}")
                     
                     val allFound = rssiDataCharacteristic != null && 
                            controlCharacteristic != null && 
@@ -100,6 +124,8 @@ class HostBleManager(context: Context) : BleManager(context) {
                 statusCharacteristic = null
                 mipeStatusCharacteristic = null
                 logDataCharacteristic = null
+                timeSyncCharacteristic = null
+                presenceCharacteristic = null
             }
             
             override fun initialize() {
@@ -124,6 +150,21 @@ class HostBleManager(context: Context) : BleManager(context) {
                     }
                     enableNotifications(characteristic).enqueue()
                 }
+
+                timeSyncCharacteristic?.let { characteristic ->
+                    lastResponseT4Us = 0L
+                    setNotificationCallback(characteristic).with { _, data ->
+                        handleTimeSyncResponse(data)
+                    }
+                    enableNotifications(characteristic).enqueue()
+                }
+
+                presenceCharacteristic?.let { characteristic ->
+                    setNotificationCallback(characteristic).with { _, data ->
+                        handlePresenceData(data)
+                    }
+                    enableNotifications(characteristic).enqueue()
+                }
                 
                 // Connection is now ready
                 _connectionState.value = true
@@ -144,11 +185,62 @@ class HostBleManager(context: Context) : BleManager(context) {
             val timestampInt = data.getIntValue(Data.FORMAT_UINT24_LE, 1) ?: 0
             val timestamp = timestampInt.toLong()
             
-            Log.d(TAG, "Received RSSI data: $rssiValue dBm, timestamp: $timestamp")
-            onRssiDataReceived?.invoke(rssiValue, timestamp)
+            // Phone epoch time assigned by the Host (time sync aligned)
+            val epochMs = if (data.size() >= RSSI_EPOCH_PACKET_SIZE) {
+                data.value?.let {
+                    ByteBuffer.wrap(it, 6, 8).order(ByteOrder.LITTLE_ENDIAN).long
+                }
+            } else {
+                null
+            }
+            
+            Log.d(TAG, "Received RSSI data: $rssiValue dBm, timestamp: $timestamp, epoch: $epochMs")
+            onRssiDataReceived?.invoke(rssiValue, timestamp, epochMs)
+        }
+    }
+
+    private fun handlePresenceData(data: Data) {
+        if (data.size() >= 4) {
+            val tagId = data.getIntValue(Data.FORMAT_UINT8, 0) ?: 0
+            val present = (data.getIntValue(Data.FORMAT_UINT8, 1) ?: 0) != 0
+            val timeoutMs = data.getIntValue(Data.FORMAT_UINT16_LE, 2) ?: 0
+            
+            Log.i(TAG, "Tag $tagId ${if (present) "present" else "absent"} (timeout $timeoutMs ms)")
+            onPresenceChanged?.invoke(tagId, present, timeoutMs)
         }
     }
 
+    private fun handleTimeSyncResponse(data: Data) {
+        // T4 first: everything after this adds to the measured round trip
+        val t4Us = nowEpochUs()
+        val bytes = data.value ?: return
+        if (bytes.size < 17) {
+            Log.d(TAG, "Time sync response too small: ${bytes.size} < 17")
+            return
+        }
+        
+        val seq = bytes[0].toInt() and 0xFF
+        if (seq != timeSyncSeq) {
+            Log.d(TAG, "Stale time sync response: seq $seq, expected $timeSyncSeq")
+            return
+        }
+        
+        lastResponseSeq = seq
+        lastResponseT4Us = t4Us
+        
+        val buffer = ByteBuffer.wrap(bytes).order(ByteOrder.LITTLE_ENDIAN)
+        val t2Us = buffer.getLong(1)
+        val t3Us = buffer.getLong(9)
+        Log.d(TAG, "Time sync response: seq $seq, host turnaround ${t3Us - t2Us} us")
+    }
+    
+    /**
+     * Phone epoch time in microseconds (monotonic, unaffected by wall clock changes)
+     */
+    private fun nowEpochUs(): Long {
+        return epochBaseUs + SystemClock.elapsedRealtimeNanos() / 1000
+    }
+
     private fun handleLogData(data: Data) {
         val logString = data.getStringValue(0)
         if (logString != null) {
@@ -275,6 +367,49 @@ class HostBleManager(context: Context) : BleManager(context) {
         }
     }
     
+    /**
+     * Send a time sync request to the host
+     * Carries T1 and the receive time (T4) of the previous response, from which
+     * the Host completes the previous exchange and updates its epoch offset.
+     * @return false if the host has no time sync support
+     */
+    fun sendTimeSync(): Boolean {
+        val characteristic = controlCharacteristic ?: return false
+        if (timeSyncCharacteristic == null) return false
+        
+        val seq = (timeSyncSeq + 1) and 0xFF
+        val payload = ByteBuffer.allocate(19).order(ByteOrder.LITTLE_ENDIAN)
+        payload.put(CMD_TIME_SYNC)
+        payload.put(seq.toByte())
+        payload.putLong(0L) // T1, stamped below
+        payload.put(lastResponseSeq.toByte())
+        payload.putLong(lastResponseT4Us)
+        
+        timeSyncSeq = seq
+        payload.putLong(2, nowEpochUs())
+        writeCharacteristic(
+            characteristic,
+            Data(payload.array()),
+            BluetoothGattCharacteristic.WRITE_TYPE_NO_RESPONSE
+        ).enqueue()
+        return true
+    }
+    
+    /**
+     * Ask the host to append phone epoch timestamps to RSSI data
+     */
+    fun setEpochTimestamps(enable: Boolean) {
+        controlCharacteristic?.let { characteristic ->
+            val data = Data(byteArrayOf(CMD_EPOCH_TIMESTAMPS, if (enable) 1 else 0))
+            writeCharacteristic(
+                characteristic,
+                data,
+                BluetoothGattCharacteristic.WRITE_TYPE_NO_RESPONSE
+            ).enqueue()
+            Log.i(TAG, "Epoch timestamps ${if (enable) "enabled" else "disabled"}")
+        }
+    }
+    
     /**
      * Check if Bluetooth is enabled
      */
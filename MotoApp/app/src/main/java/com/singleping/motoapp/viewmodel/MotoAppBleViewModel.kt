@@ -22,6 +22,11 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
     
     companion object {
         private const val TAG = "MotoAppBleViewModel"
+        
+        // Time sync with the host: a quick burst to fill its filter, then periodic
+        private const val TIME_SYNC_BURST = 4
+        private const val TIME_SYNC_BURST_INTERVAL_MS = 1000L
+        private const val TIME_SYNC_INTERVAL_MS = 10000L
     }
     
     // BLE components
@@ -65,6 +70,12 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
     private var streamingJob: Job? = null
     private var connectionTimeJob: Job? = null
     private var logStatsJob: Job? = null
+    private var timeSyncJob: Job? = null
+    private var reconnectJob: Job? = null
+    
+    // Host to reconnect to after a link loss (null once the user disconnects)
+    private var reconnectDevice: BluetoothDevice? = null
+    private var resumeStreaming = false
     
     init {
         // Set up BLE callbacks
@@ -80,9 +91,9 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
     
     private fun setupBleCallbacks() {
         // Set up RSSI data callback
-        bleManager.onRssiDataReceived = { rssi, timestamp ->
+        bleManager.onRssiDataReceived = { rssi, timestamp, epochMs ->
             viewModelScope.launch {
-                handleRealRssiData(rssi, timestamp)
+                handleRealRssiData(rssi, timestamp, epochMs)
             }
         }
 
@@ -93,6 +104,21 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
             }
         }
 
+        // Presence transitions from the host: clear the reading as soon as the tag is gone
+        bleManager.onPresenceChanged = { tagId, present, timeoutMs ->
+            viewModelScope.launch {
+                if (present) {
+                    _errorMessage.value = "Mipe tag $tagId in range"
+                } else {
+                    _distanceData.value = _distanceData.value.copy(
+                        currentDistance = 0f,
+                        lastUpdated = System.currentTimeMillis()
+                    )
+                    _errorMessage.value = "Mipe tag $tagId lost (no signal for $timeoutMs ms)"
+                }
+            }
+        }
+
         bleManager.onLogDataReceived = { log ->
             viewModelScope.launch {
                 val updatedLogs = (_logHistory.value + log).takeLast(100)
@@ -106,7 +132,9 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
      * Toggle connection
      */
     fun toggleConnection() {
-        if (_connectionState.value.isConnected) {
+        // A pending (re)connection is cancelled like a live link
+        val pending = reconnectDevice != null && _connectionState.value.isConnecting
+        if (_connectionState.value.isConnected || pending) {
             disconnect()
         } else {
             connect()
@@ -164,6 +192,7 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
     private suspend fun connectToDevice(device: BluetoothDevice) {
         try {
             _errorMessage.value = "Connecting to device..."
+            reconnectDevice = device
             
             // Connect using BLE Manager
             bleManager.connect(device)
@@ -195,21 +224,68 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
             // Start updating connection time
             startConnectionTimer()
             
+            // Align the host time base with the phone clock
+            startTimeSync()
+            
+            // Back after a link loss: the host needs START again
+            if (resumeStreaming) {
+                resumeStreaming = false
+                startRealDataStream()
+            }
+            
         } else {
             // Disconnected
+            val wasStreaming = _streamState.value.isStreaming
             _connectionState.value = ConnectionState()
             _streamState.value = StreamState()
             _errorMessage.value = "Disconnected from host"
             connectionTimeJob?.cancel()
+            timeSyncJob?.cancel()
+            
+            // Link lost without the user asking: get the host back
+            reconnectDevice?.let { device ->
+                resumeStreaming = resumeStreaming || wasStreaming
+                reconnect(device)
+            }
+        }
+    }
+    
+    /**
+     * Reconnect after a link loss. With autoConnect Android keeps waiting in
+     * the background until the host advertises again (its directed and fast
+     * reconnect phases), with no timeout.
+     */
+    private fun reconnect(device: BluetoothDevice) {
+        reconnectJob?.cancel()
+        reconnectJob = viewModelScope.launch {
+            try {
+                _connectionState.value = _connectionState.value.copy(isConnecting = true)
+                _errorMessage.value = "Link lost - reconnecting to host..."
+                
+                bleManager.connect(device)
+                    .useAutoConnect(true)
+                    .enqueue()
+                
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to reconnect", e)
+                _errorMessage.value = "Reconnect failed: ${e.message}"
+                _connectionState.value = _connectionState.value.copy(isConnecting = false)
+            }
         }
     }
     
     
     private fun disconnect() {
+        // User disconnect: no automatic reconnect
+        reconnectDevice = null
+        resumeStreaming = false
+        reconnectJob?.cancel()
+        
         // Cancel all jobs
         connectionJob?.cancel()
         streamingJob?.cancel()
         connectionTimeJob?.cancel()
+        timeSyncJob?.cancel()
         
         // Disconnect BLE
         bleScanner.stopScan()
@@ -234,6 +310,24 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
         }
     }
     
+    private fun startTimeSync() {
+        timeSyncJob?.cancel()
+        timeSyncJob = viewModelScope.launch {
+            if (!bleManager.sendTimeSync()) {
+                Log.i(TAG, "Host has no time sync - samples are timestamped on arrival")
+                return@launch
+            }
+            bleManager.setEpochTimestamps(true)
+            
+            var sent = 1
+            while (_connectionState.value.isConnected) {
+                delay(if (sent < TIME_SYNC_BURST) TIME_SYNC_BURST_INTERVAL_MS else TIME_SYNC_INTERVAL_MS)
+                bleManager.sendTimeSync()
+                sent++
+            }
+        }
+    }
+    
     fun toggleDataStream() {
         if (_streamState.value.isStreaming) {
             stopDataStream()
@@ -284,11 +378,11 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
         stopLogging()
     }
     
-    private fun handleRealRssiData(rssi: Int, timestamp: Long) {
-        handleRssiData(rssi.toFloat(), timestamp)
+    private fun handleRealRssiData(rssi: Int, timestamp: Long, epochMs: Long?) {
+        handleRssiData(rssi.toFloat(), timestamp, epochMs)
     }
     
-    private fun handleRssiData(rssiValue: Float, timestamp: Long) {
+    private fun handleRssiData(rssiValue: Float, timestamp: Long, epochMs: Long?) {
         // Add to history (keep last 300 values - 30 seconds at 100ms)
         val newRssiData = RssiData(timestamp, rssiValue)
         val updatedHistory = (_rssiHistory.value + newRssiData).takeLast(300)
@@ -310,12 +404,13 @@ class MotoAppBleViewModel(application: Application) : AndroidViewModel(applicati
         
         // Log the data if streaming is active
         if (_streamState.value.isStreaming) {
-            logData(rssiValue, distance)
+            logData(rssiValue, distance, epochMs ?: System.currentTimeMillis())
         }
     }
     
-    private fun logData(rssi: Float, distance: Float) {
+    private fun logData(rssi: Float, distance: Float, timestamp: Long) {
         val logEntry = LogData(
+            timestamp = timestamp,
             rssi = rssi,
             distance = distance,
             hostInfo = _hostInfo.value,
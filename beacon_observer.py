@@ -0,0 +1,92 @@
+"""
+Passive observer for the Host status beacon.
+
+  python beacon_observer.py [--csv OUT.csv]
+
+Prints every new payload of the non-connectable status beacon (see
+Host/host_device/src/host_beacon.h) without connecting to the Host:
+tag id, filtered RSSI, distance estimate and presence. Several observers
+can run at once next to a connected App.
+
+Manufacturer data (little endian):
+  [company u16][format 0x49][seq u8] then per tag, strongest first
+  [id u8][filtered RSSI i8][distance cm u16][flags u8]
+  (the tag count follows from the length)
+  flags: 0x01 present, 0x02 distance uses the tag's advertised TX power
+
+Needs bleak (pip install bleak).
+"""
+
+import argparse
+import asyncio
+import csv
+import struct
+import time
+
+from bleak import BleakScanner
+
+COMPANY_ID = 0xFFFF
+FORMAT_ID = 0x49
+TAG = struct.Struct("<BbHB")
+FLAG_PRESENT = 0x01
+FLAG_CALIBRATED = 0x02
+
+
+def decode(data):
+    """Return (seq, [(id, rssi, distance_cm, flags)]) or None for other payloads."""
+    if len(data) < 2 or data[0] != FORMAT_ID or (len(data) - 2) % TAG.size:
+        return None
+    count = (len(data) - 2) // TAG.size
+    return data[1], [TAG.unpack_from(data, 2 + i * TAG.size) for i in range(count)]
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--csv", help="write one row per tag and payload")
+    args = parser.parse_args()
+
+    out = open(args.csv, "w", newline="") if args.csv else None
+    writer = csv.writer(out) if out else None
+    if writer:
+        writer.writerow(["time_s", "host", "seq", "tag", "rssi", "distance_cm", "present",
+                         "calibrated"])
+    last_seq = {}
+    start = time.monotonic()
+
+    def on_advertisement(device, adv):
+        # bleak strips the company ID into the dictionary key
+        payload = adv.manufacturer_data.get(COMPANY_ID)
+        decoded = decode(payload) if payload else None
+        if decoded is None:
+            return
+        seq, tags = decoded
+        if last_seq.get(device.address) == seq:
+            return
+        last_seq[device.address] = seq
+
+        now = time.monotonic() - start
+        print("%8.3f %s seq %3u: %s" % (now, device.address, seq, "  ".join(
+            "tag %u %d dBm %.2f m %s" % (tag, rssi, distance / 100.0,
+                                         "PRESENT" if flags & FLAG_PRESENT else "ABSENT")
+            for tag, rssi, distance, flags in tags) or "no tags"))
+        for tag, rssi, distance, flags in tags:
+            if writer:
+                writer.writerow(["%.3f" % now, device.address, seq, tag, rssi, distance,
+                                 int(bool(flags & FLAG_PRESENT)),
+                                 int(bool(flags & FLAG_CALIBRATED))])
+
+    try:
+        async with BleakScanner(on_advertisement):
+            print("Listening for Host status beacons, Ctrl+C to stop")
+            while True:
+                await asyncio.sleep(1.0)
+    finally:
+        if out:
+            out.close()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,138 @@
+"""
+Host event trace to timeline converter.
+
+  python host_trace.py LOG_OR_TRACE_DIR OUT.json [METADATA]
+
+LOG_OR_TRACE_DIR is either a console log holding a TRACE dump (tracing.conf
+build, control command 0x09) or a CTF trace directory written by the POSIX
+backend on native_sim. METADATA is Zephyr's CTF description, by default
+$ZEPHYR_BASE/subsys/tracing/ctf/tsdl/metadata.
+
+OUT.json is a Chrome trace event file (https://ui.perfetto.dev or
+chrome://tracing): one track per thread showing when it ran, an ISR track,
+and the Host named events (mode, scan_report, notify, command, ...) placed
+on the thread that emitted them.
+
+Needs the babeltrace2 Python bindings (python3-bt2).
+"""
+
+import json
+import os
+import shutil
+import sys
+import tempfile
+
+import bt2
+
+ISR_TID = 0
+
+
+def extract_dump(log_path):
+    """Rebuild the RAM trace buffer from TRACE,<offset>,<hex> log lines."""
+    data = None
+    with open(log_path, errors="replace") as f:
+        for line in f:
+            if "TRACE," not in line:
+                continue
+            fields = line[line.index("TRACE,"):].strip().split(",")
+            if fields[1] == "BEGIN":
+                data = bytearray(int(fields[2]))
+            elif fields[1] == "END":
+                if data is not None and len(data) == int(fields[2]):
+                    return bytes(data)
+            elif data is not None and len(fields) == 3:
+                chunk = bytes.fromhex(fields[2])
+                offset = int(fields[1])
+                data[offset:offset + len(chunk)] = chunk
+    sys.exit("%s: no complete TRACE dump found" % log_path)
+
+
+def read_events(trace_dir):
+    """Yield (ns, event name, payload dict); stop at a truncated last event."""
+    try:
+        for msg in bt2.TraceCollectionMessageIterator(trace_dir):
+            if type(msg) is not bt2._EventMessageConst:
+                continue
+            event = msg.event
+            payload = {name: event.payload_field[name] for name in event.payload_field}
+            yield msg.default_clock_snapshot.ns_from_origin, event.name, payload
+    except bt2._Error as err:
+        print("Trace ends early: %s" % str(err).splitlines()[0], file=sys.stderr)
+
+
+def build_timeline(events):
+    trace = []
+    names = {ISR_TID: "ISR"}
+    running = None          # (thread id, start us)
+    isr_start = None
+    current = ISR_TID
+    counts = {}
+
+    for ns, name, payload in events:
+        us = ns / 1000.0
+        counts[name] = counts.get(name, 0) + 1
+
+        if name == "thread_switched_in":
+            current = int(payload["thread_id"])
+            names[current] = str(payload.get("name", "")) or "0x%08x" % current
+            running = (current, us)
+        elif name == "thread_switched_out":
+            tid = int(payload["thread_id"])
+            if running and running[0] == tid:
+                trace.append({"name": names.get(tid, "thread"), "ph": "X", "pid": 1,
+                              "tid": tid, "ts": running[1], "dur": us - running[1]})
+            running = None
+        elif name == "isr_enter":
+            isr_start = us
+        elif name == "isr_exit" and isr_start is not None:
+            trace.append({"name": "ISR", "ph": "X", "pid": 1, "tid": ISR_TID,
+                          "ts": isr_start, "dur": us - isr_start})
+            isr_start = None
+        elif name == "named_event":
+            trace.append({"name": str(payload["name"]), "ph": "i", "s": "t", "pid": 1,
+                          "tid": current, "ts": us,
+                          "args": {"arg0": int(payload["arg0"]),
+                                   "arg1": int(payload["arg1"])}})
+
+    for tid, name in names.items():
+        trace.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid,
+                      "args": {"name": name}})
+    trace.append({"name": "process_name", "ph": "M", "pid": 1,
+                  "args": {"name": "Host (nRF54L15)"}})
+    return trace, counts
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        sys.exit(__doc__)
+    source, out_path = sys.argv[1], sys.argv[2]
+
+    if os.path.isdir(source):
+        trace_dir, tmp = source, None
+    else:
+        metadata = sys.argv[3] if len(sys.argv) == 4 else os.path.join(
+            os.environ.get("ZEPHYR_BASE", ""), "subsys/tracing/ctf/tsdl/metadata")
+        if not os.path.isfile(metadata):
+            sys.exit("CTF metadata not found: %s (pass it or set ZEPHYR_BASE)" % metadata)
+        tmp = tempfile.mkdtemp(prefix="host_trace_")
+        shutil.copy(metadata, os.path.join(tmp, "metadata"))
+        with open(os.path.join(tmp, "channel0_0"), "wb") as f:
+            f.write(extract_dump(source))
+        trace_dir = tmp
+
+    try:
+        trace, counts = build_timeline(read_events(trace_dir))
+    finally:
+        if tmp:
+            shutil.rmtree(tmp)
+
+    with open(out_path, "w") as f:
+        json.dump({"traceEvents": trace, "displayTimeUnit": "ms"}, f)
+
+    print("%s: %d timeline entries" % (out_path, len(trace)))
+    for name in sorted(counts):
+        print("  %-24s %d" % (name, counts[name]))
+
+
+if __name__ == "__main__":
+    main()
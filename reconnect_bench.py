@@ -0,0 +1,133 @@
+"""
+App reconnection benchmark: a PC plays the phone.
+
+  python reconnect_bench.py [--cycles N] [--hold S] [--pair] [--csv OUT.csv]
+
+Each cycle connects to the Host, subscribes to RSSI data, sends START and
+waits for the first notification, holds the link for --hold seconds and
+drops it, then reconnects at once, as a phone coming back into range
+would. Per cycle it measures:
+  connect_ms        disconnection to connection (Host re-advertising latency)
+  first_notify_ms   connection to first RSSI notification
+and prints their distributions in the Host histogram buckets. With --pair
+the PC bonds on the first cycle, so later cycles exercise the directed
+advertising phase and the GATT cache (clear bonds on the Host with control
+command 0x0A to measure the unbonded case). The Host logs its own view as
+RECONNECT,<phase>,<latency_ms> lines.
+
+Needs bleak (pip install bleak) and a Mipe tag in range for notifications.
+"""
+
+import argparse
+import asyncio
+import csv
+import statistics
+import sys
+import time
+
+from bleak import BleakClient, BleakScanner
+
+HOST_NAME = "MIPE_HOST_A1B2"
+RSSI_DATA_UUID = "12345678-1234-5678-1234-56789abcdef1"
+CONTROL_UUID = "12345678-1234-5678-1234-56789abcdef2"
+CMD_START_STREAM = 0x01
+
+# Same upper bucket edges as APP_RECONNECT_BUCKETS in app_reconnect.h
+BUCKETS = [100, 200, 500, 1000, 2000, 5000, 10000, 30000]
+
+CONNECT_TIMEOUT_S = 40.0
+NOTIFY_TIMEOUT_S = 10.0
+
+
+async def run_cycle(address, pair, disconnected_at):
+    """Connect, stream until the first notification; return (client, connect_ms, notify_ms)."""
+    first = asyncio.Event()
+    client = BleakClient(address, timeout=CONNECT_TIMEOUT_S)
+
+    await client.connect()
+    connected_at = time.monotonic()
+    connect_ms = (connected_at - disconnected_at) * 1000 if disconnected_at else None
+
+    if pair:
+        await client.pair()
+
+    await client.start_notify(RSSI_DATA_UUID, lambda _char, _data: first.set())
+    await client.write_gatt_char(CONTROL_UUID, bytes([CMD_START_STREAM]), response=True)
+    try:
+        await asyncio.wait_for(first.wait(), NOTIFY_TIMEOUT_S)
+        notify_ms = (time.monotonic() - connected_at) * 1000
+    except asyncio.TimeoutError:
+        notify_ms = None
+
+    return client, connect_ms, notify_ms
+
+
+def histogram(values):
+    counts = [0] * (len(BUCKETS) + 1)
+    for value in values:
+        counts[sum(1 for edge in BUCKETS if value >= edge)] += 1
+    labels = ["<%d" % edge for edge in BUCKETS] + [">=%d" % BUCKETS[-1]]
+    return "  ".join("%s:%d" % (label, n) for label, n in zip(labels, counts) if n)
+
+
+def summary(name, values):
+    values = [v for v in values if v is not None]
+    if not values:
+        print("%-16s no samples" % name)
+        return
+    values.sort()
+    p90 = values[min(len(values) - 1, int(len(values) * 0.9))]
+    print("%-16s n=%d min=%.0f median=%.0f p90=%.0f max=%.0f ms" %
+          (name, len(values), values[0], statistics.median(values), p90, values[-1]))
+    print("%-16s %s" % ("", histogram(values)))
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--cycles", type=int, default=20)
+    parser.add_argument("--hold", type=float, default=2.0, help="seconds connected per cycle")
+    parser.add_argument("--pair", action="store_true", help="bond on the first cycle")
+    parser.add_argument("--csv", help="write per-cycle results")
+    args = parser.parse_args()
+
+    device = await BleakScanner.find_device_by_name(HOST_NAME, timeout=20.0)
+    if device is None:
+        sys.exit("%s not found" % HOST_NAME)
+
+    rows = []
+    disconnected_at = None
+    for cycle in range(args.cycles + 1):
+        try:
+            client, connect_ms, notify_ms = await run_cycle(
+                device.address, args.pair and cycle == 0, disconnected_at)
+        except Exception as err:  # bleak raises backend-specific errors
+            print("cycle %d: %s" % (cycle, err))
+            disconnected_at = None
+            continue
+
+        # Cycle 0 only sets up the link (and the bond)
+        if cycle > 0:
+            rows.append((cycle, connect_ms, notify_ms))
+            print("cycle %d: connect %s ms, first notification %s ms" %
+                  (cycle, "-" if connect_ms is None else "%.0f" % connect_ms,
+                   "-" if notify_ms is None else "%.0f" % notify_ms))
+
+        await asyncio.sleep(args.hold)
+        await client.disconnect()
+        disconnected_at = time.monotonic()
+
+    print()
+    summary("connect_ms", [r[1] for r in rows])
+    summary("first_notify_ms", [r[2] for r in rows])
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(["cycle", "connect_ms", "first_notify_ms"])
+            for cycle, connect_ms, notify_ms in rows:
+                writer.writerow([cycle] + ["" if v is None else "%.1f" % v
+                                           for v in (connect_ms, notify_ms)])
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
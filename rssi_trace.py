@@ -0,0 +1,220 @@
+"""
+RSSI trace capture and replay for the Host device.
+
+  capture PORT FILE            Record the frames of a capture build
+                               (capture.conf) until Ctrl+C. Log text is
+                               printed as usual.
+  dump FILE                    Print a recording as CSV.
+  replay PORT FILE [OUT.csv]   Send a recording to a replay build
+                               (replay.conf). The notifications the App
+                               would have received are written as CSV,
+                               then the per-stage timing is printed.
+
+Frame format (see Host/host_device/src/rssi_trace.h):
+  [0xA5][0x5A][len][body][crc8]
+  body: timestamp_ms u32, addr type, addr[6], rssi i8, adv type, phy, flags,
+        telemetry seq, tx_power i8, battery, uptime_s u32
+  crc8: CRC-8/CCITT (poly 0x07, init 0xFF) over len and body
+A recording is b"RTR1" followed by the frames as received. Recordings made
+before the telemetry fields (15 byte bodies) still dump and replay.
+"""
+
+import struct
+import sys
+import time
+
+import serial
+
+SYNC = b"\xa5\x5a"
+BODY_LENS = (22, 15)
+FILE_MAGIC = b"RTR1"
+ACK_FRAMES = 32
+ACK_TIMEOUT_S = 5.0
+
+ADV_TYPES = {0x00: "ADV_IND", 0x02: "ADV_SCAN_IND", 0x03: "ADV_NONCONN_IND",
+             0x05: "EXT_ADV", 0xF0: "PERIODIC"}
+PHYS = {0: "none", 1: "1M", 2: "2M", 4: "Coded"}
+
+
+def crc8_ccitt(data, crc=0xFF):
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def make_frame(body):
+    head = bytes([len(body)]) + body
+    return SYNC + head + bytes([crc8_ccitt(head)])
+
+
+def decode_body(body):
+    ts, addr_type = struct.unpack_from("<IB", body, 0)
+    addr = ":".join("%02X" % b for b in reversed(body[5:11]))
+    rssi, adv_type, phy, flags = struct.unpack_from("<bBBB", body, 11)
+    telemetry = None
+    if len(body) >= 22 and flags & 0x02:
+        telemetry = struct.unpack_from("<BbBI", body, 15)
+    return ts, addr, addr_type, rssi, adv_type, phy, bool(flags & 0x01), telemetry
+
+
+class FrameParser:
+    """Split a UART byte stream into frames and log text."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.text = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data):
+        """Return (frames, text lines) completed by data."""
+        self.buf += data
+        frames, lines = [], []
+        while True:
+            start = self.buf.find(SYNC)
+            if start < 0:
+                # Keep a trailing first sync byte for the next read
+                keep = 1 if self.buf.endswith(SYNC[:1]) else 0
+                self.text += self.buf[:len(self.buf) - keep]
+                del self.buf[:len(self.buf) - keep]
+                break
+            self.text += self.buf[:start]
+            del self.buf[:start]
+            if len(self.buf) < 3:
+                break
+            length = self.buf[2]
+            if length not in BODY_LENS:
+                del self.buf[:1]
+                continue
+            if len(self.buf) < length + 4:
+                break
+            frame = bytes(self.buf[:length + 4])
+            if crc8_ccitt(frame[2:-1]) == frame[-1]:
+                frames.append(frame)
+                del self.buf[:len(frame)]
+            else:
+                self.crc_errors += 1
+                del self.buf[:1]
+        while b"\n" in self.text:
+            line, _, rest = self.text.partition(b"\n")
+            lines.append(line.decode(errors="replace").rstrip("\r"))
+            self.text = bytearray(rest)
+        return frames, lines
+
+
+def read_recording(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(FILE_MAGIC):
+        sys.exit("%s: not an RSSI trace recording" % path)
+    frames, _ = FrameParser().feed(data[len(FILE_MAGIC):])
+    return frames
+
+
+def capture(port, path, baud=115200):
+    parser = FrameParser()
+    count = 0
+    with serial.Serial(port, baud, timeout=0.1) as ser, open(path, "wb") as out:
+        out.write(FILE_MAGIC)
+        print("Capturing from %s to %s (Ctrl+C to stop)" % (port, path))
+        try:
+            while True:
+                frames, lines = parser.feed(ser.read(4096))
+                for frame in frames:
+                    out.write(frame)
+                count += len(frames)
+                for line in lines:
+                    print(line)
+        except KeyboardInterrupt:
+            pass
+    print("\n%d frames captured, %d damaged frames skipped" % (count, parser.crc_errors))
+
+
+def dump(path):
+    print("time_ms,addr,addr_type,rssi,adv_type,phy,connectable,seq,tx_power,battery,uptime_s")
+    for frame in read_recording(path):
+        ts, addr, addr_type, rssi, adv_type, phy, conn, telemetry = decode_body(frame[3:-1])
+        print("%u,%s,%u,%d,%s,%s,%d,%s" % (ts, addr, addr_type, rssi,
+                                           ADV_TYPES.get(adv_type, adv_type),
+                                           PHYS.get(phy, phy), conn,
+                                           ",".join(map(str, telemetry)) if telemetry else ",,,"))
+
+
+def replay(port, path, out_path=None, baud=115200):
+    frames = read_recording(path)
+    if not frames:
+        sys.exit("%s: no frames" % path)
+
+    parser = FrameParser()
+    notifications = []
+    done = None
+    acked = 0
+
+    def poll(ser, until):
+        nonlocal acked, done
+        while time.monotonic() < until:
+            _, lines = parser.feed(ser.read(4096))
+            progress = False
+            for line in lines:
+                if "REPLAY," not in line:
+                    continue
+                fields = line[line.index("REPLAY,"):].split(",")
+                if fields[1] == "NOTIFY":
+                    notifications.append(fields[2:6])
+                elif fields[1] == "ACK":
+                    acked = int(fields[2])
+                    progress = True
+                elif fields[1] == "DONE":
+                    done = dict(f.split("=") for f in fields[2:])
+                    progress = True
+            if progress:
+                return True
+        return False
+
+    with serial.Serial(port, baud, timeout=0.05) as ser:
+        ser.reset_input_buffer()
+        sent = 0
+        # Send one acknowledge window at a time so the Host never overruns
+        while sent < len(frames):
+            block = frames[sent:sent + ACK_FRAMES]
+            ser.write(b"".join(block))
+            sent += len(block)
+            if len(block) == ACK_FRAMES:
+                while acked < sent:
+                    if not poll(ser, time.monotonic() + ACK_TIMEOUT_S):
+                        sys.exit("No acknowledge after frame %d (replay build running?)" % sent)
+        ser.write(make_frame(b""))
+        while done is None:
+            if not poll(ser, time.monotonic() + ACK_TIMEOUT_S):
+                sys.exit("No replay summary from the Host")
+
+    out = open(out_path, "w") if out_path else sys.stdout
+    out.write("time_ms,tag,rssi,phy\n")
+    for row in notifications:
+        out.write(",".join(row) + "\n")
+    if out_path:
+        out.close()
+
+    print("Replayed %d frames: %s notifications over %s ms of trace in %s ms (x%s)" % (
+        len(frames), done["notifications"], done["virtual_ms"], done["wall_ms"],
+        done["speedup"]), file=sys.stderr)
+    print("  report (scan callback):   avg %s ns, max %s ns" % (
+        done["report_avg_ns"], done["report_max_ns"]), file=sys.stderr)
+    print("  packetizer (stream tick): avg %s ns, max %s ns" % (
+        done["stream_avg_ns"], done["stream_max_ns"]), file=sys.stderr)
+    if done["crc_errors"] != "0" or done["overruns"] != "0":
+        print("  WARNING: %s damaged frames, %s UART overruns on the Host" % (
+            done["crc_errors"], done["overruns"]), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    if len(args) == 3 and args[0] == "capture":
+        capture(args[1], args[2])
+    elif len(args) == 2 and args[0] == "dump":
+        dump(args[1])
+    elif len(args) in (3, 4) and args[0] == "replay":
+        replay(*args[1:])
+    else:
+        sys.exit(__doc__)
@@ -0,0 +1,254 @@
+"""
+Binary telemetry decoder for the Host device.
+
+  capture PORT OUTDIR [--baud N] [--format csv|parquet]
+        Record a HOST_TELEMETRY build (telemetry.overlay) until Ctrl+C.
+        The raw stream is kept in OUTDIR/raw.bin next to the decoded files.
+  decode RAW OUTDIR [--format csv|parquet]
+        Decode a raw stream saved by capture (or any UART log of one).
+
+Decoded records go to samples, events and metrics tables in OUTDIR, as CSV
+or, with pyarrow installed, Parquet written in row groups so hours of data
+never sit in memory.
+
+Frame format (see Host/host_device/src/host_telemetry.h):
+  0x00 COBS([type][seq u16][timestamp_ms u32][body][crc16]) 0x00
+  crc16: CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over type to body
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+
+SAMPLE, EVENT, METRICS = 0x01, 0x02, 0x03
+HEADER = struct.Struct("<BHI")
+
+SOURCES = {0: "scan", 1: "periodic", 2: "conn"}
+PHYS = {0: "none", 1: "1M", 2: "2M", 4: "Coded"}
+EVENTS = {1: "mode", 2: "app_link", 3: "mipe_link", 4: "presence"}
+
+COLUMNS = {
+    "samples": ["timestamp_ms", "seq", "source", "addr", "addr_type", "rssi", "phy",
+                "tag_seq", "connectable"],
+    "events": ["timestamp_ms", "seq", "event", "arg0", "arg1"],
+    "metrics": ["timestamp_ms", "seq", "discovery_ms", "rediscovery_ms", "app_connect_ms",
+                "app_reconnect_ms", "samples_sent", "samples_per_s_x10", "loss_permille",
+                "latency_avg_ms", "latency_max_ms", "failures", "average_current_na",
+                "dropped"],
+}
+
+ROW_GROUP = 10000
+
+
+def crc16_ccitt_false(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_record(record):
+    """Return (table, row) or None for an unknown record."""
+    rtype, seq, ts = HEADER.unpack_from(record, 0)
+    body = record[HEADER.size:]
+
+    if rtype == SAMPLE and len(body) == 12:
+        source, addr_type = body[0], body[1]
+        addr = ":".join("%02X" % b for b in reversed(body[2:8]))
+        rssi, phy, tag_seq, flags = struct.unpack_from("<bBBB", body, 8)
+        return "samples", [ts, seq, SOURCES.get(source, source), addr, addr_type, rssi,
+                           PHYS.get(phy, phy), tag_seq if flags & 0x02 else None,
+                           bool(flags & 0x01)]
+    if rtype == EVENT and len(body) == 9:
+        event, arg0, arg1 = struct.unpack("<BII", body)
+        return "events", [ts, seq, EVENTS.get(event, event), arg0, arg1]
+    if rtype == METRICS and len(body) == 48:
+        return "metrics", [ts, seq] + list(struct.unpack("<12I", body))
+    return None
+
+
+class Decoder:
+    """Split a byte stream on 0x00 and check each frame."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.last_seq = None
+        self.records = 0
+        self.crc_errors = 0
+        self.lost = 0
+
+    def feed(self, data):
+        """Yield (table, row) for every good record completed by data."""
+        self.buf += data
+        while True:
+            end = self.buf.find(b"\x00")
+            if end < 0:
+                return
+            frame = bytes(self.buf[:end])
+            del self.buf[:end + 1]
+            if not frame:
+                continue
+
+            record = cobs_decode(frame)
+            if (record is None or len(record) < HEADER.size + 2 or
+                    crc16_ccitt_false(record[:-2]) != struct.unpack("<H", record[-2:])[0]):
+                # Also log text sharing the console UART
+                self.crc_errors += 1
+                continue
+
+            decoded = decode_record(record[:-2])
+            if decoded is None:
+                continue
+
+            seq = decoded[1][1]
+            if self.last_seq is not None:
+                self.lost += (seq - self.last_seq - 1) & 0xFFFF
+            self.last_seq = seq
+            self.records += 1
+            yield decoded
+
+
+class CsvTable:
+    def __init__(self, path, columns):
+        self.file = open(path + ".csv", "w", newline="")
+        self.writer = csv.writer(self.file)
+        self.writer.writerow(columns)
+        self.rows = 0
+
+    def write(self, row):
+        self.writer.writerow(["" if v is None else v for v in row])
+        self.rows += 1
+        if self.rows % ROW_GROUP == 0:
+            self.file.flush()
+
+    def close(self):
+        self.file.close()
+
+
+class ParquetTable:
+    def __init__(self, path, columns):
+        import pyarrow
+        import pyarrow.parquet
+        self.pa = pyarrow
+        self.columns = columns
+        self.path = path + ".parquet"
+        self.pending = []
+        self.writer = None
+        self.rows = 0
+
+    def write(self, row):
+        self.pending.append(row)
+        self.rows += 1
+        if len(self.pending) >= ROW_GROUP:
+            self.flush()
+
+    def flush(self):
+        if not self.pending:
+            return
+        table = self.pa.table({name: [row[i] for row in self.pending]
+                               for i, name in enumerate(self.columns)})
+        if self.writer is None:
+            self.writer = self.pa.parquet.ParquetWriter(self.path, table.schema)
+        self.writer.write_table(table.cast(self.writer.schema))
+        self.pending = []
+
+    def close(self):
+        self.flush()
+        if self.writer:
+            self.writer.close()
+
+
+def open_tables(out_dir, fmt):
+    os.makedirs(out_dir, exist_ok=True)
+    table_cls = ParquetTable if fmt == "parquet" else CsvTable
+    return {name: table_cls(os.path.join(out_dir, name), columns)
+            for name, columns in COLUMNS.items()}
+
+
+def run(chunks, out_dir, fmt, raw=None):
+    decoder = Decoder()
+    tables = open_tables(out_dir, fmt)
+    try:
+        for data in chunks:
+            if raw:
+                raw.write(data)
+            for table, row in decoder.feed(data):
+                tables[table].write(row)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        for table in tables.values():
+            table.close()
+
+    print("%d records (%s), %d lost on the Host (sequence gaps), %d bad frames" %
+          (decoder.records,
+           ", ".join("%s %d" % (name, t.rows) for name, t in tables.items()),
+           decoder.lost, decoder.crc_errors))
+
+
+def serial_chunks(port, baud):
+    import serial
+    with serial.Serial(port, baud, timeout=0.1) as ser:
+        print("Capturing from %s at %d baud, Ctrl+C to stop" % (port, baud))
+        while True:
+            data = ser.read(4096)
+            if data:
+                yield data
+
+
+def file_chunks(path):
+    with open(path, "rb") as f:
+        while True:
+            data = f.read(1 << 16)
+            if not data:
+                return
+            yield data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+    capture = sub.add_parser("capture")
+    capture.add_argument("port")
+    capture.add_argument("out_dir")
+    capture.add_argument("--baud", type=int, default=1000000)
+    decode = sub.add_parser("decode")
+    decode.add_argument("raw")
+    decode.add_argument("out_dir")
+    for cmd in (capture, decode):
+        cmd.add_argument("--format", choices=("csv", "parquet"), default="csv")
+    args = parser.parse_args()
+
+    if args.format == "parquet":
+        try:
+            import pyarrow.parquet  # noqa: F401
+        except ImportError:
+            sys.exit("Parquet output needs pyarrow (pip install pyarrow)")
+
+    if args.command == "capture":
+        os.makedirs(args.out_dir, exist_ok=True)
+        with open(os.path.join(args.out_dir, "raw.bin"), "wb") as raw:
+            run(serial_chunks(args.port, args.baud), args.out_dir, args.format, raw)
+    else:
+        run(file_chunks(args.raw), args.out_dir, args.format)
+
+
+if __name__ == "__main__":
+    main()